@@ -23,8 +23,27 @@
 #include "Injection.h"
 #include "Load.h"
 #include "Events.h"
+#include "progmemArray.h"
+#include "packedArray12.h"
+#include "avrMul.h"
+#include "armDsp.h"
+#include "kernelTraits.h"
 #include "interpolateLinear.h"
+#include "uniformScale.h"
 #include "interpolateBilinear.h"
+#include "interpolateMultilinear.h"
+#include "table.h"
+#include "cachedTable.h"
+#include "doubleBufferedTable.h"
+#include "tableHeatmap.h"
+#include "distributeBilinear.h"
+#include "inverseInterpolate.h"
+#include "denseTable.h"
 #include "expSmooth.h"
+#include "movingAverage.h"
+#include "median.h"
+#include "decimator.h"
+#include "datalog.h"
+#include "flightRecorder.h"
 
 #endif
\ No newline at end of file
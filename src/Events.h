@@ -32,7 +32,7 @@ angle_t getAngleTdc(int cylinder, const uint8_t *firingOrder, uint8_t cylinderCo
   {
     if (cylinder == firingOrder[i])
     {
-      return i * (720.0 / cylinderCount);
+      return i * (static_cast<angle_t>(720) / cylinderCount);
     }
   }
 
@@ -44,9 +44,9 @@ angle_t getAngleTdcHalfCycle(int cylinder, const uint8_t *firingOrder, uint8_t c
 {
   angle_t angle = getAngleTdc<angle_t>(cylinder, firingOrder, cylinderCount);
   
-  while (angle >= 360.0)
+  while (angle >= static_cast<angle_t>(360))
   {
-    angle -= 360.0;
+    angle -= static_cast<angle_t>(360);
   }
 
   return angle;
@@ -0,0 +1,65 @@
+// ARM DSP Kernels
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_ARM_DSP_H_
+#define ENGINE_CALCULATIONS_ARM_DSP_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __ARM_FEATURE_SIMD32
+#include <arm_acle.h>
+#endif
+
+/*
+Dual 16-bit multiply-accumulate with the DSP extension of Cortex-M4/M7 (__ARM_FEATURE_DSP). SMUAD
+multiplies both halfword pairs of two registers and adds the products in one cycle, where plain C
+needs two MULs and an ADD, or an MLA. The operands are signed halfwords, so unsigned values must be
+under 2^15. ACLE's __smuad is used where the toolchain has it (__ARM_FEATURE_SIMD32, GCC 10 and up),
+and the instruction directly otherwise. Other targets get plain C.
+
+The expSmooth() and interpolateBilinear() hooks that use it pack their operands first, so whether
+they beat the generic code depends on the compiler. They're off until test_armDsp shows a gain on
+hardware: build with -DENGINE_CALCULATIONS_ENABLE_ARM_DSP (pio test -e cortexm4_dsp) to use them.
+ */
+
+#if defined(__ARM_FEATURE_DSP) && defined(ENGINE_CALCULATIONS_ENABLE_ARM_DSP)
+#define ENGINE_CALCULATIONS_ARM_DSP_HOOKS
+#endif
+
+// Two int16_t in one register, a in the low halfword
+inline uint32_t packHalfwords(int16_t a, int16_t b)
+{
+  return static_cast<uint16_t>(a) | (static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16);
+}
+
+// a0 * b0 + a1 * b1
+inline int32_t dualMulAdd(int16_t a0, int16_t b0, int16_t a1, int16_t b1)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+  return __smuad(packHalfwords(a0, a1), packHalfwords(b0, b1));
+#elif defined(__ARM_FEATURE_DSP)
+  int32_t result;
+  __asm__ ("smuad %0, %1, %2" : "=r" (result) : "r" (packHalfwords(a0, a1)), "r" (packHalfwords(b0, b1)));
+  return result;
+#else
+  return static_cast<int32_t>(a0) * b0 + static_cast<int32_t>(a1) * b1;
+#endif
+}
+
+#endif
@@ -0,0 +1,145 @@
+// AVR Multiply Kernels
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_AVR_MUL_H_
+#define ENGINE_CALCULATIONS_AVR_MUL_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include "fixedPoint.h"
+
+/*
+Widening multiplies built from the AVR's 2-cycle 8x8 MUL. avr-gcc promotes 16x8 and 16x16 products
+to 32 bits and calls its generic multiply, which does 4 MULs for 16x8 and shuffles registers it
+doesn't need. These do only the partial products the widths need. Other targets get plain C.
+
+__tmp_reg__ (r0) may be clobbered freely, and __zero_reg__ (r1) is cleared again before returning.
+CLR doesn't change the carry flag, so it can sit between an ADD and the ADC that uses its carry.
+ */
+
+// 24 bits on AVR, 32 elsewhere
+typedef UnsignedForBits<24>::type Product24;
+
+// a * b
+inline Product24 mulU16U8(uint16_t a, uint8_t b)
+{
+#ifdef __AVR_ARCH__
+  Product24 result;
+  __asm__ (
+    "mul %A1, %2"           "\n\t"
+    "mov %A0, r0"           "\n\t"
+    "mov %B0, r1"           "\n\t"
+    "mul %B1, %2"           "\n\t"
+    "add %B0, r0"           "\n\t"
+    "mov %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %C0, __zero_reg__" "\n\t"
+    : "=&r" (result)
+    : "r" (a), "r" (b));
+  return result;
+#else
+  return static_cast<Product24>(a) * b;
+#endif
+}
+
+// acc + a * b. The sum must fit in 24 bits.
+inline Product24 macU16U8(Product24 acc, uint16_t a, uint8_t b)
+{
+#ifdef __AVR_ARCH__
+  __asm__ (
+    "mul %A1, %2"           "\n\t"
+    "add %A0, r0"           "\n\t"
+    "adc %B0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %C0, __zero_reg__" "\n\t"
+    "mul %B1, %2"           "\n\t"
+    "add %B0, r0"           "\n\t"
+    "adc %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    : "+r" (acc)
+    : "r" (a), "r" (b));
+  return acc;
+#else
+  return acc + static_cast<Product24>(a) * b;
+#endif
+}
+
+// a * b
+inline uint32_t mulU16U16(uint16_t a, uint16_t b)
+{
+#ifdef __AVR_ARCH__
+  uint32_t result;
+  __asm__ (
+    "mul %B1, %B2"          "\n\t"
+    "mov %C0, r0"           "\n\t"
+    "mov %D0, r1"           "\n\t"
+    "mul %A1, %A2"          "\n\t"
+    "mov %A0, r0"           "\n\t"
+    "mov %B0, r1"           "\n\t"
+    "mul %A1, %B2"          "\n\t"
+    "add %B0, r0"           "\n\t"
+    "adc %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %D0, __zero_reg__" "\n\t"
+    "mul %B1, %A2"          "\n\t"
+    "add %B0, r0"           "\n\t"
+    "adc %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %D0, __zero_reg__" "\n\t"
+    : "=&r" (result)
+    : "r" (a), "r" (b));
+  return result;
+#else
+  return static_cast<uint32_t>(a) * b;
+#endif
+}
+
+// acc + a * b, modulo 2^32
+inline uint32_t macU16U16(uint32_t acc, uint16_t a, uint16_t b)
+{
+#ifdef __AVR_ARCH__
+  __asm__ (
+    "mul %A1, %A2"          "\n\t"
+    "add %A0, r0"           "\n\t"
+    "adc %B0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %C0, __zero_reg__" "\n\t"
+    "adc %D0, __zero_reg__" "\n\t"
+    "mul %B1, %B2"          "\n\t"
+    "add %C0, r0"           "\n\t"
+    "adc %D0, r1"           "\n\t"
+    "mul %A1, %B2"          "\n\t"
+    "add %B0, r0"           "\n\t"
+    "adc %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %D0, __zero_reg__" "\n\t"
+    "mul %B1, %A2"          "\n\t"
+    "add %B0, r0"           "\n\t"
+    "adc %C0, r1"           "\n\t"
+    "clr __zero_reg__"      "\n\t"
+    "adc %D0, __zero_reg__" "\n\t"
+    : "+r" (acc)
+    : "r" (a), "r" (b));
+  return acc;
+#else
+  return acc + static_cast<uint32_t>(a) * b;
+#endif
+}
+
+#endif
@@ -0,0 +1,139 @@
+// Cached Tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_CACHED_TABLE_H_
+#define ENGINE_CALCULATIONS_CACHED_TABLE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixedPoint.h"
+
+// Distance between two inputs without overflowing their type. Signed distances can be up to
+// twice the type's max, so integers are measured in the unsigned counterpart, like findOnScale()
+// does for uniform scales. Floating point is measured as-is.
+template<typename T, bool floating = IsFloatingPoint<T>::value>
+struct InputDistance
+{
+  typedef typename UnsignedForBits<sizeof(T) * 8>::type type;
+
+  static type between(T a, T b)
+  {
+    return a > b ? static_cast<type>(static_cast<type>(a) - static_cast<type>(b))
+                 : static_cast<type>(static_cast<type>(b) - static_cast<type>(a));
+  }
+};
+
+template<typename T>
+struct InputDistance<T, true>
+{
+  typedef T type;
+
+  static type between(T a, T b)
+  {
+    return a > b ? a - b : b - a;
+  }
+};
+
+/**
+ * @brief Memoizes lookups on a 2D table while the inputs stay within a deadband
+ * 
+ * The cached output is kept until x or y moves more than its deadband from the inputs it was
+ * computed at. Comparing against those inputs rather than the last call's means slow drift still
+ * recomputes once it adds up. A deadband of 0 only skips repeated identical inputs.
+ * 
+ * Edit cells through set() so the cache is invalidated, or call invalidate() after editing the
+ * table directly.
+ * 
+ * @tparam Table Table2D or any type with XType, YType, ValueType, at() and lookup()
+ */
+template<typename Table>
+class CachedTable2D
+{
+public:
+  typedef typename Table::XType XType;
+  typedef typename Table::YType YType;
+  typedef typename Table::ValueType ValueType;
+
+  CachedTable2D(Table &table, XType xDeadband = 0, YType yDeadband = 0)
+    : _table(table), _xDeadband(xDeadband), _yDeadband(yDeadband)
+  {
+    invalidate();
+  }
+
+  ValueType lookup(XType x, YType y)
+  {
+    if (_valid
+      && InputDistance<XType>::between(x, _x) <= static_cast<typename InputDistance<XType>::type>(_xDeadband)
+      && InputDistance<YType>::between(y, _y) <= static_cast<typename InputDistance<YType>::type>(_yDeadband))
+    {
+      return _output;
+    }
+
+    _x = x;
+    _y = y;
+    _output = _table.lookup(x, y);
+    _valid = true;
+
+    return _output;
+  }
+
+  ValueType operator()(XType x, YType y)
+  {
+    return lookup(x, y);
+  }
+
+  void set(size_t xIndex, size_t yIndex, ValueType value)
+  {
+    _table.at(xIndex, yIndex) = value;
+    invalidate();
+  }
+
+  void invalidate()
+  {
+    _valid = false;
+  }
+
+  void setDeadband(XType xDeadband, YType yDeadband)
+  {
+    _xDeadband = xDeadband;
+    _yDeadband = yDeadband;
+    invalidate();
+  }
+
+  bool valid() const
+  {
+    return _valid;
+  }
+
+  Table &table()
+  {
+    return _table;
+  }
+
+private:
+  Table &_table;
+  XType _xDeadband;
+  YType _yDeadband;
+  XType _x;
+  YType _y;
+  ValueType _output;
+  bool _valid;
+};
+
+#endif
@@ -0,0 +1,229 @@
+// Binary Datalog
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_DATALOG_H_
+#define ENGINE_CALCULATIONS_DATALOG_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Compact binary datalog, for streaming per-event values over a slow link.
+
+A log is a header followed by records. Every record has the same channels, in the order
+the header lists them.
+
+Header:
+  'E' 'C' 'D' 'L'
+  version          uint8
+  channelCount     uint8
+  ticksPerSecond   uint32
+  baseTicks        uint32, ticks the first record's delta is from
+  channelCount x {id uint8, type uint8}
+
+Record:
+  deltaTicks       varint, ticks since the previous record (or baseTicks)
+  channels         each little-endian in the width of its type
+
+Varints are 7 bits per byte, low bits first, with the high bit set on every byte but the
+last, so deltas under 128 ticks take one byte and under 16384 take two.
+
+Multi-byte values are written in the target's byte order, which is little-endian on AVR and
+the ARM and x86 hosts that read logs.
+ */
+
+constexpr uint8_t datalogVersion = 1;
+constexpr uint8_t datalogMagic[4] = {'E', 'C', 'D', 'L'};
+
+// What a channel holds. Units are fixed by id, so readers know how to scale them.
+enum class DatalogChannelId: uint8_t
+{
+  Rpm = 1,             // RPM
+  Load = 2,            // 1/10 percent
+  InjectionTicks = 3,  // Timer ticks
+  CrankAngle = 4,      // Crank angle since the previous record, 1/16 degree
+  Maf = 5,             // Airflow, 1/100 g/s
+  Map = 6,             // Manifold pressure, 1/10 kPa
+  Tps = 7,             // Throttle position, 1/10 percent
+  Lambda = 8,          // Target lambda, 1/100
+  Advance = 9,         // Degrees BTDC
+  ScheduledTicks = 10, // Timer ticks of the next scheduled event, like from getTicksFromAngle()
+  MeasuredLambda = 11, // Wideband lambda, 1/1000
+  User = 128           // First id for application channels
+};
+
+enum class DatalogType: uint8_t {UInt8 = 1, Int8, UInt16, Int16, UInt32, Int32, Float};
+
+template<typename T> struct DatalogTypeOf;
+template<> struct DatalogTypeOf<uint8_t> { static constexpr DatalogType value = DatalogType::UInt8; };
+template<> struct DatalogTypeOf<int8_t> { static constexpr DatalogType value = DatalogType::Int8; };
+template<> struct DatalogTypeOf<uint16_t> { static constexpr DatalogType value = DatalogType::UInt16; };
+template<> struct DatalogTypeOf<int16_t> { static constexpr DatalogType value = DatalogType::Int16; };
+template<> struct DatalogTypeOf<uint32_t> { static constexpr DatalogType value = DatalogType::UInt32; };
+template<> struct DatalogTypeOf<int32_t> { static constexpr DatalogType value = DatalogType::Int32; };
+template<> struct DatalogTypeOf<float> { static constexpr DatalogType value = DatalogType::Float; };
+
+// Width of a value of type in a record, or 0 if unknown
+constexpr uint8_t datalogTypeSize(DatalogType type)
+{
+  return type == DatalogType::UInt8 || type == DatalogType::Int8 ? 1
+    : type == DatalogType::UInt16 || type == DatalogType::Int16 ? 2
+    : type == DatalogType::UInt32 || type == DatalogType::Int32 || type == DatalogType::Float ? 4
+    : 0;
+}
+
+constexpr uint8_t maxVarintSize = 5;
+
+// Write value as a varint. Returns the number of bytes written.
+inline uint8_t encodeVarint(uint8_t *out, uint32_t value)
+{
+  uint8_t length = 0;
+
+  while (value >= 0x80)
+  {
+    out[length++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+
+  out[length++] = static_cast<uint8_t>(value);
+
+  return length;
+}
+
+// Read a varint of at most available bytes. Returns the number of bytes read, or 0 if truncated or too long.
+inline uint8_t decodeVarint(const uint8_t *in, size_t available, uint32_t &outValue)
+{
+  uint32_t value = 0;
+
+  for (uint8_t length = 0; length < maxVarintSize && length < available; length++)
+  {
+    value |= static_cast<uint32_t>(in[length] & 0x7F) << (7 * length);
+
+    if ((in[length] & 0x80) == 0)
+    {
+      outValue = value;
+      return length + 1;
+    }
+  }
+
+  return 0;
+}
+
+// A channel of a DatalogEncoder
+template<DatalogChannelId id, typename T>
+struct DatalogChannel
+{
+  typedef T Type;
+  static constexpr DatalogChannelId channelId = id;
+  static constexpr DatalogType type = DatalogTypeOf<T>::value;
+};
+
+template<typename... Channels>
+struct DatalogChannels;
+
+template<>
+struct DatalogChannels<>
+{
+  static constexpr size_t size = 0;
+
+  static uint8_t *writeSchema(uint8_t *out)
+  {
+    return out;
+  }
+
+  static uint8_t *write(uint8_t *out)
+  {
+    return out;
+  }
+};
+
+template<typename First, typename... Rest>
+struct DatalogChannels<First, Rest...>
+{
+  static constexpr size_t size = sizeof(typename First::Type) + DatalogChannels<Rest...>::size;
+
+  static uint8_t *writeSchema(uint8_t *out)
+  {
+    out[0] = static_cast<uint8_t>(First::channelId);
+    out[1] = static_cast<uint8_t>(First::type);
+    return DatalogChannels<Rest...>::writeSchema(out + 2);
+  }
+
+  static uint8_t *write(uint8_t *out, typename First::Type value, typename Rest::Type... rest)
+  {
+    memcpy(out, &value, sizeof(value));
+    return DatalogChannels<Rest...>::write(out + sizeof(value), rest...);
+  }
+};
+
+/**
+ * @brief Encodes records of fixed channels into a byte buffer
+ * 
+ * Cheap enough to run per event: a short varint loop and a copy of each value. The caller
+ * owns the buffer and sends it, so records can be batched for the link.
+ * 
+ * Ex:
+ *   DatalogEncoder<DatalogChannel<DatalogChannelId::Rpm, uint16_t>,
+ *                  DatalogChannel<DatalogChannelId::InjectionTicks, uint16_t>> encoder;
+ *   length = encoder.writeHeader(buffer, 2000000, ticks);
+ *   length += encoder.encode(buffer + length, ticks, rpm, injectionTicks);
+ * 
+ * @tparam Channels DatalogChannel types, in record order
+ */
+template<typename... Channels>
+class DatalogEncoder
+{
+public:
+  static constexpr uint8_t channelCount = sizeof...(Channels);
+  static constexpr size_t headerSize = 14 + 2 * channelCount;
+  static constexpr size_t maxRecordSize = maxVarintSize + DatalogChannels<Channels...>::size;
+
+  static_assert(channelCount > 0, "Need at least one channel");
+
+  // Write the header. Records after it are timed from ticks. Returns the number of bytes written.
+  size_t writeHeader(uint8_t *out, uint32_t ticksPerSecond, uint32_t ticks)
+  {
+    memcpy(out, datalogMagic, sizeof(datalogMagic));
+    out[4] = datalogVersion;
+    out[5] = channelCount;
+    memcpy(out + 6, &ticksPerSecond, sizeof(ticksPerSecond));
+    memcpy(out + 10, &ticks, sizeof(ticks));
+    DatalogChannels<Channels...>::writeSchema(out + 14);
+
+    _lastTicks = ticks;
+
+    return headerSize;
+  }
+
+  // Write a record of at most maxRecordSize bytes. Returns the number of bytes written.
+  size_t encode(uint8_t *out, uint32_t ticks, typename Channels::Type... values)
+  {
+    // Unsigned difference handles timer wraparound
+    uint8_t length = encodeVarint(out, ticks - _lastTicks);
+    _lastTicks = ticks;
+
+    return DatalogChannels<Channels...>::write(out + length, values...) - out;
+  }
+
+private:
+  uint32_t _lastTicks = 0;
+};
+
+#endif
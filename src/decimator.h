@@ -0,0 +1,118 @@
+// Decimator
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_DECIMATOR_H_
+#define ENGINE_CALCULATIONS_DECIMATOR_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include "fixedPoint.h"
+
+/**
+ * @brief Accumulate-and-dump decimator for oversampled ADC readings
+ * 
+ * Sums 2^decimationShift raw samples, then outputs the sum scaled to outputBits. Oversampling
+ * by 4^n gains n bits of resolution, so by default just enough samples are taken to get from
+ * inputBits to outputBits. Use a larger decimationShift to output less often.
+ * 
+ * add() is meant to be called from the ADC ISR. read() is meant to be called from the main loop
+ * and doesn't disable interrupts.
+ * 
+ * @tparam inputBits Resolution of raw samples
+ * @tparam outputBits Resolution of output. Use as valueBits when passing outputs to expSmooth
+ * @tparam decimationShift Log2 of samples per output
+ */
+template<uint8_t inputBits, uint8_t outputBits, uint8_t decimationShift = 2 * (outputBits - inputBits)>
+class Decimator
+{
+  static_assert(outputBits >= inputBits, "Output can't have less resolution than input");
+  static_assert(outputBits <= inputBits + decimationShift, "Not enough samples for output resolution");
+
+public:
+  typedef typename UnsignedForBits<inputBits>::type Input;
+  typedef typename UnsignedForBits<inputBits + decimationShift>::type Accumulator;
+  typedef typename UnsignedForBits<outputBits>::type Output;
+  typedef typename UnsignedForBits<decimationShift + 1>::type Counter;
+
+  static constexpr uint8_t valueBits = outputBits;
+  static constexpr Counter samplesPerOutput = static_cast<Counter>(1ul << decimationShift);
+
+  Decimator()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    _sum = 0;
+    _remaining = samplesPerOutput;
+    _output = 0;
+    _sequence = 0;
+    _lastReadSequence = 0;
+  }
+
+  // Add a raw sample. Call from the ISR.
+  void add(Input sample)
+  {
+    _sum += sample;
+
+    _remaining--;
+    if (0 == _remaining)
+    {
+      _output = static_cast<Output>(_sum >> outputShift);
+      _sum = 0;
+      _remaining = samplesPerOutput;
+
+      // Publish after the output is written
+      _sequence = _sequence + 1;
+    }
+  }
+
+  /**
+   * @brief Get the latest output
+   * 
+   * @param output Latest output
+   * @return true if there's been a new output since the last read
+   */
+  bool read(Output &output)
+  {
+    uint8_t sequence;
+
+    // Retry if the ISR published while we were reading
+    do
+    {
+      sequence = _sequence;
+      output = _output;
+    } while (sequence != _sequence);
+
+    bool isNew = sequence != _lastReadSequence;
+    _lastReadSequence = sequence;
+    return isNew;
+  }
+
+private:
+  static constexpr uint8_t outputShift = inputBits + decimationShift - outputBits;
+
+  Accumulator _sum;
+  Counter _remaining;
+  volatile Output _output;
+  volatile uint8_t _sequence;
+  uint8_t _lastReadSequence;
+};
+
+#endif
@@ -0,0 +1,188 @@
+// Dense Lookup Tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_DENSE_TABLE_H_
+#define ENGINE_CALCULATIONS_DENSE_TABLE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "progmemArray.h"
+#include "interpolateLinear.h"
+
+template<size_t... indices>
+struct IndexSequence {};
+
+template<typename First, typename Second>
+struct ConcatIndexSequence;
+
+template<size_t... first, size_t... second>
+struct ConcatIndexSequence<IndexSequence<first...>, IndexSequence<second...>>
+{
+  typedef IndexSequence<first..., (sizeof...(first) + second)...> Type;
+};
+
+// 0 to n - 1. Splits in half so template depth is log2(n), not n
+template<size_t n>
+struct MakeIndexSequence
+{
+  typedef typename ConcatIndexSequence<typename MakeIndexSequence<n / 2>::Type,
+    typename MakeIndexSequence<n - n / 2>::Type>::Type Type;
+};
+
+template<>
+struct MakeIndexSequence<0>
+{
+  typedef IndexSequence<> Type;
+};
+
+template<>
+struct MakeIndexSequence<1>
+{
+  typedef IndexSequence<0> Type;
+};
+
+// Floor of (num / denom) for positive denom, where / truncates negative numerators toward zero
+constexpr int64_t denseFloorDiv(int64_t num, int64_t denom)
+{
+  return num >= 0 ? num / denom : -((-num + denom - 1) / denom);
+}
+
+// Round (num / denom) half up, including for negative numerators
+constexpr int64_t denseDivRound(int64_t num, int64_t denom)
+{
+  return denseFloorDiv(num + denom / 2, denom);
+}
+
+// Input at the middle of a dense table entry's bucket
+constexpr int64_t denseBucketInput(size_t index, uint8_t inputShift)
+{
+  return (static_cast<int64_t>(index) << inputShift) + ((1l << inputShift) >> 1);
+}
+
+/*
+Exact interpolation of a sparse table for the constexpr generator, divided by 2^outputShift and
+rounded. Scans from the bottom by recursion, since C++11 constexpr functions can't loop.
+ */
+template<typename InputType, typename OutputType>
+constexpr int64_t denseLinearValue(int64_t input, const InputType *scale, const OutputType *outputs, size_t length,
+  uint8_t outputShift, size_t index = 0)
+{
+  return input <= static_cast<int64_t>(scale[0])
+    ? denseDivRound(static_cast<int64_t>(outputs[0]), 1l << outputShift)
+    : input >= static_cast<int64_t>(scale[length - 1])
+    ? denseDivRound(static_cast<int64_t>(outputs[length - 1]), 1l << outputShift)
+    : input > static_cast<int64_t>(scale[index + 1])
+    ? denseLinearValue(input, scale, outputs, length, outputShift, index + 1)
+    : denseDivRound(
+      static_cast<int64_t>(outputs[index]) * (static_cast<int64_t>(scale[index + 1]) - input)
+      + static_cast<int64_t>(outputs[index + 1]) * (input - static_cast<int64_t>(scale[index])),
+      (static_cast<int64_t>(scale[index + 1]) - static_cast<int64_t>(scale[index])) << outputShift);
+}
+
+/**
+ * @brief Sparse table expanded into one entry per quantized input, so a lookup is a single load
+ * 
+ * Entry i covers inputs (i << inputShift) to ((i + 1) << inputShift) - 1 and holds the sparse
+ * table sampled in the middle of that range. Inputs past the end use the last entry.
+ * 
+ * Fill it at setup time with expand(), or at compile time with makeDenseLinearTable() so it can
+ * be stored in PROGMEM and read with lookupProgmem().
+ * 
+ * @tparam T Type of entry. Choose it with outputShift to set the output quantization
+ * @tparam InputType Type of input
+ * @tparam indexBits log2 of the number of entries
+ * @tparam inputShift Input bits dropped to get the index
+ */
+template<typename T, typename InputType, uint8_t indexBits, uint8_t inputShift = 0>
+struct DenseLinearTable
+{
+  static constexpr size_t size = static_cast<size_t>(1) << indexBits;
+
+  T values[size];
+
+  static size_t index(InputType input)
+  {
+    size_t index = static_cast<size_t>(input >> inputShift);
+    return index < size ? index : size - 1;
+  }
+
+  T lookup(InputType input) const
+  {
+    return values[index(input)];
+  }
+
+  T lookupProgmem(InputType input) const
+  {
+    return ProgmemArray<T>(values)[index(input)];
+  }
+
+  /**
+   * @brief Fill from a sparse table with interpolateLinearTable()
+   * 
+   * @tparam OutputType Type of sparse table output
+   * @param length Length of sparse table
+   * @param scale Array-like input scale. Must be indexable []
+   * @param outputs Array-like outputs. Must be indexable []
+   * @param outputShift Divide outputs by 2^outputShift, rounding, before storing them as T
+   */
+  template<typename OutputType, typename InputArray, typename OutputArray>
+  void expand(size_t length, InputArray scale, OutputArray outputs, uint8_t outputShift = 0)
+  {
+    const int64_t round = (1l << outputShift) >> 1;
+
+    for (size_t i = 0; i < size; i++)
+    {
+      InputType input = static_cast<InputType>(denseBucketInput(i, inputShift));
+      OutputType output = interpolateLinearTable<OutputType>(input, length, scale, outputs);
+      values[i] = static_cast<T>(denseFloorDiv(static_cast<int64_t>(output) + round, 1l << outputShift));
+    }
+  }
+};
+
+template<typename T, typename InputType, uint8_t indexBits, uint8_t inputShift, uint8_t outputShift,
+  typename ScaleType, typename OutputType, size_t... indices>
+constexpr DenseLinearTable<T, InputType, indexBits, inputShift> makeDenseLinearTable(IndexSequence<indices...>,
+  const ScaleType *scale, const OutputType *outputs, size_t length)
+{
+  return DenseLinearTable<T, InputType, indexBits, inputShift>{{
+    static_cast<T>(denseLinearValue(denseBucketInput(indices, inputShift), scale, outputs, length, outputShift))...}};
+}
+
+/**
+ * @brief Expand a sparse table at compile time
+ * 
+ * The scale and outputs must be constexpr arrays. Values are interpolated exactly and rounded,
+ * so they can be 1 more accurate than expand(), which uses the fixed-point interpolateLinear().
+ * Integer outputs only.
+ * 
+ * Ex: constexpr DenseLinearTable<uint16_t, uint16_t, 8, 2> mafTable PROGMEM =
+ *       makeDenseLinearTable<uint16_t, uint16_t, 8, 2>(mafVolts, mafFlow, 12);
+ * 
+ * @tparam outputShift Divide outputs by 2^outputShift, rounding, before storing them as T
+ */
+template<typename T, typename InputType, uint8_t indexBits, uint8_t inputShift = 0, uint8_t outputShift = 0,
+  typename ScaleType, typename OutputType>
+constexpr DenseLinearTable<T, InputType, indexBits, inputShift> makeDenseLinearTable(const ScaleType *scale,
+  const OutputType *outputs, size_t length)
+{
+  return makeDenseLinearTable<T, InputType, indexBits, inputShift, outputShift>(
+    typename MakeIndexSequence<static_cast<size_t>(1) << indexBits>::Type(), scale, outputs, length);
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Bilinear Distribution
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_DISTRIBUTE_BILINEAR_H_
+#define ENGINE_CALCULATIONS_DISTRIBUTE_BILINEAR_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixedPoint.h"
+#include "scale.h"
+#include "tableLayout.h"
+#include "interpolateBilinear.h"
+
+// Add to a cell, clamping to its range
+template<typename Z, typename Sum>
+void addClamped(Z &cell, Sum amount)
+{
+  Sum sum = static_cast<Sum>(cell) + amount;
+
+  if (sum > static_cast<Sum>(IntegerLimits<Z>::max))
+  {
+    cell = IntegerLimits<Z>::max;
+  }
+  else if (sum < static_cast<Sum>(IntegerLimits<Z>::min))
+  {
+    cell = IntegerLimits<Z>::min;
+  }
+  else
+  {
+    cell = static_cast<Z>(sum);
+  }
+}
+
+/**
+ * @brief Spread a correction over the cells around a location, the inverse of interpolating
+ * 
+ * Each of the up to four cells around the location gets delta times its bilinear weight, the
+ * same weight it has when interpolating there. Cells are clamped to the range of Z. Use the
+ * location from locateBilinearTable() that was used for the lookup, so learning costs one pair
+ * of scale searches per event.
+ * 
+ * @tparam Layout How cells are stored. Row-major by default.
+ * @tparam weightBits Fixed-point bits of weight per axis. At most 7, so delta times both weights
+ * fits in 32 bits with room to round.
+ * @param location Location from locateBilinearTable()
+ * @param xLength Length of x scale
+ * @param yLength Length of y scale
+ * @param cells Integer cells
+ * @param delta Signed correction to apply at the location
+ */
+template<typename Layout = RowMajorLayout, uint8_t weightBits = 7, typename X, typename Y, typename Z>
+void distributeBilinear(const BilinearTableLocation<X, Y> &location, size_t xLength, size_t yLength,
+  Z *cells, int16_t delta)
+{
+  static_assert(weightBits <= 7, "Weights too wide for 32-bit math");
+
+  constexpr uint8_t shift = 2 * weightBits;
+  constexpr int32_t one = static_cast<int32_t>(1) << weightBits;
+  constexpr int32_t round = static_cast<int32_t>(1) << (shift - 1);
+
+  int32_t x1 = bilinearHighWeight<weightBits>(location.xResult, location.x, location.xLow, location.xHigh);
+  int32_t y1 = bilinearHighWeight<weightBits>(location.yResult, location.y, location.yLow, location.yHigh);
+  int32_t x0 = one - x1;
+  int32_t y0 = one - y1;
+
+  const int32_t weights[4] = {x0 * y0, x1 * y0, x0 * y1, x1 * y1};
+
+  for (uint8_t corner = 0; corner < 4; corner++)
+  {
+    if (weights[corner] == 0)
+    {
+      continue;
+    }
+
+    // Round away from zero
+    int32_t scaled = static_cast<int32_t>(delta) * weights[corner];
+    int32_t amount = scaled < 0 ? -((round - scaled) >> shift) : (scaled + round) >> shift;
+
+    size_t xIndex = location.xLowIndex + (corner & 1u);
+    size_t yIndex = location.yLowIndex + (corner >> 1);
+    addClamped(cells[Layout::index(xIndex, yIndex, xLength, yLength)], amount);
+  }
+}
+
+#endif
@@ -0,0 +1,128 @@
+// Double-Buffered Tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_DOUBLE_BUFFERED_TABLE_H_
+#define ENGINE_CALCULATIONS_DOUBLE_BUFFERED_TABLE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Two copies of a table so it can be tuned while an ISR reads it
+ * 
+ * Readers use the active copy. Edits go to the inactive copy, which is refreshed from the active
+ * one on the first edit of a batch, and publish() makes it active with a single byte store. Since
+ * a byte store is atomic on AVR, readers see either the old table or the new one, never a mix,
+ * and interrupts never need to be disabled. A full-map upload is one batch and one swap.
+ * 
+ * Edit from one context only, usually the main loop. Meant for single-core MCUs, where an ISR
+ * reading the old copy finishes before the main loop can start editing it again.
+ * 
+ * @tparam Table Table2D or any copyable type with XType, YType, ValueType, at() and lookup()
+ */
+template<typename Table>
+class DoubleBufferedTable
+{
+public:
+  typedef typename Table::XType XType;
+  typedef typename Table::YType YType;
+  typedef typename Table::ValueType ValueType;
+
+  DoubleBufferedTable(const Table &initial)
+    : _active(0), _editing(false), _publishCount(0)
+  {
+    _buffers[0] = initial;
+    _buffers[1] = initial;
+  }
+
+  // Safe to call from an ISR
+  const Table &active() const
+  {
+    return _buffers[_active];
+  }
+
+  ValueType lookup(XType x, YType y) const
+  {
+    return active().lookup(x, y);
+  }
+
+  // Start a batch of edits, if not already started. Returns the copy being edited.
+  Table &beginEdit()
+  {
+    uint8_t inactive = _active ^ 1u;
+
+    if (!_editing)
+    {
+      _buffers[inactive] = _buffers[_active];
+      _editing = true;
+    }
+
+    return _buffers[inactive];
+  }
+
+  void set(size_t xIndex, size_t yIndex, ValueType value)
+  {
+    beginEdit().at(xIndex, yIndex) = value;
+  }
+
+  // Replace the whole table in the current batch
+  void load(const Table &table)
+  {
+    beginEdit() = table;
+  }
+
+  // Make the edited copy active. Does nothing if there are no edits.
+  void publish()
+  {
+    if (!_editing)
+    {
+      return;
+    }
+
+    // Finish writing the edited copy before readers can see it
+    __asm__ __volatile__("" ::: "memory");
+
+    _active ^= 1u;
+    _editing = false;
+    _publishCount++;
+  }
+
+  // Throw away the current batch
+  void discard()
+  {
+    _editing = false;
+  }
+
+  bool editing() const
+  {
+    return _editing;
+  }
+
+  uint16_t publishCount() const
+  {
+    return _publishCount;
+  }
+
+private:
+  Table _buffers[2];
+  volatile uint8_t _active;
+  bool _editing;
+  uint16_t _publishCount;
+};
+
+#endif
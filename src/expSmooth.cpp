@@ -15,8 +15,63 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "expSmooth.h"
+#include "progmemArray.h"
+
+namespace
+{
+
+// 1 - exp(-k/8) for k = 0 to 64, scaled by 2^16
+// Past a ratio of 8, alpha is within rounding of 1 for up to 7 fraction bits
+constexpr uint8_t alphaTableRatioFracBits = 3;
+
+const uint16_t alphaTable[] PROGMEM = {
+      0,  7701, 14497, 20494, 25786, 30457, 34579, 38217,
+  41427, 44260, 46760, 48966, 50913, 52631, 54148, 55486,
+  56667, 57709, 58629, 59440, 60156, 60789, 61346, 61839,
+  62273, 62657, 62995, 63293, 63557, 63790, 63995, 64176,
+  64336, 64477, 64601, 64711, 64808, 64894, 64969, 65036,
+  65094, 65146, 65192, 65233, 65268, 65300, 65327, 65352,
+  65374, 65393, 65409, 65424, 65437, 65449, 65459, 65468,
+  65476, 65483, 65489, 65495, 65500, 65504, 65508, 65511,
+  65514};
+
+} // namespace
 
 uint8_t calculateAlphaFixed(float alphaFloat, uint8_t fractionBits)
 {
   return static_cast<uint8_t>(alphaFloat * (1u << fractionBits));
 }
+
+uint8_t calculateAlphaFixedFromTime(uint32_t deltaTime, uint32_t timeConstant, uint8_t fractionBits)
+{
+  // Drop resolution until the time constant fits in 16 bits so the ratio below can't overflow
+  while (timeConstant > 0xFFFFu)
+  {
+    deltaTime >>= 1;
+    timeConstant >>= 1;
+  }
+
+  // Off the end of the table
+  if ((deltaTime >> alphaTableRatioFracBits) >= timeConstant)
+  {
+    return static_cast<uint8_t>(1u << fractionBits);
+  }
+
+  // deltaTime / timeConstant with 8 fraction bits, always less than 8
+  uint16_t ratio = static_cast<uint16_t>((deltaTime << 8) / timeConstant);
+
+  // Interpolate between table entries
+  constexpr uint8_t stepBits = 8 - alphaTableRatioFracBits;
+  uint8_t index = static_cast<uint8_t>(ratio >> stepBits);
+  uint8_t stepFraction = static_cast<uint8_t>(ratio & ((1u << stepBits) - 1u));
+
+  ProgmemArray<uint16_t> table(alphaTable);
+  uint16_t alphaLow = table[index];
+  uint16_t alphaHigh = table[index + 1];
+  uint16_t alpha16 = alphaLow + static_cast<uint16_t>(
+    (static_cast<uint32_t>(alphaHigh - alphaLow) * stepFraction + (1u << (stepBits - 1))) >> stepBits);
+
+  // Keep one extra bit to round instead of truncating
+  uint16_t alphaRound = alpha16 >> (15 - fractionBits);
+  return static_cast<uint8_t>((alphaRound + 1u) >> 1);
+}
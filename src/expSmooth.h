@@ -21,14 +21,51 @@
 
 #include <stdint.h>
 
-template<uint8_t alphaFracBits, typename TMul, typename TVal>
+#include "avrMul.h"
+#include "armDsp.h"
+
+// cur * alpha + prev * oneMinusAlpha. int16Values is true when values are under 2^15.
+template<typename TMul, typename TVal, bool int16Values>
+struct ExpSmoothSum
+{
+  static TMul sum(TVal cur, TVal prev, uint8_t alpha, uint8_t oneMinusAlpha)
+  {
+    return static_cast<TMul>(cur) * alpha + static_cast<TMul>(prev) * oneMinusAlpha;
+  }
+};
+
+#ifdef __AVR_ARCH__
+// Two 16x8 hardware multiplies instead of two generic 24-bit ones
+template<bool int16Values>
+struct ExpSmoothSum<__uint24, uint16_t, int16Values>
+{
+  static __uint24 sum(uint16_t cur, uint16_t prev, uint8_t alpha, uint8_t oneMinusAlpha)
+  {
+    return macU16U8(mulU16U8(cur, alpha), prev, oneMinusAlpha);
+  }
+};
+#endif
+
+#ifdef ENGINE_CALCULATIONS_ARM_DSP_HOOKS
+// One dual multiply-accumulate
+template<typename TMul, typename TVal>
+struct ExpSmoothSum<TMul, TVal, true>
+{
+  static TMul sum(TVal cur, TVal prev, uint8_t alpha, uint8_t oneMinusAlpha)
+  {
+    return static_cast<TMul>(dualMulAdd(static_cast<int16_t>(cur), alpha, static_cast<int16_t>(prev), oneMinusAlpha));
+  }
+};
+#endif
+
+template<uint8_t alphaFracBits, typename TMul, typename TVal, uint8_t valueBits = sizeof(TVal) * 8>
 TVal expSmoothImpl(TVal cur, TVal prev, uint8_t alpha, uint8_t oneMinusAlpha)
 {
   static constexpr TMul alphaFactor = 1u << alphaFracBits;
   static constexpr TMul roundingFactor = alphaFactor / 2u;
 
   return static_cast<TVal>(
-    (static_cast<TMul>(cur) * alpha + static_cast<TMul>(prev) * oneMinusAlpha + roundingFactor)
+    (ExpSmoothSum<TMul, TVal, (valueBits < 16)>::sum(cur, prev, alpha, oneMinusAlpha) + roundingFactor)
     / alphaFactor);
 }
 
@@ -39,21 +76,21 @@ TVal expSmooth(TVal cur, TVal prev, uint8_t alpha, uint8_t oneMinusAlpha)
   
   if (valueBits + alphaFracBits <= 16)
   {
-    return expSmoothImpl<alphaFracBits, uint16_t>(cur, prev, alpha, oneMinusAlpha);
+    return expSmoothImpl<alphaFracBits, uint16_t, TVal, valueBits>(cur, prev, alpha, oneMinusAlpha);
   }
 #ifdef __AVR_ARCH__
   else if (valueBits + alphaFracBits <= 24)
   {
-    return expSmoothImpl<alphaFracBits, __uint24>(cur, prev, alpha, oneMinusAlpha);
+    return expSmoothImpl<alphaFracBits, __uint24, TVal, valueBits>(cur, prev, alpha, oneMinusAlpha);
   }
 #endif
   else if (valueBits + alphaFracBits <= 32)
   {
-    return expSmoothImpl<alphaFracBits, uint32_t>(cur, prev, alpha, oneMinusAlpha);
+    return expSmoothImpl<alphaFracBits, uint32_t, TVal, valueBits>(cur, prev, alpha, oneMinusAlpha);
   }
   else if (valueBits + alphaFracBits <= 64)
   {
-    return expSmoothImpl<alphaFracBits, uint64_t>(cur, prev, alpha, oneMinusAlpha);
+    return expSmoothImpl<alphaFracBits, uint64_t, TVal, valueBits>(cur, prev, alpha, oneMinusAlpha);
   }
   else
   {
@@ -69,4 +106,26 @@ TVal expSmooth(TVal cur, TVal prev, uint8_t alpha)
 
 uint8_t calculateAlphaFixed(float alphaFloat, uint8_t fractionBits = 6u);
 
+/**
+ * @brief Calculate alpha for samples that arrive at varying intervals
+ * 
+ * alpha = 1 - exp(-deltaTime / timeConstant), taken from a fixed-point lookup table so no floating point
+ * or exp() is needed. Filter bandwidth stays the same regardless of sample rate.
+ * 
+ * @param deltaTime Time since the previous sample
+ * @param timeConstant Filter time constant, in the same units as deltaTime
+ * @param fractionBits Fraction bits of the alpha returned. Must be 7 or less
+ * @return uint8_t alpha
+ */
+uint8_t calculateAlphaFixedFromTime(uint32_t deltaTime, uint32_t timeConstant, uint8_t fractionBits = 6u);
+
+template<uint8_t alphaFracBits = 6, typename TVal, uint8_t valueBits = sizeof(TVal) * 8 - 6>
+TVal expSmoothDeltaTime(TVal cur, TVal prev, uint32_t deltaTime, uint32_t timeConstant)
+{
+  static_assert(alphaFracBits <= 7, "alpha must fit in uint8_t");
+
+  return expSmooth<alphaFracBits, TVal, valueBits>(cur, prev,
+    calculateAlphaFixedFromTime(deltaTime, timeConstant, alphaFracBits));
+}
+
 #endif
\ No newline at end of file
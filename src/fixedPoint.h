@@ -0,0 +1,184 @@
+// Fixed Point Types
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_FIXED_POINT_H_
+#define ENGINE_CALCULATIONS_FIXED_POINT_H_
+
+#pragma once
+
+#include <stdint.h>
+
+// Number of bits needed to hold value
+constexpr uint8_t bitWidth(uint32_t value)
+{
+  return value == 0 ? 0 : 1 + bitWidth(value >> 1);
+}
+
+template<uint8_t size>
+struct UnsignedForSize
+{
+  typedef uint64_t type;
+};
+
+template<>
+struct UnsignedForSize<0>
+{
+  typedef uint8_t type;
+};
+
+template<>
+struct UnsignedForSize<1>
+{
+  typedef uint16_t type;
+};
+
+template<>
+struct UnsignedForSize<2>
+{
+#ifdef __AVR_ARCH__
+  typedef __uint24 type;
+#else
+  typedef uint32_t type;
+#endif
+};
+
+template<>
+struct UnsignedForSize<3>
+{
+  typedef uint32_t type;
+};
+
+template<uint8_t size>
+struct SignedForSize
+{
+  typedef int64_t type;
+};
+
+template<>
+struct SignedForSize<0>
+{
+  typedef int8_t type;
+};
+
+template<>
+struct SignedForSize<1>
+{
+  typedef int16_t type;
+};
+
+template<>
+struct SignedForSize<2>
+{
+#ifdef __AVR_ARCH__
+  typedef __int24 type;
+#else
+  typedef int32_t type;
+#endif
+};
+
+template<>
+struct SignedForSize<3>
+{
+  typedef int32_t type;
+};
+
+// Smallest unsigned type that holds at least bits
+template<uint8_t bits>
+struct UnsignedForBits
+{
+  typedef typename UnsignedForSize<(bits > 8) + (bits > 16) + (bits > 24) + (bits > 32)>::type type;
+};
+
+// Smallest signed type that holds at least bits, including the sign bit
+template<uint8_t bits>
+struct SignedForBits
+{
+  typedef typename SignedForSize<(bits > 8) + (bits > 16) + (bits > 24) + (bits > 32)>::type type;
+};
+
+// Type used to multiply or accumulate values of T without overflowing bits. Floating point and
+// custom types are used as-is.
+template<typename T, uint8_t bits>
+struct WideningType
+{
+  typedef T type;
+};
+
+template<uint8_t bits>
+struct WideningType<uint8_t, bits>
+{
+  typedef typename UnsignedForBits<bits>::type type;
+};
+
+template<uint8_t bits>
+struct WideningType<uint16_t, bits>
+{
+  typedef typename UnsignedForBits<bits>::type type;
+};
+
+template<uint8_t bits>
+struct WideningType<uint32_t, bits>
+{
+  typedef typename UnsignedForBits<bits>::type type;
+};
+
+template<uint8_t bits>
+struct WideningType<int8_t, bits>
+{
+  typedef typename SignedForBits<bits>::type type;
+};
+
+template<uint8_t bits>
+struct WideningType<int16_t, bits>
+{
+  typedef typename SignedForBits<bits>::type type;
+};
+
+template<uint8_t bits>
+struct WideningType<int32_t, bits>
+{
+  typedef typename SignedForBits<bits>::type type;
+};
+
+// Whether T is floating point, since <type_traits> isn't available on AVR
+template<typename T>
+struct IsFloatingPoint
+{
+  static constexpr bool value = false;
+};
+
+template<>
+struct IsFloatingPoint<float>
+{
+  static constexpr bool value = true;
+};
+
+template<>
+struct IsFloatingPoint<double>
+{
+  static constexpr bool value = true;
+};
+
+// Range of integer types, since <limits> isn't available on AVR
+template<typename T>
+struct IntegerLimits
+{
+  static constexpr bool isSigned = static_cast<T>(-1) < static_cast<T>(0);
+  static constexpr T max = static_cast<T>(~0ull >> (64 - sizeof(T) * 8 + isSigned));
+  static constexpr T min = isSigned ? static_cast<T>(-max - 1) : static_cast<T>(0);
+};
+
+#endif
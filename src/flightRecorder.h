@@ -0,0 +1,156 @@
+// Flight Recorder
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_FLIGHT_RECORDER_H_
+#define ENGINE_CALCULATIONS_FLIGHT_RECORDER_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What the engine was doing at one event
+struct EventSnapshot
+{
+  uint32_t crankTicks;      // Timer ticks at the crank event
+  uint16_t crankAngle;      // Crank angle at the event
+  uint16_t rpm;
+  uint16_t load;
+  uint16_t fuel;            // Fuel table output
+  int16_t advance;          // Spark table output
+  uint16_t injectionTicks;  // Injection length
+  uint32_t scheduledTicks;  // Timer ticks the next event is scheduled for
+};
+
+/**
+ * @brief Ring buffer of the last 2^capacityBits snapshots, written from an ISR
+ * 
+ * record() is a copy into the next slot and a counter increment, so it is cheap enough to call
+ * every event. When the buffer is full the oldest snapshot is overwritten: the point is to have
+ * the events leading up to a problem, not every event.
+ * 
+ * read() drains it from the main loop without disabling interrupts. The head counter is 16 bits,
+ * which AVR can't load atomically, so it's read until two loads agree. A snapshot that was
+ * overwritten while being copied is dropped and counted in lost().
+ * 
+ * One writer and one reader. Meant for single-core MCUs, where a record() from an ISR finishes
+ * before the main loop runs again. Read at least every 65536 - capacity events, or lost() and
+ * the order of what's read are wrong once the counters wrap past each other.
+ * 
+ * RAM used is 2^capacityBits * sizeof(Snapshot) plus 6 bytes.
+ * 
+ * @tparam Snapshot Copyable type of each record. EventSnapshot by default.
+ * @tparam capacityBits log2 of the number of snapshots kept
+ */
+template<typename Snapshot = EventSnapshot, uint8_t capacityBits = 5>
+class FlightRecorder
+{
+public:
+  static constexpr uint16_t capacity = static_cast<uint16_t>(1u << capacityBits);
+
+  static_assert(capacityBits <= 14, "Counters need room above the capacity to tell how far the reader fell behind");
+
+  // Safe to call from an ISR
+  void record(const Snapshot &snapshot)
+  {
+    uint16_t head = _head;
+    _slots[head & mask] = snapshot;
+
+    // Finish writing the slot before the reader can see it
+    __asm__ __volatile__("" ::: "memory");
+
+    _head = head + 1;
+  }
+
+  // Copy the oldest unread snapshot. Returns false if there are none.
+  bool read(Snapshot &out)
+  {
+    for (;;)
+    {
+      uint16_t head = loadHead();
+
+      if (static_cast<uint16_t>(head - _tail) > capacity)
+      {
+        // Overwritten before they were read
+        _lost += static_cast<uint16_t>(head - _tail) - capacity;
+        _tail = head - capacity;
+      }
+
+      if (head == _tail)
+      {
+        return false;
+      }
+
+      out = _slots[_tail & mask];
+
+      // Finish copying the slot before checking whether it was overwritten
+      __asm__ __volatile__("" ::: "memory");
+
+      head = loadHead();
+
+      if (static_cast<uint16_t>(head - _tail) > capacity)
+      {
+        // Lapped while copying. Count it with the rest and try the next oldest.
+        continue;
+      }
+
+      _tail++;
+      return true;
+    }
+  }
+
+  // Snapshots waiting to be read, up to capacity
+  uint16_t available() const
+  {
+    uint16_t unread = loadHead() - _tail;
+    return unread > capacity ? capacity : unread;
+  }
+
+  // Snapshots overwritten before they were read
+  uint16_t lost() const
+  {
+    return _lost;
+  }
+
+  // Total snapshots recorded, modulo 2^16
+  uint16_t recorded() const
+  {
+    return loadHead();
+  }
+
+private:
+  static constexpr uint16_t mask = capacity - 1;
+
+  uint16_t loadHead() const
+  {
+    uint16_t head;
+
+    do
+    {
+      head = _head;
+    } while (head != _head);
+
+    return head;
+  }
+
+  Snapshot _slots[capacity];
+  volatile uint16_t _head = 0;
+  uint16_t _tail = 0;
+  uint16_t _lost = 0;
+};
+
+#endif
@@ -64,57 +64,274 @@ uint64_t divRound(uint64_t num, uint64_t denom)
   return (num + denom / 2) / denom;
 }
 
+template<>
+int16_t divRound(int16_t num, int16_t denom)
+{
+  return num < 0 ? (num - denom / 2) / denom : (num + denom / 2) / denom;
+}
+
+template<>
+int32_t divRound(int32_t num, int32_t denom)
+{
+  return num < 0 ? (num - denom / 2) / denom : (num + denom / 2) / denom;
+}
+
+template<>
+int64_t divRound(int64_t num, int64_t denom)
+{
+  return num < 0 ? (num - denom / 2) / denom : (num + denom / 2) / denom;
+}
+
 /*
 For fixed point math, DeltaXMulZ needs to be big enough to hold any deltaX * Z, DeltaYMulZ needs
 to be big enough to hold any deltaY * Z, and DivType must be able to hold deltaX * deltaY * z
  */
 template<>
-uint8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
 {
   return interpolateBilinearXFirst<uint16_t, uint16_t, uint32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
 {
   return interpolateBilinearXFirst<uint32_t, uint32_t, uint32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
 {
   return interpolateBilinearXFirst<uint16_t, uint32_t, uint32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
 {
-  return interpolateBilinearXFirst<uint16_t, uint32_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+  return interpolateBilinearXFirst<uint32_t, uint32_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
 {
   // Interpolate Y first since Y * Z is smaller than X * Z
   return interpolateBilinearYFirst<uint32_t, uint16_t, uint32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
 {
   // Interpolate Y first since Y * Z is smaller than X * Z
   return interpolateBilinearYFirst<uint32_t, uint32_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
 {
   return interpolateBilinearXFirst<uint32_t, uint32_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
 template<>
-uint16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
 {
   return interpolateBilinearXFirst<uint32_t, uint32_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
 }
 
+/*
+Signed cells need a sign bit on top of the unsigned sizes above. The int32_t DivTypes are exact
+fits: 128 * 255 * 65535 and 32768 * 255 * 255, plus rounding, are still under 2^31.
+ */
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearXFirst<int16_t, int16_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearXFirst<int16_t, int32_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  // Interpolate Y first since Y * Z is smaller than X * Z
+  return interpolateBilinearYFirst<int32_t, int16_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  // Interpolate Y first since Y * Z is smaller than X * Z
+  return interpolateBilinearYFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearXFirst<int16_t, int16_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int32_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearXFirst<int32_t, int32_t, int64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+// Dispatch to whichever kernel is fastest on this target
+
+template<>
+uint8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint8_t, uint8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint8_t, uint16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint16_t, uint8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint16_t, uint16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint8_t, uint8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint8_t, uint16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint16_t, uint8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+uint16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint16_t, uint16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint8_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint8_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint16_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint16_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint8_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint8_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint16_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<uint16_t, uint16_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<int8_t, int8_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<int8_t, int8_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int8_t interpolateBilinear(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<int16_t, int16_t, int8_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
+
+template<>
+int16_t interpolateBilinear(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11)
+{
+  return interpolateBilinearKernel<BilinearKernelTraits<int16_t, int16_t, int16_t>::kernel>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+}
@@ -23,7 +23,10 @@
 #include <stdint.h>
 
 #include "scale.h"
+#include "avrMul.h"
+#include "armDsp.h"
 #include "interpolateLinear.h"
+#include "tableLayout.h"
 
 template<typename T>
 inline T divRound(T num, T denom)
@@ -43,6 +46,79 @@ uint32_t divRound(uint32_t num, uint32_t denom);
 template<>
 uint64_t divRound(uint64_t num, uint64_t denom);
 
+// Signed versions round away from zero. denom must be positive.
+template<>
+int16_t divRound(int16_t num, int16_t denom);
+
+template<>
+int32_t divRound(int32_t num, int32_t denom);
+
+template<>
+int64_t divRound(int64_t num, int64_t denom);
+
+// z0 * delta1 + z1 * delta0, where the deltas are distances along an axis of type Axis that sum to
+// the distance between z0 and z1
+template<typename DeltaMulZ, typename Axis, typename Z>
+inline DeltaMulZ bilinearAxisSum(Z z0, Z z1, DeltaMulZ delta1, DeltaMulZ delta0)
+{
+  return static_cast<DeltaMulZ>(z0) * delta1 + static_cast<DeltaMulZ>(z1) * delta0;
+}
+
+#ifdef __AVR_ARCH__
+// Hardware multiplies for 16-bit sides. The sums fit the narrower products: 65535 * 255 is under
+// 2^24 and 65535 * 65535 is under 2^32.
+template<>
+inline uint32_t bilinearAxisSum<uint32_t, uint8_t, uint16_t>(uint16_t z0, uint16_t z1, uint32_t delta1, uint32_t delta0)
+{
+  return macU16U8(mulU16U8(z0, static_cast<uint8_t>(delta1)), z1, static_cast<uint8_t>(delta0));
+}
+
+template<>
+inline uint32_t bilinearAxisSum<uint32_t, uint16_t, uint8_t>(uint8_t z0, uint8_t z1, uint32_t delta1, uint32_t delta0)
+{
+  return macU16U8(mulU16U8(static_cast<uint16_t>(delta1), z0), static_cast<uint16_t>(delta0), z1);
+}
+
+template<>
+inline uint32_t bilinearAxisSum<uint32_t, uint16_t, uint16_t>(uint16_t z0, uint16_t z1, uint32_t delta1, uint32_t delta0)
+{
+  return macU16U16(mulU16U16(z0, static_cast<uint16_t>(delta1)), z1, static_cast<uint16_t>(delta0));
+}
+#endif
+
+#ifdef ENGINE_CALCULATIONS_ARM_DSP_HOOKS
+// One dual multiply-accumulate where cells and 8-bit axis deltas fit in signed halfwords
+template<>
+inline uint16_t bilinearAxisSum<uint16_t, uint8_t, uint8_t>(uint8_t z0, uint8_t z1, uint16_t delta1, uint16_t delta0)
+{
+  return static_cast<uint16_t>(dualMulAdd(z0, static_cast<int16_t>(delta1), z1, static_cast<int16_t>(delta0)));
+}
+
+template<>
+inline int16_t bilinearAxisSum<int16_t, uint8_t, int8_t>(int8_t z0, int8_t z1, int16_t delta1, int16_t delta0)
+{
+  return static_cast<int16_t>(dualMulAdd(z0, static_cast<int16_t>(delta1), z1, static_cast<int16_t>(delta0)));
+}
+
+template<>
+inline int32_t bilinearAxisSum<int32_t, uint8_t, int16_t>(int16_t z0, int16_t z1, int32_t delta1, int32_t delta0)
+{
+  return static_cast<int32_t>(dualMulAdd(z0, static_cast<int16_t>(delta1), z1, static_cast<int16_t>(delta0)));
+}
+
+template<>
+inline int16_t bilinearAxisSum<int16_t, int8_t, int8_t>(int8_t z0, int8_t z1, int16_t delta1, int16_t delta0)
+{
+  return static_cast<int16_t>(dualMulAdd(z0, static_cast<int16_t>(delta1), z1, static_cast<int16_t>(delta0)));
+}
+
+template<>
+inline int32_t bilinearAxisSum<int32_t, int8_t, int16_t>(int16_t z0, int16_t z1, int32_t delta1, int32_t delta0)
+{
+  return static_cast<int32_t>(dualMulAdd(z0, static_cast<int16_t>(delta1), z1, static_cast<int16_t>(delta0)));
+}
+#endif
+
 template<typename DeltaXMulZ, typename DeltaYMulZ, typename DivType,
   typename X, typename Y, typename Z>
 DivType interpolateBilinearXFirst(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01, Z z11)
@@ -52,24 +128,24 @@ DivType interpolateBilinearXFirst(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10
   // We're interpolating the rows first
   // Note: z subscripts are x,y. Ex: z01 is at x = 0, y = 1
 
-  // Upcast so we don't overflow fixed-point math when we multiply
-  DivType deltaX = static_cast<DivType>(x1 - x0);
-  DeltaXMulZ deltaX0 = static_cast<DeltaXMulZ>(x - x0);
-  DeltaXMulZ deltaX1 = static_cast<DeltaXMulZ>(x1 - x);
+  // Upcast so we don't overflow fixed-point math when we multiply, or int when we subtract signed inputs
+  DivType deltaX = static_cast<DivType>(x1) - static_cast<DivType>(x0);
+  DeltaXMulZ deltaX0 = static_cast<DeltaXMulZ>(x) - static_cast<DeltaXMulZ>(x0);
+  DeltaXMulZ deltaX1 = static_cast<DeltaXMulZ>(x1) - static_cast<DeltaXMulZ>(x);
 
   // z_row0_interpolated = [ z00 * (x1 - x) + z10 * (x - x0) ] / (x1 - x0)
-  DivType z_row0_num = static_cast<DivType>(static_cast<DeltaXMulZ>(z00) * deltaX1 + static_cast<DeltaXMulZ>(z10) * deltaX0);
+  DivType z_row0_num = static_cast<DivType>(bilinearAxisSum<DeltaXMulZ, X>(z00, z10, deltaX1, deltaX0));
 
   // z_row1_interpolated = [ z01 * (x1 - x) + z11 * (x - x0) ] / (x1 - x0)
-  DivType z_row1_num = static_cast<DivType>(static_cast<DeltaXMulZ>(z01) * deltaX1 + static_cast<DeltaXMulZ>(z11) * deltaX0);
+  DivType z_row1_num = static_cast<DivType>(bilinearAxisSum<DeltaXMulZ, X>(z01, z11, deltaX1, deltaX0));
 
   // Denominators are the same
   DivType z_row_denom = deltaX;
 
   // Upcast so we don't overflow fixed-point math when we multiply
-  DivType deltaY = static_cast<DivType>(y1 - y0);
-  DeltaYMulZ deltaY0 = static_cast<DeltaYMulZ>(y - y0);
-  DeltaYMulZ deltaY1 = static_cast<DeltaYMulZ>(y1 - y);
+  DivType deltaY = static_cast<DivType>(y1) - static_cast<DivType>(y0);
+  DeltaYMulZ deltaY0 = static_cast<DeltaYMulZ>(y) - static_cast<DeltaYMulZ>(y0);
+  DeltaYMulZ deltaY1 = static_cast<DeltaYMulZ>(y1) - static_cast<DeltaYMulZ>(y);
 
   // z_interpolated = [ z_row0_interpolated * (y1 - y) + z_row1_interpolated * (y - y0) ] / (y1 - y0)
   DivType z_num = z_row0_num * deltaY1 + z_row1_num * deltaY0;
@@ -112,6 +188,80 @@ Z interpolateBilinear(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01, Z z
   return static_cast<Z>(interpolateBilinearXFirst<DeltaXMulZ, DeltaYMulZ, DivType>(x, x0, x1, y, y0, y1, z00, z10, z01, z11) + roundingFactor<Z>());
 }
 
+/**
+ * @brief Interpolate with a specific kernel, rather than the one BilinearKernelTraits picks
+ * 
+ * interpolateBilinear() dispatches here. Called directly to benchmark kernels against each other.
+ * The float kernel works for any integer types; fixed-point kernels are specialized below.
+ */
+template<InterpolationKernel kernel, typename X, typename Y, typename Z>
+Z interpolateBilinearKernel(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01, Z z11)
+{
+  static_assert(kernel == InterpolationKernel::Float, "No fixed-point kernel for these types");
+
+  return roundFloat<Z>(interpolateBilinearXFirst<float, float, float>(x, x0, x1, y, y0, y1, z00, z10, z01, z11));
+}
+
+template<>
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11);
+
+template<>
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11);
+
+template<>
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11);
+
+template<>
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11);
+
+template<>
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11);
+
+template<>
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11);
+
+template<>
+uint8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11);
+
+template<>
+uint16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinearKernel<InterpolationKernel::FixedPoint>(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
 template<>
 uint8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, uint8_t z00, uint8_t z10, uint8_t z01, uint8_t z11);
 
@@ -136,66 +286,189 @@ uint8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, ui
 template<>
 uint16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, uint16_t z00, uint16_t z10, uint16_t z01, uint16_t z11);
 
-template<typename Z, typename X, typename Y, typename XArray, typename YArray, typename ZArray>
-Z interpolateBilinearTable(X x, Y y, size_t xLength, size_t yLength,
-                                    XArray xScale, YArray yScale, ZArray outputArray)
+template<>
+int8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(uint8_t x, uint8_t x0, uint8_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint8_t y, uint8_t y0, uint8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(uint16_t x, uint16_t x0, uint16_t x1, uint16_t y, uint16_t y0, uint16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinear(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(int8_t x, int8_t x0, int8_t x1, int8_t y, int8_t y0, int8_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+template<>
+int8_t interpolateBilinear(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int8_t z00, int8_t z10, int8_t z01, int8_t z11);
+
+template<>
+int16_t interpolateBilinear(int16_t x, int16_t x0, int16_t x1, int16_t y, int16_t y0, int16_t y1, int16_t z00, int16_t z10, int16_t z01, int16_t z11);
+
+// Where the inputs fall on the scales of a 2D table
+template<typename X, typename Y>
+struct BilinearTableLocation
 {
-  size_t xLowIndex;
+  X x;
   X xLow;
   X xHigh;
-
-  FindOnScaleResult xResult = findOnScale(x, xScale, xLength,  xLowIndex, xLow, xHigh);
-
-  size_t yLowIndex;
+  Y y;
   Y yLow;
   Y yHigh;
+  size_t xLowIndex;
+  size_t yLowIndex;
+  FindOnScaleResult xResult;
+  FindOnScaleResult yResult;
+};
+
+// Rounded (input - low) / (high - low) * 2^weightBits, in the scale's own type
+template<uint8_t weightBits, typename T, bool floating = IsFloatingPoint<T>::value>
+struct BilinearHighWeight
+{
+  typedef typename UnsignedForBits<sizeof(T) * 8>::type Difference;
+  typedef typename UnsignedForBits<sizeof(T) * 8 + weightBits>::type Shifted;
 
-  FindOnScaleResult yResult = findOnScale(y, yScale, yLength, yLowIndex, yLow, yHigh);
+  static uint16_t weight(T input, T low, T high)
+  {
+    // Differences modulo the unsigned counterpart are right for signed inputs too
+    Shifted delta = static_cast<Difference>(static_cast<Difference>(high) - static_cast<Difference>(low));
+    Shifted offset = static_cast<Difference>(static_cast<Difference>(input) - static_cast<Difference>(low));
+    return static_cast<uint16_t>(((offset << weightBits) + delta / 2) / delta);
+  }
+};
+
+template<uint8_t weightBits, typename T>
+struct BilinearHighWeight<weightBits, T, true>
+{
+  static uint16_t weight(T input, T low, T high)
+  {
+    return static_cast<uint16_t>((input - low) / (high - low) * static_cast<T>(1ul << weightBits) + static_cast<T>(0.5));
+  }
+};
+
+// Weight of the high value on one axis, out of 2^weightBits. 0 unless between two values.
+template<uint8_t weightBits, typename T>
+uint16_t bilinearHighWeight(FindOnScaleResult result, T input, T low, T high)
+{
+  static_assert(weightBits <= 15, "Weights must fit in uint16_t");
 
-  if (FindOnScaleResult::InBetween == yResult
-    && FindOnScaleResult::InBetween == xResult)
+  if (FindOnScaleResult::InBetween != result)
   {
-    size_t xHighIndex = xLowIndex + 1;
+    return 0;
+  }
+
+  return BilinearHighWeight<weightBits, T>::weight(input, low, high);
+}
+
+/**
+ * @brief Find the inputs on the scales of a 2D table
+ * 
+ * The location can be passed to interpolateBilinearLocation(), and to anything else that needs
+ * the same cells and weights, without searching the scales again.
+ * 
+ * @param xScale Array-like object that stores the x scale values. Must be indexable []
+ * @param yScale Array-like object that stores the y scale values. Must be indexable []
+ */
+template<typename X, typename Y, typename XArray, typename YArray>
+BilinearTableLocation<X, Y> locateBilinearTable(X x, Y y, size_t xLength, size_t yLength,
+                                                XArray xScale, YArray yScale)
+{
+  BilinearTableLocation<X, Y> location;
 
-    Z output00 = outputArray[yLowIndex     + xLowIndex  * xLength];
-    Z output10 = outputArray[yLowIndex     + xHighIndex * xLength];
-    Z output01 = outputArray[yLowIndex + 1 + xLowIndex  * xLength];
-    Z output11 = outputArray[yLowIndex + 1 + xHighIndex * xLength];
+  location.x = x;
+  location.y = y;
+  location.xResult = findOnScale(x, xScale, xLength, location.xLowIndex, location.xLow, location.xHigh);
+  location.yResult = findOnScale(y, yScale, yLength, location.yLowIndex, location.yLow, location.yHigh);
+
+  return location;
+}
+
+/**
+ * @brief Interpolate between the cells of a 2D table at a location from locateBilinearTable()
+ * 
+ * @tparam Z Type of output
+ * @tparam Layout How cells are stored in outputArray. Row-major by default.
+ * @param outputArray Array-like object that stores the cells. Must be indexable []
+ */
+template<typename Z, typename Layout = RowMajorLayout, typename X, typename Y, typename ZArray>
+Z interpolateBilinearLocation(const BilinearTableLocation<X, Y> &location, size_t xLength, size_t yLength,
+                              ZArray outputArray)
+{
+  if (FindOnScaleResult::InBetween == location.yResult
+    && FindOnScaleResult::InBetween == location.xResult)
+  {
+    Z output00, output10, output01, output11;
+    Layout::readCorners(outputArray, location.xLowIndex, location.yLowIndex, xLength, yLength,
+      output00, output10, output01, output11);
 
     return interpolateBilinear(
-        x, xLow, xHigh,
-        y, yLow, yHigh,
+        location.x, location.xLow, location.xHigh,
+        location.y, location.yLow, location.yHigh,
         output00, output10, output01, output11);
   }
-  else if (FindOnScaleResult::InBetween == yResult)
+  else if (FindOnScaleResult::InBetween == location.yResult)
   {
     // We're in-between rows, but fully left, right, or on a column exactly
     // Need to interpolate between rows in a single column
-    size_t yHighIndex = yLowIndex + 1;
-    size_t output0Index = yLowIndex  * xLength + xLowIndex;
-    size_t output1Index = yHighIndex * xLength + xLowIndex;
-
-    Z output0 = outputArray[output0Index];
-    Z output1 = outputArray[output1Index];
+    Z output0, output1;
+    Layout::readYPair(outputArray, location.xLowIndex, location.yLowIndex, xLength, yLength, output0, output1);
 
-    return interpolateLinear(y, yLow, yHigh, output0, output1);
+    return interpolateLinear(location.y, location.yLow, location.yHigh, output0, output1);
   }
-  else if (FindOnScaleResult::InBetween == xResult)
+  else if (FindOnScaleResult::InBetween == location.xResult)
   {
     // We're in-between columns, but fully top, bottom, or on a row exactly
     // Need to interpolate between columns in a single row
-    size_t output0Index = yLowIndex * xLength + xLowIndex;
-
-    Z output0 = outputArray[output0Index];
-    Z output1 = outputArray[output0Index + 1];
+    Z output0, output1;
+    Layout::readXPair(outputArray, location.xLowIndex, location.yLowIndex, xLength, yLength, output0, output1);
 
-    return interpolateLinear(x, xLow, xHigh, output0, output1);
+    return interpolateLinear(location.x, location.xLow, location.xHigh, output0, output1);
   }
   else
   {
-    size_t output0Index = yLowIndex * xLength + xLowIndex;
-    return outputArray[output0Index];
+    return outputArray[Layout::index(location.xLowIndex, location.yLowIndex, xLength, yLength)];
   }
 }
 
+/**
+ * @brief Interpolate between the cells of a 2D table
+ * 
+ * @tparam Z Type of output
+ * @tparam Layout How cells are stored in outputArray. Row-major by default.
+ * @param x x input
+ * @param y y input
+ * @param xLength Length of x scale
+ * @param yLength Length of y scale
+ * @param xScale Array-like object that stores the x scale values. Must be indexable []
+ * @param yScale Array-like object that stores the y scale values. Must be indexable []
+ * @param outputArray Array-like object that stores the cells. Must be indexable []
+ * @return Z 
+ */
+template<typename Z, typename Layout = RowMajorLayout,
+  typename X, typename Y, typename XArray, typename YArray, typename ZArray>
+Z interpolateBilinearTable(X x, Y y, size_t xLength, size_t yLength,
+                                    XArray xScale, YArray yScale, ZArray outputArray)
+{
+  BilinearTableLocation<X, Y> location = locateBilinearTable(x, y, xLength, yLength, xScale, yScale);
+
+  return interpolateBilinearLocation<Z, Layout>(location, xLength, yLength, outputArray);
+}
+
 #endif
\ No newline at end of file
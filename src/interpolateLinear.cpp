@@ -15,62 +15,220 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "interpolateLinear.h"
+#include "fixedPoint.h"
 
 template<>
-uint8_t interpolateLinear<uint8_t, uint8_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint8_t output0, uint8_t output1)
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint8_t output0, uint8_t output1)
 {
   return static_cast<uint8_t>(interpolateLinearFixedUnsigned<uint16_t, 8>(input, inputLow, inputHigh, output0, output1));
 }
 
 template<>
-uint16_t interpolateLinear<uint8_t, uint16_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint16_t output0, uint16_t output1)
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint16_t output0, uint16_t output1)
+{
+  return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint32_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint32_t output0, uint32_t output1)
+{
+  return static_cast<uint32_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint8_t output0, uint8_t output1)
+{
+  return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint32_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint16_t output0, uint16_t output1)
 {
   return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint32_t, 8>(input, inputLow, inputHigh, output0, output1));
 }
 
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint32_t output0, uint32_t output1)
+{
+  return static_cast<uint32_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint8_t output0, uint8_t output1)
+{
+  return static_cast<uint8_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint16_t output0, uint16_t output1)
+{
+  return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint32_t output0, uint32_t output1)
+{
+  return static_cast<uint32_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+/*
+Signed outputs need a sign bit on top of the output and slope shift bits. Shifting by the input
+bits keeps the result within 1. 16-bit inputs and outputs would need 33 bits, so they shift by
+14, leaving headroom for rounding in 32 bits, and are within 2.
+ */
+typedef SignedForBits<8 + 1 + 8>::type SignedSlope8In8Out;
+typedef SignedForBits<16 + 1 + 8>::type SignedSlope8In16Out;
+typedef SignedForBits<8 + 1 + 16>::type SignedSlope16In8Out;
+typedef SignedForBits<16 + 1 + 14>::type SignedSlope16In16Out;
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int8_t output0, int8_t output1)
+{
+  return static_cast<int8_t>(interpolateLinearFixedSigned<SignedSlope8In8Out, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int16_t output0, int16_t output1)
+{
+  return static_cast<int16_t>(interpolateLinearFixedSigned<SignedSlope8In16Out, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int8_t output0, int8_t output1)
+{
+  return static_cast<int8_t>(interpolateLinearFixedSigned<SignedSlope16In8Out, 16>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int16_t output0, int16_t output1)
+{
+  return static_cast<int16_t>(interpolateLinearFixedSigned<SignedSlope16In16Out, 14>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int8_t input, int8_t inputLow, int8_t inputHigh, int8_t output0, int8_t output1)
+{
+  return static_cast<int8_t>(interpolateLinearFixedSigned<SignedSlope8In8Out, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int8_t input, int8_t inputLow, int8_t inputHigh, int16_t output0, int16_t output1)
+{
+  return static_cast<int16_t>(interpolateLinearFixedSigned<SignedSlope8In16Out, 8>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int16_t input, int16_t inputLow, int16_t inputHigh, int8_t output0, int8_t output1)
+{
+  return static_cast<int8_t>(interpolateLinearFixedSigned<SignedSlope16In8Out, 16>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int16_t input, int16_t inputLow, int16_t inputHigh, int16_t output0, int16_t output1)
+{
+  return static_cast<int16_t>(interpolateLinearFixedSigned<SignedSlope16In16Out, 14>(input, inputLow, inputHigh, output0, output1));
+}
+
+// Dispatch to whichever kernel is fastest on this target
+
+template<>
+uint8_t interpolateLinear<uint8_t, uint8_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint8_t output0, uint8_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint8_t, uint8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+uint16_t interpolateLinear<uint8_t, uint16_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint16_t output0, uint16_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint8_t, uint16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
 template<>
 uint32_t interpolateLinear<uint8_t, uint32_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint32_t output0, uint32_t output1)
 {
-  // Floating point is faster than fixed point
-  return static_cast<uint32_t>(interpolateLinearUnsigned<uint8_t, uint32_t, float>(input, inputLow, inputHigh, output0, output1) + 0.5);
+  return interpolateLinearKernel<LinearKernelTraits<uint8_t, uint32_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint8_t interpolateLinear<uint16_t, uint8_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint8_t output0, uint8_t output1)
 {
-  return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint32_t, 8>(input, inputLow, inputHigh, output0, output1));
+  return interpolateLinearKernel<LinearKernelTraits<uint16_t, uint8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint16_t interpolateLinear<uint16_t, uint16_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint16_t output0, uint16_t output1)
 {
-  return static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint32_t, 8>(input, inputLow, inputHigh, output0, output1));
+  return interpolateLinearKernel<LinearKernelTraits<uint16_t, uint16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint32_t interpolateLinear<uint16_t, uint32_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint32_t output0, uint32_t output1)
 {
-  // Floating point is faster than fixed point
-  return static_cast<uint32_t>(interpolateLinearUnsigned<uint16_t, uint32_t, float>(input, inputLow, inputHigh, output0, output1) + 0.5);
+  return interpolateLinearKernel<LinearKernelTraits<uint16_t, uint32_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint8_t interpolateLinear<uint32_t, uint8_t>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint8_t output0, uint8_t output1)
 {
-  // Floating point is faster than fixed point
-  return static_cast<uint8_t>(interpolateLinearUnsigned<uint32_t, uint8_t, float>(input, inputLow, inputHigh, output0, output1) + 0.5);
+  return interpolateLinearKernel<LinearKernelTraits<uint32_t, uint8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint16_t interpolateLinear<uint32_t, uint16_t>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint16_t output0, uint16_t output1)
 {
-  // Floating point is faster than fixed point
-  return static_cast<uint16_t>(interpolateLinearUnsigned<uint32_t, uint16_t, float>(input, inputLow, inputHigh, output0, output1) + 0.5);
+  return interpolateLinearKernel<LinearKernelTraits<uint32_t, uint16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
 
 template<>
 uint32_t interpolateLinear<uint32_t, uint32_t>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint32_t output0, uint32_t output1)
 {
-  // Floating point is faster than fixed point
-  return static_cast<uint32_t>(interpolateLinearUnsigned<uint32_t, uint32_t, float>(input, inputLow, inputHigh, output0, output1) + 0.5);
+  return interpolateLinearKernel<LinearKernelTraits<uint32_t, uint32_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int8_t interpolateLinear<uint8_t, int8_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int8_t output0, int8_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint8_t, int8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int16_t interpolateLinear<uint8_t, int16_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int16_t output0, int16_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint8_t, int16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int8_t interpolateLinear<uint16_t, int8_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int8_t output0, int8_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint16_t, int8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int16_t interpolateLinear<uint16_t, int16_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int16_t output0, int16_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<uint16_t, int16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int8_t interpolateLinear<int8_t, int8_t>(int8_t input, int8_t inputLow, int8_t inputHigh, int8_t output0, int8_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<int8_t, int8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int16_t interpolateLinear<int8_t, int16_t>(int8_t input, int8_t inputLow, int8_t inputHigh, int16_t output0, int16_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<int8_t, int16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int8_t interpolateLinear<int16_t, int8_t>(int16_t input, int16_t inputLow, int16_t inputHigh, int8_t output0, int8_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<int16_t, int8_t>::kernel>(input, inputLow, inputHigh, output0, output1);
+}
+
+template<>
+int16_t interpolateLinear<int16_t, int16_t>(int16_t input, int16_t inputLow, int16_t inputHigh, int16_t output0, int16_t output1)
+{
+  return interpolateLinearKernel<LinearKernelTraits<int16_t, int16_t>::kernel>(input, inputLow, inputHigh, output0, output1);
 }
@@ -23,6 +23,9 @@
 #include <stdint.h>
 
 #include "scale.h"
+#include "fixedPoint.h"
+#include "avrMul.h"
+#include "kernelTraits.h"
 
 // Base case for float, double, or signed custom types that support + - / *
 template<typename InputType, typename OutputType, typename SlopeType = OutputType>
@@ -48,19 +51,64 @@ SlopeType interpolateLinearUnsigned(InputType input, InputType inputLow, InputTy
   }
 }
 
+// slope * offset for interpolateLinearFixedUnsigned(). The product is at most the output range
+// shifted left by slopeShift.
+template<typename SlopeType, uint8_t slopeShift, typename InputType, typename OutputType>
+inline SlopeType fixedSlopeOffset(SlopeType slope, SlopeType offset)
+{
+  return slope * offset;
+}
+
+#ifdef __AVR_ARCH__
+// 8-bit outputs have 16-bit slopes, so one 16x16 hardware multiply does
+template<>
+inline uint32_t fixedSlopeOffset<uint32_t, 8, uint16_t, uint8_t>(uint32_t slope, uint32_t offset)
+{
+  return mulU16U16(static_cast<uint16_t>(slope), static_cast<uint16_t>(offset));
+}
+
+// 16-bit outputs have 24-bit slopes, but the product fits in 24 bits, so only the low byte of the
+// top byte's product is needed
+template<>
+inline uint32_t fixedSlopeOffset<uint32_t, 8, uint8_t, uint16_t>(uint32_t slope, uint32_t offset)
+{
+  uint8_t top = static_cast<uint8_t>(static_cast<uint8_t>(slope >> 16) * static_cast<uint8_t>(offset));
+  return mulU16U8(static_cast<uint16_t>(slope), static_cast<uint8_t>(offset)) + (static_cast<Product24>(top) << 16);
+}
+#endif
+
 #define max(a,b) ((a)>(b)?(a):(b))
 
 template<typename SlopeType, uint8_t slopeShift = 0, typename InputType, typename OutputType>
 SlopeType interpolateLinearFixedSigned(InputType input, InputType inputLow, InputType inputHigh, OutputType output0, OutputType output1)
 {
-  // SlopeType needs to be big enough to handle OutputType / InputType
-  static_assert(sizeof(SlopeType) * 8 >= max(sizeof(OutputType) * 8 + slopeShift, sizeof(InputType) * 8), "SlopeType too small");
+  // SlopeType needs to be big enough to handle signed differences of OutputType / InputType
+  static_assert(sizeof(SlopeType) * 8 >= max(sizeof(OutputType) * 8 + 1 + slopeShift, sizeof(InputType) * 8 + 1), "SlopeType too small");
 
   // Shift for fixed-point math
   constexpr SlopeType shiftMul = static_cast<SlopeType>(1ul << slopeShift);
 
-  SlopeType slope = (static_cast<SlopeType>(output1 - output0) * shiftMul) / static_cast<SlopeType>(inputHigh - inputLow);
-  return (slope * static_cast<SlopeType>(input - inputLow)) / static_cast<SlopeType>(shiftMul) + static_cast<SlopeType>(output0);
+  // Add 1 to the highest digit that we're thowing away to round instead of truncating
+  constexpr SlopeType round = slopeShift > 0 ? static_cast<SlopeType>(1ul << (slopeShift - 1)) : 0;
+
+  // Upcast before subtracting so differences of signed types can't overflow int
+  SlopeType outputDelta = (static_cast<SlopeType>(output1) - static_cast<SlopeType>(output0)) * shiftMul;
+  SlopeType inputDelta = static_cast<SlopeType>(inputHigh) - static_cast<SlopeType>(inputLow);
+
+  // Round the slope too, or its error is multiplied by the input offset
+  SlopeType slope = (outputDelta < 0 ? outputDelta - inputDelta / 2 : outputDelta + inputDelta / 2) / inputDelta;
+  SlopeType offset = slope * (static_cast<SlopeType>(input) - static_cast<SlopeType>(inputLow));
+
+  // Round away from zero so negative outputs mirror positive ones
+  SlopeType result = offset < 0
+    ? static_cast<SlopeType>(output0) - (round - offset) / shiftMul
+    : (offset + round) / shiftMul + static_cast<SlopeType>(output0);
+
+  // The rounded slope can carry the result past an endpoint, and past the limits of OutputType
+  // when the endpoint is at a limit, so clamp before the caller narrows it
+  SlopeType outputMin = static_cast<SlopeType>(output0 < output1 ? output0 : output1);
+  SlopeType outputMax = static_cast<SlopeType>(output0 < output1 ? output1 : output0);
+  return result < outputMin ? outputMin : (result > outputMax ? outputMax : result);
 }
 
 template<typename SlopeType, uint8_t slopeShift = 0, typename InputType, typename OutputType>
@@ -78,18 +126,93 @@ SlopeType interpolateLinearFixedUnsigned(InputType input, InputType inputLow, In
   if (output1 > output0)
   {
     SlopeType slope = (static_cast<SlopeType>(output1 - output0) * shiftMul) / static_cast<SlopeType>(inputHigh - inputLow);
-    return (slope * static_cast<SlopeType>(input - inputLow) + round) / static_cast<SlopeType>(shiftMul) + static_cast<SlopeType>(output0);
+    return (fixedSlopeOffset<SlopeType, slopeShift, InputType, OutputType>(slope, static_cast<SlopeType>(input - inputLow)) + round) / static_cast<SlopeType>(shiftMul) + static_cast<SlopeType>(output0);
   }
   else
   {
     // Assume we're dealing with unsigned fixed-point math
     SlopeType slope = (static_cast<SlopeType>(output0 - output1) * shiftMul) / static_cast<SlopeType>(inputHigh - inputLow);
-    return static_cast<SlopeType>(output0) - (slope * static_cast<SlopeType>(input - inputLow) + round) / static_cast<SlopeType>(shiftMul);
+    return static_cast<SlopeType>(output0) - (fixedSlopeOffset<SlopeType, slopeShift, InputType, OutputType>(slope, static_cast<SlopeType>(input - inputLow)) + round) / static_cast<SlopeType>(shiftMul);
   }
 }
 
 #undef max
 
+// Round to the nearest integer, away from zero on ties
+template<typename T>
+T roundFloat(float value)
+{
+  return static_cast<T>(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+/**
+ * @brief Interpolate with a specific kernel, rather than the one LinearKernelTraits picks
+ * 
+ * interpolateLinear() dispatches here. Called directly to benchmark kernels against each other.
+ * The float kernel works for any integer types; fixed-point kernels are specialized below.
+ */
+template<InterpolationKernel kernel, typename InputType, typename OutputType>
+OutputType interpolateLinearKernel(InputType input, InputType inputLow, InputType inputHigh, OutputType output0, OutputType output1)
+{
+  static_assert(kernel == InterpolationKernel::Float, "No fixed-point kernel for these types");
+
+  // Unsigned outputs can't be subtracted in either order
+  return roundFloat<OutputType>(IntegerLimits<OutputType>::isSigned
+    ? interpolateLinear<InputType, OutputType, float>(input, inputLow, inputHigh, output0, output1)
+    : interpolateLinearUnsigned<InputType, OutputType, float>(input, inputLow, inputHigh, output0, output1));
+}
+
+template<>
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint8_t output0, uint8_t output1);
+
+template<>
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint16_t output0, uint16_t output1);
+
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint32_t output0, uint32_t output1);
+
+template<>
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint8_t output0, uint8_t output1);
+
+template<>
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint16_t output0, uint16_t output1);
+
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, uint32_t output0, uint32_t output1);
+
+template<>
+uint8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint8_t output0, uint8_t output1);
+
+template<>
+uint16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint16_t output0, uint16_t output1);
+
+template<>
+uint32_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint32_t output0, uint32_t output1);
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int8_t input, int8_t inputLow, int8_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int8_t input, int8_t inputLow, int8_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int16_t input, int16_t inputLow, int16_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinearKernel<InterpolationKernel::FixedPoint>(int16_t input, int16_t inputLow, int16_t inputHigh, int16_t output0, int16_t output1);
+
 template<>
 uint8_t interpolateLinear<uint8_t, uint8_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, uint8_t output0, uint8_t output1);
 
@@ -117,6 +240,38 @@ uint16_t interpolateLinear<uint32_t, uint16_t>(uint32_t input, uint32_t inputLow
 template<>
 uint32_t interpolateLinear<uint32_t, uint32_t>(uint32_t input, uint32_t inputLow, uint32_t inputHigh, uint32_t output0, uint32_t output1);
 
+template<>
+int8_t interpolateLinear<uint8_t, int8_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinear<uint8_t, int16_t>(uint8_t input, uint8_t inputLow, uint8_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinear<uint16_t, int8_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinear<uint16_t, int16_t>(uint16_t input, uint16_t inputLow, uint16_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinear<int8_t, int8_t>(int8_t input, int8_t inputLow, int8_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinear<int8_t, int16_t>(int8_t input, int8_t inputLow, int8_t inputHigh, int16_t output0, int16_t output1);
+
+template<>
+int8_t interpolateLinear<int16_t, int8_t>(int16_t input, int16_t inputLow, int16_t inputHigh, int8_t output0, int8_t output1);
+
+template<>
+int16_t interpolateLinear<int16_t, int16_t>(int16_t input, int16_t inputLow, int16_t inputHigh, int16_t output0, int16_t output1);
+
+
+// Read two adjacent table values. Overload for array types that can read both faster than one at a time.
+template<typename ArrayT, typename T>
+inline void readTablePair(ArrayT array, size_t index, T &first, T &second)
+{
+  first = array[index];
+  second = array[index + 1];
+}
 
 template<typename OutputType, typename InputType, typename InputArray, typename OutputArray>
 OutputType interpolateLinearTable(InputType input, size_t length, InputArray inputScale, OutputArray outputArray)
@@ -129,8 +284,8 @@ OutputType interpolateLinearTable(InputType input, size_t length, InputArray inp
   // Need to interpolate
   if (FindOnScaleResult::InBetween == result)
   {
-    OutputType output0 = outputArray[index];
-    OutputType output1 = outputArray[index + 1];
+    OutputType output0, output1;
+    readTablePair(outputArray, index, output0, output1);
 
     return interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, output0, output1);
   }
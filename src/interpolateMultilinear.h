@@ -0,0 +1,183 @@
+// Multilinear Interpolation
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_INTERPOLATE_MULTILINEAR_H_
+#define ENGINE_CALCULATIONS_INTERPOLATE_MULTILINEAR_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scale.h"
+#include "interpolateLinear.h"
+#include "interpolateBilinear.h"
+
+// Where the input falls on one axis of a multilinear table
+template<typename DivType>
+struct MultilinearAxis
+{
+  size_t lowIndex;
+  size_t stride;
+  DivType weight0; // high - input
+  DivType weight1; // input - low
+  bool interpolate;
+};
+
+// Final division, rounded the same way as interpolateBilinear()
+template<typename Z, typename DivType>
+struct MultilinearRound
+{
+  static Z apply(DivType num, DivType denom)
+  {
+    return static_cast<Z>(divRound(num, denom));
+  }
+};
+
+template<typename Z>
+struct MultilinearRound<Z, float>
+{
+  static Z apply(float num, float denom)
+  {
+    return static_cast<Z>(num / denom + roundingFactor<Z>());
+  }
+};
+
+template<typename Z>
+struct MultilinearRound<Z, double>
+{
+  static Z apply(double num, double denom)
+  {
+    return static_cast<Z>(num / denom + roundingFactor<Z>());
+  }
+};
+
+/*
+Numerator of the interpolation over axes 0 to axis, unrolled at compile time. Each axis combines
+the numerators of its low and high sub-tables, weighted by distance from the input. Division is
+left until the end so there's only one rounding, like interpolateBilinearXFirst().
+ */
+template<uint8_t axis>
+struct MultilinearReduce
+{
+  template<typename Z, typename FirstMulType, typename DivType, typename ZArray>
+  static DivType numerator(const MultilinearAxis<DivType> *axes, ZArray cells, size_t offset)
+  {
+    const MultilinearAxis<DivType> &current = axes[axis];
+    size_t lowOffset = offset + current.lowIndex * current.stride;
+
+    DivType low = MultilinearReduce<axis - 1>::template numerator<Z, FirstMulType>(axes, cells, lowOffset);
+
+    if (!current.interpolate)
+    {
+      return low;
+    }
+
+    DivType high = MultilinearReduce<axis - 1>::template numerator<Z, FirstMulType>(axes, cells,
+      lowOffset + current.stride);
+
+    return low * current.weight0 + high * current.weight1;
+  }
+};
+
+template<>
+struct MultilinearReduce<0>
+{
+  template<typename Z, typename FirstMulType, typename DivType, typename ZArray>
+  static DivType numerator(const MultilinearAxis<DivType> *axes, ZArray cells, size_t offset)
+  {
+    const MultilinearAxis<DivType> &current = axes[0];
+    size_t index = offset + current.lowIndex;
+
+    if (!current.interpolate)
+    {
+      Z z = cells[index];
+      return static_cast<DivType>(z);
+    }
+
+    // Axis 0 is stored contiguously
+    Z z0, z1;
+    readTablePair(cells, index, z0, z1);
+
+    return static_cast<DivType>(
+      static_cast<FirstMulType>(z0) * static_cast<FirstMulType>(current.weight0)
+      + static_cast<FirstMulType>(z1) * static_cast<FirstMulType>(current.weight1));
+  }
+};
+
+/**
+ * @brief Interpolate between the cells of an N-dimensional table
+ * 
+ * Cells are stored with axis 0 varying fastest, then axis 1, and so on. For N = 2 that's the same
+ * as RowMajorLayout with x as axis 0.
+ * 
+ * Inside the table, N = 2 matches interpolateBilinear() bit-for-bit when given the same
+ * FirstMulType (DeltaXMulZ) and DivType. Axes where the input is off the scale or exactly on a
+ * value aren't interpolated. Unlike interpolateBilinearTable(), the remaining axes still share
+ * one rounded division, so results on edges can differ from it by 1.
+ * 
+ * @tparam N Number of axes
+ * @tparam Z Type of cell
+ * @tparam DivType Type that holds the sum of cells times the product of all axis deltas. Integer
+ *   types need N axis widths plus the cell width
+ * @tparam FirstMulType Type that holds a cell times an axis 0 delta
+ * @param inputs N inputs, one per axis
+ * @param lengths N scale lengths
+ * @param scales N array-like scales. Must be indexable []
+ * @param cells Array-like object that stores the cells. Must be indexable []
+ * @return Z 
+ */
+template<uint8_t N, typename Z, typename DivType = float, typename FirstMulType = DivType,
+  typename T, typename ScaleArray, typename ZArray>
+Z interpolateMultilinearTable(const T *inputs, const size_t *lengths, const ScaleArray *scales, ZArray cells)
+{
+  static_assert(N > 0, "Need at least one axis");
+  // Integer numerators are a cell times one delta per axis
+  static_assert(IsFloatingPoint<DivType>::value || sizeof(DivType) * 8 >= N * sizeof(T) * 8 + sizeof(Z) * 8,
+    "DivType too small for N axis deltas times a cell");
+  static_assert(IsFloatingPoint<FirstMulType>::value || sizeof(FirstMulType) * 8 >= sizeof(T) * 8 + sizeof(Z) * 8,
+    "FirstMulType too small for an axis 0 delta times a cell");
+
+  MultilinearAxis<DivType> axes[N];
+  DivType denom = 1;
+  size_t stride = 1;
+
+  for (uint8_t i = 0; i < N; i++)
+  {
+    T low;
+    T high;
+
+    FindOnScaleResult result = findOnScale(inputs[i], scales[i], lengths[i], axes[i].lowIndex, low, high);
+
+    axes[i].stride = stride;
+    stride *= lengths[i];
+
+    axes[i].interpolate = FindOnScaleResult::InBetween == result;
+
+    if (axes[i].interpolate)
+    {
+      axes[i].weight0 = static_cast<DivType>(high - inputs[i]);
+      axes[i].weight1 = static_cast<DivType>(inputs[i] - low);
+      denom = denom * static_cast<DivType>(high - low);
+    }
+  }
+
+  DivType num = MultilinearReduce<N - 1>::template numerator<Z, FirstMulType>(axes, cells, 0);
+
+  return MultilinearRound<Z, DivType>::apply(num, denom);
+}
+
+#endif
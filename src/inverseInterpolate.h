@@ -0,0 +1,301 @@
+// Inverse Interpolation
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_INVERSE_INTERPOLATE_H_
+#define ENGINE_CALCULATIONS_INVERSE_INTERPOLATE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scale.h"
+#include "fixedPoint.h"
+#include "tableLayout.h"
+#include "interpolateLinear.h"
+#include "interpolateBilinear.h"
+
+/*
+Inverse lookups find the input that gives a target output, like target load -> throttle angle.
+The outputs must be monotone: all ascending or all descending, with no flat segments. The
+bracketing output segment is found by binary search, then solved directly for the input.
+
+FindOnScaleResult is about the target on the outputs. When off the outputs, the input at the
+nearest end of the outputs is returned, like interpolateLinearTable() does off its scale.
+ */
+
+// Reads an array back to front, so descending values can be searched as ascending ones
+template<typename ArrayT>
+struct ReversedArray
+{
+  ArrayT array;
+  size_t length;
+
+  auto operator[](size_t index) const -> decltype(array[index])
+  {
+    return array[length - 1 - index];
+  }
+};
+
+// Input within one output segment that gives the target, rounded half away from zero. Integer
+// types are solved exactly in a type wide enough for the product of both deltas, where
+// interpolateLinear() with the roles swapped would truncate slopes below its fixed-point
+// resolution, like 1/256 for a uint16 load -> uint8 throttle. Floating-point types, and integers
+// whose product would overflow 64 bits, are solved in floating point like the float kernel.
+template<typename InputType, typename OutputType,
+  bool exact = !IsFloatingPoint<InputType>::value && !IsFloatingPoint<OutputType>::value
+               && (sizeof(OutputType) + sizeof(InputType)) * 8 + 2 <= 64>
+struct InverseSegment
+{
+  typedef typename SignedForBits<sizeof(OutputType) * 8 + sizeof(InputType) * 8 + 2>::type Wide;
+
+  static InputType solve(OutputType target, OutputType outputLow, OutputType outputHigh,
+                         InputType input0, InputType input1)
+  {
+    Wide outputDelta = static_cast<Wide>(outputHigh) - static_cast<Wide>(outputLow);
+    Wide product = (static_cast<Wide>(target) - static_cast<Wide>(outputLow))
+                 * (static_cast<Wide>(input1) - static_cast<Wide>(input0));
+    Wide offset = (product < 0 ? product - outputDelta / 2 : product + outputDelta / 2) / outputDelta;
+
+    return static_cast<InputType>(static_cast<Wide>(input0) + offset);
+  }
+};
+
+template<typename InputType, typename OutputType>
+struct InverseSegment<InputType, OutputType, false>
+{
+  // float, or double if either type is
+  typedef decltype(InputType() + OutputType() + 0.0f) Real;
+
+  static InputType solve(OutputType target, OutputType outputLow, OutputType outputHigh,
+                         InputType input0, InputType input1)
+  {
+    Real input = static_cast<Real>(input0)
+               + (static_cast<Real>(target) - static_cast<Real>(outputLow))
+               * (static_cast<Real>(input1) - static_cast<Real>(input0))
+               / (static_cast<Real>(outputHigh) - static_cast<Real>(outputLow));
+
+    if (IsFloatingPoint<InputType>::value)
+    {
+      return static_cast<InputType>(input);
+    }
+
+    return static_cast<InputType>(input < 0 ? input - static_cast<Real>(0.5) : input + static_cast<Real>(0.5));
+  }
+};
+
+template<typename InputType, typename OutputType>
+InputType inverseInterpolateSegment(OutputType target, OutputType outputLow, OutputType outputHigh,
+                                    InputType input0, InputType input1)
+{
+  return InverseSegment<InputType, OutputType>::solve(target, outputLow, outputHigh, input0, input1);
+}
+
+/**
+ * @brief Find the input that gives the target output of a linear table
+ * 
+ * @tparam InputType Type of input
+ * @tparam OutputType Type of output
+ * @param target Output to find the input for
+ * @param length Length of input scale and outputs
+ * @param inputScale Array-like object that stores the input scale values. Must be indexable []
+ * @param outputArray Array-like object that stores monotone outputs. Must be indexable []
+ * @param outResult Where the target is on the outputs
+ * @return InputType Input that gives the target
+ */
+template<typename InputType, typename OutputType, typename InputArray, typename OutputArray>
+InputType inverseInterpolateLinearTable(OutputType target, size_t length, InputArray inputScale,
+                                        OutputArray outputArray, FindOnScaleResult &outResult)
+{
+  size_t index;
+  OutputType outputLow, outputHigh;
+
+  if (outputArray[0] <= outputArray[length - 1])
+  {
+    outResult = findOnScaleBinary(target, outputArray, length, index, outputLow, outputHigh);
+
+    if (FindOnScaleResult::InBetween == outResult)
+    {
+      InputType input0, input1;
+      readTablePair(inputScale, index, input0, input1);
+
+      return inverseInterpolateSegment(target, outputLow, outputHigh, input0, input1);
+    }
+
+    return inputScale[index];
+  }
+  else
+  {
+    ReversedArray<OutputArray> reversed = {outputArray, length};
+    outResult = findOnScaleBinary(target, reversed, length, index, outputLow, outputHigh);
+
+    // Index of outputLow in the outputs. outputHigh is the one before it.
+    size_t lowIndex = length - 1 - index;
+
+    if (FindOnScaleResult::InBetween == outResult)
+    {
+      InputType input0, input1;
+      readTablePair(inputScale, lowIndex - 1, input1, input0);
+
+      return inverseInterpolateSegment(target, outputLow, outputHigh, input0, input1);
+    }
+
+    return inputScale[lowIndex];
+  }
+}
+
+template<typename InputType, typename OutputType, typename InputArray, typename OutputArray>
+InputType inverseInterpolateLinearTable(OutputType target, size_t length, InputArray inputScale, OutputArray outputArray)
+{
+  FindOnScaleResult result;
+  return inverseInterpolateLinearTable<InputType>(target, length, inputScale, outputArray, result);
+}
+
+// Cells of a 2D table along y at a fixed x, interpolated between columns as they are read.
+// Uses the bilinear kernel with no y weight, so the column agrees with interpolateBilinearTable()
+// between rows, where interpolateLinear() would round the slope differently.
+template<typename Z, typename Layout, typename X, typename Y, typename ZArray>
+struct BilinearColumn
+{
+  X x;
+  X xLow;
+  X xHigh;
+  size_t xLowIndex;
+  FindOnScaleResult xResult;
+  size_t xLength;
+  size_t yLength;
+  ZArray cells;
+
+  Z operator[](size_t yIndex) const
+  {
+    if (FindOnScaleResult::InBetween == xResult)
+    {
+      Z z0, z1;
+      Layout::readXPair(cells, xLowIndex, yIndex, xLength, yLength, z0, z1);
+
+      return interpolateBilinear(x, xLow, xHigh, Y(0), Y(0), Y(1), z0, z1, z0, z1);
+    }
+
+    return cells[Layout::index(xLowIndex, yIndex, xLength, yLength)];
+  }
+};
+
+// Cells of a 2D table along x at a fixed y, interpolated between rows as they are read
+template<typename Z, typename Layout, typename X, typename Y, typename ZArray>
+struct BilinearRow
+{
+  Y y;
+  Y yLow;
+  Y yHigh;
+  size_t yLowIndex;
+  FindOnScaleResult yResult;
+  size_t xLength;
+  size_t yLength;
+  ZArray cells;
+
+  Z operator[](size_t xIndex) const
+  {
+    if (FindOnScaleResult::InBetween == yResult)
+    {
+      Z z0, z1;
+      Layout::readYPair(cells, xIndex, yLowIndex, xLength, yLength, z0, z1);
+
+      return interpolateBilinear(X(0), X(0), X(1), y, yLow, yHigh, z0, z0, z1, z1);
+    }
+
+    return cells[Layout::index(xIndex, yLowIndex, xLength, yLength)];
+  }
+};
+
+/**
+ * @brief Find the y that gives the target output of a 2D table at a fixed x
+ * 
+ * A bilinear table is linear in y between rows, so the column at x is interpolated between
+ * columns only for the O(log n) rows the search reads, and the bracketing segment is solved
+ * directly. The column must be monotone in y.
+ * 
+ * @tparam Y Type of y
+ * @tparam Layout How cells are stored. Row-major by default.
+ * @param x Fixed x
+ * @param target Output to find y for
+ * @param xScale Array-like object that stores the x scale values. Must be indexable []
+ * @param yScale Array-like object that stores the y scale values. Must be indexable []
+ * @param cells Array-like object that stores the cells. Must be indexable []
+ * @param outResult Where the target is on the column
+ * @return Y y that gives the target
+ */
+template<typename Y, typename Layout = RowMajorLayout, typename X, typename Z,
+         typename XArray, typename YArray, typename ZArray>
+Y inverseInterpolateBilinearTableY(X x, Z target, size_t xLength, size_t yLength,
+                                   XArray xScale, YArray yScale, ZArray cells, FindOnScaleResult &outResult)
+{
+  BilinearColumn<Z, Layout, X, Y, ZArray> column;
+  column.x = x;
+  column.xResult = findOnScale(x, xScale, xLength, column.xLowIndex, column.xLow, column.xHigh);
+  column.xLength = xLength;
+  column.yLength = yLength;
+  column.cells = cells;
+
+  return inverseInterpolateLinearTable<Y>(target, yLength, yScale, column, outResult);
+}
+
+template<typename Y, typename Layout = RowMajorLayout, typename X, typename Z,
+         typename XArray, typename YArray, typename ZArray>
+Y inverseInterpolateBilinearTableY(X x, Z target, size_t xLength, size_t yLength,
+                                   XArray xScale, YArray yScale, ZArray cells)
+{
+  FindOnScaleResult result;
+  return inverseInterpolateBilinearTableY<Y, Layout>(x, target, xLength, yLength, xScale, yScale, cells, result);
+}
+
+/**
+ * @brief Find the x that gives the target output of a 2D table at a fixed y
+ * 
+ * Same as inverseInterpolateBilinearTableY() with the axes swapped. The row must be monotone in x.
+ * 
+ * @tparam X Type of x
+ * @tparam Layout How cells are stored. Row-major by default.
+ * @param y Fixed y
+ * @param target Output to find x for
+ * @param outResult Where the target is on the row
+ * @return X x that gives the target
+ */
+template<typename X, typename Layout = RowMajorLayout, typename Y, typename Z,
+         typename XArray, typename YArray, typename ZArray>
+X inverseInterpolateBilinearTableX(Y y, Z target, size_t xLength, size_t yLength,
+                                   XArray xScale, YArray yScale, ZArray cells, FindOnScaleResult &outResult)
+{
+  BilinearRow<Z, Layout, X, Y, ZArray> row;
+  row.y = y;
+  row.yResult = findOnScale(y, yScale, yLength, row.yLowIndex, row.yLow, row.yHigh);
+  row.xLength = xLength;
+  row.yLength = yLength;
+  row.cells = cells;
+
+  return inverseInterpolateLinearTable<X>(target, xLength, xScale, row, outResult);
+}
+
+template<typename X, typename Layout = RowMajorLayout, typename Y, typename Z,
+         typename XArray, typename YArray, typename ZArray>
+X inverseInterpolateBilinearTableX(Y y, Z target, size_t xLength, size_t yLength,
+                                   XArray xScale, YArray yScale, ZArray cells)
+{
+  FindOnScaleResult result;
+  return inverseInterpolateBilinearTableX<X, Layout>(y, target, xLength, yLength, xScale, yScale, cells, result);
+}
+
+#endif
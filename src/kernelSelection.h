@@ -0,0 +1,93 @@
+// Kernel Selection
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Generated by tools/selectKernels from test_kernelTraits output. Regenerate rather than edit.
+// Included by kernelTraits.h.
+
+#ifndef ENGINE_CALCULATIONS_KERNEL_SELECTION_H_
+#define ENGINE_CALCULATIONS_KERNEL_SELECTION_H_
+
+#pragma once
+
+// target __AVR_ATmega2560__
+#if defined(__AVR_ATmega2560__)
+template<>
+struct LinearKernelTraits<uint8_t, uint8_t>
+{
+  // Fixed point 300 ticks, float 1259
+  static constexpr InterpolationKernel kernel = InterpolationKernel::FixedPoint;
+};
+
+template<>
+struct LinearKernelTraits<uint8_t, uint16_t>
+{
+  // Fixed point 800 ticks, float 1220
+  static constexpr InterpolationKernel kernel = InterpolationKernel::FixedPoint;
+};
+
+template<>
+struct LinearKernelTraits<uint8_t, uint32_t>
+{
+  // Fixed point 1393 ticks, float 1230
+  static constexpr InterpolationKernel kernel = InterpolationKernel::Float;
+};
+
+template<>
+struct LinearKernelTraits<uint16_t, uint8_t>
+{
+  // Fixed point 800 ticks, float 1220
+  static constexpr InterpolationKernel kernel = InterpolationKernel::FixedPoint;
+};
+
+template<>
+struct LinearKernelTraits<uint16_t, uint16_t>
+{
+  // Fixed point 800 ticks, float 1270
+  static constexpr InterpolationKernel kernel = InterpolationKernel::FixedPoint;
+};
+
+template<>
+struct LinearKernelTraits<uint16_t, uint32_t>
+{
+  // Fixed point 1417 ticks, float 1260
+  static constexpr InterpolationKernel kernel = InterpolationKernel::Float;
+};
+
+template<>
+struct LinearKernelTraits<uint32_t, uint8_t>
+{
+  // Fixed point 1386 ticks, float 1290
+  static constexpr InterpolationKernel kernel = InterpolationKernel::Float;
+};
+
+template<>
+struct LinearKernelTraits<uint32_t, uint16_t>
+{
+  // Fixed point 1400 ticks, float 1290
+  static constexpr InterpolationKernel kernel = InterpolationKernel::Float;
+};
+
+template<>
+struct LinearKernelTraits<uint32_t, uint32_t>
+{
+  // Fixed point 1456 ticks, float 1290
+  static constexpr InterpolationKernel kernel = InterpolationKernel::Float;
+};
+
+// end targets
+#endif
+
+#endif
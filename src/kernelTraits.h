@@ -0,0 +1,72 @@
+// Kernel Traits
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_KERNEL_TRAITS_H_
+#define ENGINE_CALCULATIONS_KERNEL_TRAITS_H_
+
+#pragma once
+
+#include <stdint.h>
+
+// Implementations interpolateLinear() and interpolateBilinear() can dispatch to
+enum class InterpolationKernel : uint8_t
+{
+  FixedPoint,
+  Float,
+};
+
+// Name of the target benchmark results are for, printed by test_kernelTraits. Empty if there's no
+// predefined macro to key on, in which case tools/selectKernels needs --target.
+#if defined(__AVR_ATmega2560__)
+#define KERNEL_TRAITS_TARGET "__AVR_ATmega2560__"
+#elif defined(__AVR_ARCH__)
+#define KERNEL_TRAITS_TARGET "__AVR_ARCH__"
+#elif defined(__ARM_ARCH_7EM__)
+#define KERNEL_TRAITS_TARGET "__ARM_ARCH_7EM__"
+#else
+#define KERNEL_TRAITS_TARGET ""
+#endif
+
+/**
+ * @brief Kernel interpolateLinear() uses for InputType and OutputType
+ * 
+ * Targets that have been benchmarked get specializations in kernelSelection.h. Others get fixed
+ * point, except with 32-bit inputs or outputs, where float was faster on the ATmega2560.
+ */
+template<typename InputType, typename OutputType>
+struct LinearKernelTraits
+{
+  static constexpr InterpolationKernel kernel = (sizeof(InputType) > 2 || sizeof(OutputType) > 2)
+    ? InterpolationKernel::Float
+    : InterpolationKernel::FixedPoint;
+};
+
+/**
+ * @brief Kernel interpolateBilinear() uses for X, Y and Z
+ * 
+ * Targets that have been benchmarked get specializations in kernelSelection.h. Others get fixed
+ * point.
+ */
+template<typename X, typename Y, typename Z>
+struct BilinearKernelTraits
+{
+  static constexpr InterpolationKernel kernel = InterpolationKernel::FixedPoint;
+};
+
+#include "kernelSelection.h"
+
+#endif
@@ -0,0 +1,162 @@
+// Median Filter
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_MEDIAN_H_
+#define ENGINE_CALCULATIONS_MEDIAN_H_
+
+#pragma once
+
+#include <stdint.h>
+
+// Compare and swap so that a <= b. Building block of the sorting networks below.
+template<typename T>
+inline void medianSortPair(T &a, T &b)
+{
+  if (b < a)
+  {
+    T temp = a;
+    a = b;
+    b = temp;
+  }
+}
+
+// Median of 3 with a 3-comparison network
+template<typename T>
+T median3(T v0, T v1, T v2)
+{
+  medianSortPair(v0, v1);
+  medianSortPair(v1, v2);
+  medianSortPair(v0, v1);
+  return v1;
+}
+
+// Median of 5 with a 7-comparison network
+template<typename T>
+T median5(T v0, T v1, T v2, T v3, T v4)
+{
+  medianSortPair(v0, v1);
+  medianSortPair(v3, v4);
+  medianSortPair(v0, v3);
+  medianSortPair(v1, v4);
+  medianSortPair(v1, v2);
+  medianSortPair(v2, v3);
+  medianSortPair(v1, v2);
+  return v2;
+}
+
+// Median of 7 with a 13-comparison network
+template<typename T>
+T median7(T v0, T v1, T v2, T v3, T v4, T v5, T v6)
+{
+  medianSortPair(v0, v5);
+  medianSortPair(v0, v3);
+  medianSortPair(v1, v6);
+  medianSortPair(v2, v4);
+  medianSortPair(v0, v1);
+  medianSortPair(v3, v5);
+  medianSortPair(v2, v6);
+  medianSortPair(v2, v3);
+  medianSortPair(v3, v6);
+  medianSortPair(v4, v5);
+  medianSortPair(v1, v4);
+  medianSortPair(v1, v3);
+  medianSortPair(v3, v4);
+  return v3;
+}
+
+template<typename T, uint8_t length>
+struct MedianOf;
+
+template<typename T>
+struct MedianOf<T, 3>
+{
+  static T apply(const T *v)
+  {
+    return median3(v[0], v[1], v[2]);
+  }
+};
+
+template<typename T>
+struct MedianOf<T, 5>
+{
+  static T apply(const T *v)
+  {
+    return median5(v[0], v[1], v[2], v[3], v[4]);
+  }
+};
+
+template<typename T>
+struct MedianOf<T, 7>
+{
+  static T apply(const T *v)
+  {
+    return median7(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+  }
+};
+
+/**
+ * @brief Median of the last length samples
+ * 
+ * @tparam TVal Type of value
+ * @tparam length Number of samples. Must be 3, 5, or 7
+ */
+template<typename TVal, uint8_t length>
+class MedianFilter
+{
+  static_assert(length == 3 || length == 5 || length == 7, "Median only implemented for 3, 5, or 7 samples");
+
+public:
+  MedianFilter(TVal initial = 0)
+  {
+    reset(initial);
+  }
+
+  void reset(TVal initial)
+  {
+    for (uint8_t i = 0; i < length; i++)
+    {
+      _values[i] = initial;
+    }
+
+    _index = 0;
+  }
+
+  // Add sample and return the new median
+  TVal operator() (TVal cur)
+  {
+    _values[_index] = cur;
+
+    _index++;
+    if (_index == length)
+    {
+      _index = 0;
+    }
+
+    return median();
+  }
+
+  TVal median() const
+  {
+    // Order of samples doesn't matter to the median, so no need to unwrap the ring buffer
+    return MedianOf<TVal, length>::apply(_values);
+  }
+
+private:
+  TVal _values[length];
+  uint8_t _index;
+};
+
+#endif
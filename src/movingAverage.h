@@ -0,0 +1,94 @@
+// Moving Average
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_MOVING_AVERAGE_H_
+#define ENGINE_CALCULATIONS_MOVING_AVERAGE_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include "fixedPoint.h"
+
+/**
+ * @brief Average of the last length samples, updated in constant time with a running sum
+ * 
+ * @tparam TVal Type of value
+ * @tparam length Number of samples to average
+ * @tparam valueBits Number of bits of TVal actually used. Sets how wide the running sum needs to be
+ * @tparam TSum Type of running sum. Picked to hold length values of valueBits without overflowing
+ */
+template<typename TVal, uint8_t length, uint8_t valueBits = sizeof(TVal) * 8,
+  typename TSum = typename WideningType<TVal, valueBits + bitWidth(length - 1u)>::type>
+class MovingAverage
+{
+public:
+  MovingAverage(TVal initial = 0)
+  {
+    reset(initial);
+  }
+
+  void reset(TVal initial)
+  {
+    for (uint8_t i = 0; i < length; i++)
+    {
+      _values[i] = initial;
+    }
+
+    _sum = static_cast<TSum>(initial) * length;
+    _index = 0;
+  }
+
+  // Add sample and return the new average
+  TVal operator() (TVal cur)
+  {
+    _sum -= _values[_index];
+    _sum += cur;
+
+    _values[_index] = cur;
+
+    _index++;
+    if (_index == length)
+    {
+      _index = 0;
+    }
+
+    return average();
+  }
+
+  TVal average() const
+  {
+    // Round instead of truncate for integer types. Folds away for floating point.
+    constexpr bool isInteger = static_cast<TSum>(1) / static_cast<TSum>(2) == static_cast<TSum>(0);
+    constexpr TSum roundingFactor = isInteger ? static_cast<TSum>(length / 2) : static_cast<TSum>(0);
+
+    if (_sum < static_cast<TSum>(0))
+    {
+      return static_cast<TVal>((_sum - roundingFactor) / static_cast<TSum>(length));
+    }
+    else
+    {
+      return static_cast<TVal>((_sum + roundingFactor) / static_cast<TSum>(length));
+    }
+  }
+
+private:
+  TVal _values[length];
+  TSum _sum;
+  uint8_t _index;
+};
+
+#endif
@@ -0,0 +1,127 @@
+// Packed 12-bit Array
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_PACKED_ARRAY_12_H_
+#define ENGINE_CALCULATIONS_PACKED_ARRAY_12_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Two 12-bit values as 3 bytes, for initializing packed arrays
+#define PACK12(first, second) \
+  static_cast<uint8_t>((first) & 0xFFu), \
+  static_cast<uint8_t>((((first) >> 8) & 0x0Fu) | (((second) & 0x0Fu) << 4)), \
+  static_cast<uint8_t>(((second) >> 4) & 0xFFu)
+
+// Bytes needed to store length 12-bit values
+constexpr size_t packedArray12Size(size_t length)
+{
+  return length + (length + 1) / 2;
+}
+
+/**
+ * @brief Array of 12-bit values, packed two to every 3 bytes
+ * 
+ * Indexable [] so it can be used as an output array for interpolateLinearTable() and
+ * interpolateBilinearTable(). Values are returned as uint16_t.
+ * 
+ * Byte layout of each pair: [first bits 0-7] [second bits 0-3, first bits 8-11] [second bits 4-11]
+ * 
+ * @tparam ByteArray Array-like type that holds the bytes. Use ProgmemArray<uint8_t> for flash
+ */
+template<typename ByteArray = const uint8_t *>
+class PackedArray12
+{
+public:
+  PackedArray12(ByteArray bytes): _bytes(bytes) {}
+
+  uint16_t operator[](size_t index) const
+  {
+    size_t offset = byteOffset(index);
+
+    if (index & 1u)
+    {
+      return (_bytes[offset] >> 4) | (static_cast<uint16_t>(_bytes[offset + 1]) << 4);
+    }
+    else
+    {
+      return _bytes[offset] | (static_cast<uint16_t>(_bytes[offset + 1] & 0x0Fu) << 8);
+    }
+  }
+
+  // Read values at index and index + 1. Shares the middle byte(s) instead of reading them twice.
+  void readPair(size_t index, uint16_t &first, uint16_t &second) const
+  {
+    size_t offset = byteOffset(index);
+
+    uint8_t byte0 = _bytes[offset];
+    uint8_t byte1 = _bytes[offset + 1];
+    uint8_t byte2 = _bytes[offset + 2];
+
+    if (index & 1u)
+    {
+      // Pair straddles two groups: 4 bytes
+      uint8_t byte3 = _bytes[offset + 3];
+      first = (byte0 >> 4) | (static_cast<uint16_t>(byte1) << 4);
+      second = byte2 | (static_cast<uint16_t>(byte3 & 0x0Fu) << 8);
+    }
+    else
+    {
+      // Pair is one group: 3 bytes
+      first = byte0 | (static_cast<uint16_t>(byte1 & 0x0Fu) << 8);
+      second = (byte1 >> 4) | (static_cast<uint16_t>(byte2) << 4);
+    }
+  }
+
+  // Only for writable byte arrays
+  void set(size_t index, uint16_t value)
+  {
+    size_t offset = byteOffset(index);
+
+    if (index & 1u)
+    {
+      _bytes[offset] = static_cast<uint8_t>((_bytes[offset] & 0x0Fu) | ((value & 0x0Fu) << 4));
+      _bytes[offset + 1] = static_cast<uint8_t>(value >> 4);
+    }
+    else
+    {
+      _bytes[offset] = static_cast<uint8_t>(value);
+      _bytes[offset + 1] = static_cast<uint8_t>((_bytes[offset + 1] & 0xF0u) | ((value >> 8) & 0x0Fu));
+    }
+  }
+
+private:
+  // 1.5 bytes per value, rounded down. Odd values start on the middle byte of a group.
+  static size_t byteOffset(size_t index)
+  {
+    return index + (index >> 1);
+  }
+
+  ByteArray _bytes;
+};
+
+template<typename ByteArray, typename T>
+inline void readTablePair(PackedArray12<ByteArray> array, size_t index, T &first, T &second)
+{
+  uint16_t value0, value1;
+  array.readPair(index, value0, value1);
+  first = static_cast<T>(value0);
+  second = static_cast<T>(value1);
+}
+
+#endif
@@ -0,0 +1,202 @@
+// Program Memory Arrays
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_PROGMEM_ARRAY_H_
+#define ENGINE_CALCULATIONS_PROGMEM_ARRAY_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __AVR_ARCH__
+#include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+#ifdef __AVR_ARCH__
+
+// Read a value of any size from the low 64 KB of flash
+template<typename T, size_t size = sizeof(T)>
+struct ProgmemRead
+{
+  static T read(const T *address)
+  {
+    T value;
+    memcpy_P(&value, address, sizeof(T));
+    return value;
+  }
+};
+
+template<typename T>
+struct ProgmemRead<T, 1>
+{
+  static T read(const T *address)
+  {
+    union { uint8_t raw; T value; } result;
+    result.raw = pgm_read_byte(address);
+    return result.value;
+  }
+};
+
+template<typename T>
+struct ProgmemRead<T, 2>
+{
+  static T read(const T *address)
+  {
+    union { uint16_t raw; T value; } result;
+    result.raw = pgm_read_word(address);
+    return result.value;
+  }
+};
+
+template<typename T>
+struct ProgmemRead<T, 4>
+{
+  static T read(const T *address)
+  {
+    union { uint32_t raw; T value; } result;
+    result.raw = pgm_read_dword(address);
+    return result.value;
+  }
+};
+
+// Read a value of any size from anywhere in flash
+template<typename T, size_t size = sizeof(T)>
+struct FarProgmemRead
+{
+  static T read(uint_farptr_t address)
+  {
+    T value;
+    memcpy_PF(&value, address, sizeof(T));
+    return value;
+  }
+};
+
+template<typename T>
+struct FarProgmemRead<T, 1>
+{
+  static T read(uint_farptr_t address)
+  {
+    union { uint8_t raw; T value; } result;
+    result.raw = pgm_read_byte_far(address);
+    return result.value;
+  }
+};
+
+template<typename T>
+struct FarProgmemRead<T, 2>
+{
+  static T read(uint_farptr_t address)
+  {
+    union { uint16_t raw; T value; } result;
+    result.raw = pgm_read_word_far(address);
+    return result.value;
+  }
+};
+
+template<typename T>
+struct FarProgmemRead<T, 4>
+{
+  static T read(uint_farptr_t address)
+  {
+    union { uint32_t raw; T value; } result;
+    result.raw = pgm_read_dword_far(address);
+    return result.value;
+  }
+};
+
+#else
+
+// Flash and RAM share an address space, so read it like any other memory
+template<typename T>
+struct ProgmemRead
+{
+  static T read(const T *address)
+  {
+    return *address;
+  }
+};
+
+#endif
+
+/**
+ * @brief Array-like accessor for a PROGMEM array in the low 64 KB of flash
+ * 
+ * Indexable [] so it can be used as a scale or output array for findOnScale(),
+ * interpolateLinearTable() and interpolateBilinearTable().
+ * 
+ * @tparam T Type of array element
+ */
+template<typename T>
+class ProgmemArray
+{
+public:
+  ProgmemArray(const T *data): _data(data) {}
+
+  T operator[](size_t index) const
+  {
+    return ProgmemRead<T>::read(_data + index);
+  }
+
+private:
+  const T *_data;
+};
+
+/**
+ * @brief Array-like accessor for a PROGMEM array anywhere in flash, including above 64 KB
+ * 
+ * Construct with FAR_PROGMEM_ARRAY() so the far address is taken correctly.
+ * 
+ * @tparam T Type of array element
+ */
+template<typename T>
+class FarProgmemArray
+{
+public:
+#ifdef __AVR_ARCH__
+  FarProgmemArray(uint_farptr_t address): _address(address) {}
+
+  T operator[](size_t index) const
+  {
+    return FarProgmemRead<T>::read(_address + static_cast<uint_farptr_t>(index) * sizeof(T));
+  }
+
+private:
+  uint_farptr_t _address;
+#else
+  FarProgmemArray(const T *data): _data(data) {}
+
+  T operator[](size_t index) const
+  {
+    return _data[index];
+  }
+
+private:
+  const T *_data;
+#endif
+};
+
+#ifdef __AVR_ARCH__
+#define FAR_PROGMEM_ARRAY(type, variable) FarProgmemArray<type>(pgm_get_far_address(variable))
+#else
+#define FAR_PROGMEM_ARRAY(type, variable) FarProgmemArray<type>(variable)
+#endif
+
+#endif
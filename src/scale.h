@@ -119,4 +119,86 @@ FindOnScaleResult findOnScale(T input, ScaleArrayType start, size_t length, size
 }
 
 
+/**
+ * @brief Find the value on the scale by binary search
+ * 
+ * Same results as findOnScale(), in O(log n) reads instead of O(n). Better for long scales, or
+ * scales that are expensive to read, like a column interpolated on the fly.
+ * 
+ * @tparam T Type of value
+ * @tparam ScaleArrayType Array-like type. Must be indexable []
+ * @param start Array-like object that stores the scale values in ascending order
+ * @param length Length of scale
+ * @param input input value
+ * @param outLowIndex Index of value below the input, or 0 if off the scale low
+ * @param outLow Value less than the input
+ * @param outHigh Value greater than the input
+ * @return FindOnScaleResult 
+ */
+template<typename T, typename ScaleArrayType>
+FindOnScaleResult findOnScaleBinary(T input, ScaleArrayType start, size_t length, size_t &outLowIndex, T &outLow, T &outHigh)
+{
+  size_t highIndex = length - 1;
+  T highValue = start[highIndex];
+
+  // Input out of range high
+  if (input > highValue)
+  {
+    outLow = highValue;
+    outLowIndex = highIndex;
+    return FindOnScaleResult::OffScaleHigh;
+  }
+
+  size_t lowIndex = 0;
+  T lowValue = start[lowIndex];
+
+  // Input is out of range low
+  if (input < lowValue)
+  {
+    outHigh = lowValue;
+    outLowIndex = lowIndex;
+    return FindOnScaleResult::OffScaleLow;
+  }
+
+  // Narrow down until lowValue <= input <= highValue are neighbors
+  while (highIndex - lowIndex > 1)
+  {
+    size_t midIndex = lowIndex + (highIndex - lowIndex) / 2;
+    T midValue = start[midIndex];
+
+    if (midValue <= input)
+    {
+      lowIndex = midIndex;
+      lowValue = midValue;
+    }
+    else
+    {
+      highIndex = midIndex;
+      highValue = midValue;
+    }
+  }
+
+  // Found the exact value. Prefer the higher index, like findOnScale()
+  if (input == highValue)
+  {
+    outHigh = highValue;
+    outLow = highValue;
+    outLowIndex = highIndex;
+    return FindOnScaleResult::Exact;
+  }
+
+  if (input == lowValue)
+  {
+    outHigh = lowValue;
+    outLow = lowValue;
+    outLowIndex = lowIndex;
+    return FindOnScaleResult::Exact;
+  }
+
+  outHigh = highValue;
+  outLow = lowValue;
+  outLowIndex = lowIndex;
+  return FindOnScaleResult::InBetween;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,208 @@
+// Tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_TABLE_H_
+#define ENGINE_CALCULATIONS_TABLE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scale.h"
+#include "tableLayout.h"
+#include "interpolateLinear.h"
+#include "interpolateBilinear.h"
+#include "tableHeatmap.h"
+#include "distributeBilinear.h"
+
+/**
+ * @brief 2D table that owns its scales and cells
+ * 
+ * Plain aggregate with a fixed memory layout, so it can be brace-initialized, copied with
+ * memcpy, or mapped from a file:
+ *   Table2D<uint8_t, uint16_t, uint8_t, 3, 2> table = {{xScale...}, {yScale...}, {cells...}};
+ * 
+ * @tparam Z Type of cell
+ * @tparam X Type of x scale
+ * @tparam Y Type of y scale
+ * @tparam Layout How cells are stored. Cells in initializers must be in this layout. See load().
+ */
+template<typename Z, typename X, typename Y, size_t xLength, size_t yLength,
+  typename Layout = RowMajorLayout>
+struct Table2D
+{
+  typedef Z ValueType;
+  typedef X XType;
+  typedef Y YType;
+  typedef Layout LayoutType;
+
+  static constexpr size_t xSize = xLength;
+  static constexpr size_t ySize = yLength;
+  static constexpr size_t cellCount = Layout::size(xLength, yLength);
+
+  X xScale[xLength];
+  Y yScale[yLength];
+  Z cells[cellCount];
+
+  static size_t index(size_t xIndex, size_t yIndex)
+  {
+    return Layout::index(xIndex, yIndex, xLength, yLength);
+  }
+
+  Z &at(size_t xIndex, size_t yIndex)
+  {
+    return cells[index(xIndex, yIndex)];
+  }
+
+  const Z &at(size_t xIndex, size_t yIndex) const
+  {
+    return cells[index(xIndex, yIndex)];
+  }
+
+  // Copy in cells given row by row, converting to Layout
+  void load(const Z *rowMajorCells)
+  {
+    for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+    {
+      for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+      {
+        at(xIndex, yIndex) = rowMajorCells[yIndex * xLength + xIndex];
+      }
+    }
+  }
+
+  Z lookup(X x, Y y) const
+  {
+    return interpolateBilinearTable<Z, Layout>(x, y, xLength, yLength, xScale, yScale, cells);
+  }
+
+  // Find inputs on the scales once, for lookup() and distribute() at the same point
+  BilinearTableLocation<X, Y> locate(X x, Y y) const
+  {
+    return locateBilinearTable(x, y, xLength, yLength, xScale, yScale);
+  }
+
+  Z lookup(const BilinearTableLocation<X, Y> &location) const
+  {
+    return interpolateBilinearLocation<Z, Layout>(location, xLength, yLength, cells);
+  }
+
+  // Spread a correction over the cells around location. See distributeBilinear().
+  void distribute(const BilinearTableLocation<X, Y> &location, int16_t delta)
+  {
+    distributeBilinear<Layout>(location, xLength, yLength, cells, delta);
+  }
+
+  // Lookup that records the visit in a TableHeatmap<xLength, yLength>
+  template<typename Heatmap>
+  Z lookup(X x, Y y, Heatmap &heatmap) const
+  {
+    return interpolateBilinearTable<Z, Layout>(x, y, xLength, yLength, xScale, yScale, cells, heatmap);
+  }
+};
+
+/**
+ * @brief 3D table that owns its scales and cells
+ * 
+ * Stored as wLength 2D slices, one after another, each in Layout.
+ * 
+ * @tparam Z Type of cell
+ * @tparam X Type of x scale
+ * @tparam Y Type of y scale
+ * @tparam W Type of w scale, the third axis
+ * @tparam Layout How cells in each slice are stored
+ */
+template<typename Z, typename X, typename Y, typename W, size_t xLength, size_t yLength, size_t wLength,
+  typename Layout = RowMajorLayout>
+struct Table3D
+{
+  typedef Z ValueType;
+  typedef X XType;
+  typedef Y YType;
+  typedef W WType;
+  typedef Layout LayoutType;
+
+  static constexpr size_t xSize = xLength;
+  static constexpr size_t ySize = yLength;
+  static constexpr size_t wSize = wLength;
+  static constexpr size_t sliceCellCount = Layout::size(xLength, yLength);
+  static constexpr size_t cellCount = sliceCellCount * wLength;
+
+  X xScale[xLength];
+  Y yScale[yLength];
+  W wScale[wLength];
+  Z cells[cellCount];
+
+  static size_t index(size_t xIndex, size_t yIndex, size_t wIndex)
+  {
+    return wIndex * sliceCellCount + Layout::index(xIndex, yIndex, xLength, yLength);
+  }
+
+  Z &at(size_t xIndex, size_t yIndex, size_t wIndex)
+  {
+    return cells[index(xIndex, yIndex, wIndex)];
+  }
+
+  const Z &at(size_t xIndex, size_t yIndex, size_t wIndex) const
+  {
+    return cells[index(xIndex, yIndex, wIndex)];
+  }
+
+  // Copy in cells given slice by slice, each row by row, converting to Layout
+  void load(const Z *rowMajorCells)
+  {
+    for (size_t wIndex = 0; wIndex < wLength; wIndex++)
+    {
+      for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+      {
+        for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+        {
+          at(xIndex, yIndex, wIndex) = rowMajorCells[(wIndex * yLength + yIndex) * xLength + xIndex];
+        }
+      }
+    }
+  }
+
+  Z lookupSlice(X x, Y y, size_t wIndex) const
+  {
+    return interpolateBilinearTable<Z, Layout>(x, y, xLength, yLength, xScale, yScale,
+      cells + wIndex * sliceCellCount);
+  }
+
+  Z lookup(X x, Y y, W w) const
+  {
+    size_t wLowIndex;
+    W wLow;
+    W wHigh;
+
+    FindOnScaleResult wResult = findOnScale(w, wScale, wLength, wLowIndex, wLow, wHigh);
+
+    Z output0 = lookupSlice(x, y, wLowIndex);
+
+    if (FindOnScaleResult::InBetween == wResult)
+    {
+      Z output1 = lookupSlice(x, y, wLowIndex + 1);
+      return interpolateLinear(w, wLow, wHigh, output0, output1);
+    }
+    else
+    {
+      return output0;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,206 @@
+// Table Heatmaps
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_TABLE_HEATMAP_H_
+#define ENGINE_CALCULATIONS_TABLE_HEATMAP_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scale.h"
+#include "tableLayout.h"
+#include "interpolateBilinear.h"
+
+/*
+Define ENGINE_CALCULATIONS_DISABLE_TABLE_HEATMAP to compile instrumented lookups as plain
+interpolateBilinearTable() calls. Counters are still declared but never updated.
+ */
+
+// How a lookup is counted
+enum class HeatmapMode: uint8_t
+{
+  // The nearest cell gets 1. No division.
+  Nearest,
+  // The four surrounding cells share 2^(2 * weightBits) by their bilinear weights. Costs a
+  // division per interpolated axis.
+  Weighted
+};
+
+// Heatmap that records nothing. Compiles away.
+struct NullTableHeatmap
+{
+  template<typename X, typename Y>
+  void record(const BilinearTableLocation<X, Y> &) {}
+};
+
+/**
+ * @brief Saturating per-cell visit counters for a 2D table
+ * 
+ * Counters are row-major, whatever the table's layout: count(xIndex, yIndex).
+ * 
+ * @tparam xLength Length of x scale
+ * @tparam yLength Length of y scale
+ * @tparam Counter Unsigned counter type. Saturates at its max value.
+ * @tparam mode Nearest or Weighted
+ * @tparam weightBits Bits of weight per axis in Weighted mode. 2 * weightBits must be less than
+ *   Counter's bits
+ */
+template<size_t xLength, size_t yLength, typename Counter = uint16_t,
+  HeatmapMode mode = HeatmapMode::Nearest, uint8_t weightBits = 2>
+class TableHeatmap
+{
+  static_assert(weightBits <= 7, "Weights must fit in uint8_t");
+  // A visit exactly on a cell adds the full weight of 2^(2 * weightBits) to it
+  static_assert(mode != HeatmapMode::Weighted || 2 * weightBits < sizeof(Counter) * 8,
+    "Full weight must fit in Counter");
+
+public:
+  static constexpr Counter maxCount = static_cast<Counter>(~static_cast<Counter>(0));
+  static constexpr uint8_t weightOne = 1u << weightBits;
+
+  TableHeatmap()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    for (size_t i = 0; i < xLength * yLength; i++)
+    {
+      _counts[i] = 0;
+    }
+  }
+
+  Counter count(size_t xIndex, size_t yIndex) const
+  {
+    return _counts[yIndex * xLength + xIndex];
+  }
+
+  template<typename X, typename Y>
+  void record(const BilinearTableLocation<X, Y> &location)
+  {
+    recordMode(location, ModeTag<mode>());
+  }
+
+  /**
+   * @brief Print counters one row per line, tab separated
+   * 
+   * @tparam Output Print or anything with print() and println()
+   */
+  template<typename Output>
+  void dump(Output &output) const
+  {
+    for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+    {
+      for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+      {
+        if (xIndex > 0)
+        {
+          output.print('\t');
+        }
+
+        output.print(static_cast<unsigned long>(count(xIndex, yIndex)));
+      }
+
+      output.println();
+    }
+  }
+
+private:
+  template<HeatmapMode>
+  struct ModeTag {};
+
+  void add(size_t xIndex, size_t yIndex, Counter amount)
+  {
+    Counter &counter = _counts[yIndex * xLength + xIndex];
+    counter = counter > static_cast<Counter>(maxCount - amount) ? maxCount : static_cast<Counter>(counter + amount);
+  }
+
+  // Index of the nearest value on one axis
+  template<typename T>
+  static size_t nearest(FindOnScaleResult result, size_t lowIndex, T input, T low, T high)
+  {
+    if (FindOnScaleResult::InBetween == result && input - low > high - input)
+    {
+      return lowIndex + 1;
+    }
+
+    return lowIndex;
+  }
+
+  template<typename X, typename Y>
+  void recordMode(const BilinearTableLocation<X, Y> &location, ModeTag<HeatmapMode::Nearest>)
+  {
+    add(nearest(location.xResult, location.xLowIndex, location.x, location.xLow, location.xHigh),
+      nearest(location.yResult, location.yLowIndex, location.y, location.yLow, location.yHigh), 1);
+  }
+
+  template<typename X, typename Y>
+  void recordMode(const BilinearTableLocation<X, Y> &location, ModeTag<HeatmapMode::Weighted>)
+  {
+    uint8_t x1 = static_cast<uint8_t>(bilinearHighWeight<weightBits>(location.xResult, location.x, location.xLow, location.xHigh));
+    uint8_t y1 = static_cast<uint8_t>(bilinearHighWeight<weightBits>(location.yResult, location.y, location.yLow, location.yHigh));
+    uint8_t x0 = weightOne - x1;
+    uint8_t y0 = weightOne - y1;
+
+    add(location.xLowIndex, location.yLowIndex, static_cast<Counter>(x0 * y0));
+
+    if (x1 > 0)
+    {
+      add(location.xLowIndex + 1, location.yLowIndex, static_cast<Counter>(x1 * y0));
+    }
+
+    if (y1 > 0)
+    {
+      add(location.xLowIndex, location.yLowIndex + 1, static_cast<Counter>(x0 * y1));
+
+      if (x1 > 0)
+      {
+        add(location.xLowIndex + 1, location.yLowIndex + 1, static_cast<Counter>(x1 * y1));
+      }
+    }
+  }
+
+  Counter _counts[xLength * yLength];
+};
+
+/**
+ * @brief interpolateBilinearTable() that records the visit in a heatmap
+ * 
+ * The scales are searched once for both. With ENGINE_CALCULATIONS_DISABLE_TABLE_HEATMAP defined
+ * this is a plain interpolateBilinearTable() call.
+ * 
+ * @param heatmap TableHeatmap, NullTableHeatmap, or anything with record(BilinearTableLocation)
+ */
+template<typename Z, typename Layout = RowMajorLayout,
+  typename X, typename Y, typename XArray, typename YArray, typename ZArray, typename Heatmap>
+Z interpolateBilinearTable(X x, Y y, size_t xLength, size_t yLength,
+                           XArray xScale, YArray yScale, ZArray outputArray, Heatmap &heatmap)
+{
+#ifdef ENGINE_CALCULATIONS_DISABLE_TABLE_HEATMAP
+  (void)heatmap;
+  return interpolateBilinearTable<Z, Layout>(x, y, xLength, yLength, xScale, yScale, outputArray);
+#else
+  BilinearTableLocation<X, Y> location = locateBilinearTable(x, y, xLength, yLength, xScale, yScale);
+  heatmap.record(location);
+
+  return interpolateBilinearLocation<Z, Layout>(location, xLength, yLength, outputArray);
+#endif
+}
+
+#endif
@@ -0,0 +1,165 @@
+// Table Layout
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_TABLE_LAYOUT_H_
+#define ENGINE_CALCULATIONS_TABLE_LAYOUT_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "interpolateLinear.h"
+
+/*
+Layouts map a cell's x and y indexes to its position in a 2D table's output array. Every
+table function gets cells through the layout's index(), so tables can be stored in any layout.
+
+The pair and corner reads let a layout use readTablePair() for cells that it stores next to each other.
+ */
+
+// Rows of cells, one after another. x varies fastest.
+struct RowMajorLayout
+{
+  static constexpr size_t size(size_t xLength, size_t yLength)
+  {
+    return xLength * yLength;
+  }
+
+  static size_t index(size_t xIndex, size_t yIndex, size_t xLength, size_t /* yLength */)
+  {
+    return yIndex * xLength + xIndex;
+  }
+
+  // Cells at x and x + 1
+  template<typename ZArray, typename Z>
+  static void readXPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    readTablePair(array, index(xIndex, yIndex, xLength, yLength), z0, z1);
+  }
+
+  // Cells at y and y + 1
+  template<typename ZArray, typename Z>
+  static void readYPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    size_t index0 = index(xIndex, yIndex, xLength, yLength);
+    z0 = array[index0];
+    z1 = array[index0 + xLength];
+  }
+
+  // Corners of the cell at x, y. Subscripts are x,y.
+  template<typename ZArray, typename Z>
+  static void readCorners(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z00, Z &z10, Z &z01, Z &z11)
+  {
+    size_t index00 = index(xIndex, yIndex, xLength, yLength);
+    readTablePair(array, index00, z00, z10);
+    readTablePair(array, index00 + xLength, z01, z11);
+  }
+};
+
+// Columns of cells, one after another. y varies fastest.
+struct ColumnMajorLayout
+{
+  static constexpr size_t size(size_t xLength, size_t yLength)
+  {
+    return xLength * yLength;
+  }
+
+  static size_t index(size_t xIndex, size_t yIndex, size_t /* xLength */, size_t yLength)
+  {
+    return xIndex * yLength + yIndex;
+  }
+
+  template<typename ZArray, typename Z>
+  static void readXPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    size_t index0 = index(xIndex, yIndex, xLength, yLength);
+    z0 = array[index0];
+    z1 = array[index0 + yLength];
+  }
+
+  template<typename ZArray, typename Z>
+  static void readYPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    readTablePair(array, index(xIndex, yIndex, xLength, yLength), z0, z1);
+  }
+
+  template<typename ZArray, typename Z>
+  static void readCorners(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z00, Z &z10, Z &z01, Z &z11)
+  {
+    size_t index00 = index(xIndex, yIndex, xLength, yLength);
+    readTablePair(array, index00, z00, z01);
+    readTablePair(array, index00 + yLength, z10, z11);
+  }
+};
+
+// 2x2 tiles of cells, with tiles stored row by row. Each tile is stored as its row-major 4 cells.
+// A cell at even x and y has all four corners in one tile, which fits in a cache line on a host.
+// Odd lengths are padded out to whole tiles.
+struct Tiled2x2Layout
+{
+  static constexpr size_t size(size_t xLength, size_t yLength)
+  {
+    return ((xLength + 1) / 2) * ((yLength + 1) / 2) * 4;
+  }
+
+  static size_t index(size_t xIndex, size_t yIndex, size_t xLength, size_t /* yLength */)
+  {
+    size_t tilesPerRow = (xLength + 1) / 2;
+    size_t tileIndex = (yIndex >> 1) * tilesPerRow + (xIndex >> 1);
+    return tileIndex * 4 + (yIndex & 1u) * 2 + (xIndex & 1u);
+  }
+
+  template<typename ZArray, typename Z>
+  static void readXPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    if (0 == (xIndex & 1u))
+    {
+      // Both in the same tile row
+      readTablePair(array, index(xIndex, yIndex, xLength, yLength), z0, z1);
+    }
+    else
+    {
+      z0 = array[index(xIndex,     yIndex, xLength, yLength)];
+      z1 = array[index(xIndex + 1, yIndex, xLength, yLength)];
+    }
+  }
+
+  template<typename ZArray, typename Z>
+  static void readYPair(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z0, Z &z1)
+  {
+    z0 = array[index(xIndex, yIndex,     xLength, yLength)];
+    z1 = array[index(xIndex, yIndex + 1, xLength, yLength)];
+  }
+
+  template<typename ZArray, typename Z>
+  static void readCorners(ZArray array, size_t xIndex, size_t yIndex, size_t xLength, size_t yLength,
+    Z &z00, Z &z10, Z &z01, Z &z11)
+  {
+    readXPair(array, xIndex, yIndex,     xLength, yLength, z00, z10);
+    readXPair(array, xIndex, yIndex + 1, xLength, yLength, z01, z11);
+  }
+};
+
+#endif
@@ -0,0 +1,196 @@
+// Uniform Scales
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ENGINE_CALCULATIONS_UNIFORM_SCALE_H_
+#define ENGINE_CALCULATIONS_UNIFORM_SCALE_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixedPoint.h"
+#include "scale.h"
+#include "interpolateLinear.h"
+
+constexpr bool isPowerOfTwo(uint32_t value)
+{
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+// Divide by a constant step. Generic steps divide.
+template<typename T, T step, bool powerOfTwo = isPowerOfTwo(step)>
+struct UniformScaleStep
+{
+  template<typename V>
+  static V divide(V value)
+  {
+    return value / static_cast<V>(step);
+  }
+
+  template<typename V>
+  static V remainder(V value)
+  {
+    return value % static_cast<V>(step);
+  }
+};
+
+// Power-of-two steps shift and mask
+template<typename T, T step>
+struct UniformScaleStep<T, step, true>
+{
+  static constexpr uint8_t shift = bitWidth(step) - 1;
+
+  template<typename V>
+  static V divide(V value)
+  {
+    return value >> shift;
+  }
+
+  template<typename V>
+  static V remainder(V value)
+  {
+    return value & static_cast<V>(step - 1);
+  }
+};
+
+/**
+ * @brief Evenly spaced scale: start, start + step, start + 2 * step, ...
+ * 
+ * Can be used in place of a scale array with findOnScale(), interpolateLinearTable() and
+ * interpolateBilinearTable(). The index is found by subtraction and division by step instead of
+ * searching, and a power-of-two step divides by shifting.
+ * 
+ * Ex: RPM every 500 from 500: UniformScale<uint16_t, 500, 500>
+ * 
+ * @tparam T Type of scale value. Integer only
+ * @tparam start First value on the scale
+ * @tparam step Distance between values. Must be > 0
+ */
+template<typename T, T start, T step>
+struct UniformScale
+{
+  static_assert(step > 0, "Step must be positive");
+
+  typedef UniformScaleStep<T, step> Step;
+
+  constexpr T operator[](size_t index) const
+  {
+    return static_cast<T>(start + static_cast<T>(index) * step);
+  }
+};
+
+/**
+ * @brief Find the value on a uniform scale. Same results as searching the equivalent array.
+ */
+template<typename T, typename S, S start, S step>
+FindOnScaleResult findOnScale(T input, UniformScale<S, start, step> scale, size_t length,
+  size_t &outLowIndex, T &outLow, T &outHigh)
+{
+  typedef typename UniformScale<S, start, step>::Step Step;
+
+  if (input < static_cast<T>(start))
+  {
+    outHigh = static_cast<T>(start);
+    outLowIndex = 0;
+    return FindOnScaleResult::OffScaleLow;
+  }
+
+  // The span of a signed scale can exceed T's max, so measure the offset in the unsigned
+  // counterpart
+  typedef typename UnsignedForBits<sizeof(T) * 8>::type Offset;
+
+  Offset offset = static_cast<Offset>(static_cast<Offset>(input) - static_cast<Offset>(static_cast<T>(start)));
+  Offset index = Step::divide(offset);
+  Offset fraction = Step::remainder(offset);
+
+  if (index >= static_cast<Offset>(length - 1))
+  {
+    outLowIndex = length - 1;
+    outLow = static_cast<T>(scale[length - 1]);
+
+    if (index == static_cast<Offset>(length - 1) && fraction == 0)
+    {
+      outHigh = outLow;
+      return FindOnScaleResult::Exact;
+    }
+
+    return FindOnScaleResult::OffScaleHigh;
+  }
+
+  outLowIndex = static_cast<size_t>(index);
+  outLow = static_cast<T>(input - static_cast<T>(fraction));
+
+  if (fraction == 0)
+  {
+    outHigh = outLow;
+    return FindOnScaleResult::Exact;
+  }
+
+  outHigh = static_cast<T>(outLow + static_cast<T>(step));
+  return FindOnScaleResult::InBetween;
+}
+
+/**
+ * @brief interpolateLinearTable() for a uniform scale
+ * 
+ * The outputs are weighted by the input's offset from the lower scale value and divided by the
+ * constant step, so a power-of-two step interpolates without a division. Rounds to nearest, so
+ * results can differ by 1 from the 8-bit fixed-point slope used with array scales.
+ */
+template<typename OutputType, typename InputType, typename S, S start, S step, typename OutputArray>
+OutputType interpolateLinearTable(InputType input, size_t length, UniformScale<S, start, step> inputScale,
+  OutputArray outputArray)
+{
+  typedef typename UniformScale<S, start, step>::Step Step;
+  typedef typename WideningType<OutputType, sizeof(OutputType) * 8 + bitWidth(step)>::type SumType;
+
+  size_t index;
+  InputType inputLow, inputHigh;
+
+  FindOnScaleResult result = findOnScale(input, inputScale, length, index, inputLow, inputHigh);
+
+  if (FindOnScaleResult::InBetween != result)
+  {
+    return outputArray[index];
+  }
+
+  OutputType output0, output1;
+  readTablePair(outputArray, index, output0, output1);
+
+  SumType weight1 = static_cast<SumType>(input - inputLow);
+  SumType weight0 = static_cast<SumType>(step) - weight1;
+  SumType sum = static_cast<SumType>(output0) * weight0 + static_cast<SumType>(output1) * weight1;
+
+  // Round instead of truncate for integer types. Folds away for floating point.
+  constexpr bool isInteger = static_cast<SumType>(1) / static_cast<SumType>(2) == static_cast<SumType>(0);
+
+  if (!isInteger)
+  {
+    return static_cast<OutputType>(sum / static_cast<SumType>(step));
+  }
+
+  constexpr SumType roundingFactor = static_cast<SumType>(step / 2);
+
+  if (sum < static_cast<SumType>(0))
+  {
+    return static_cast<OutputType>(-Step::divide(static_cast<SumType>(roundingFactor - sum)));
+  }
+
+  return static_cast<OutputType>(Step::divide(static_cast<SumType>(sum + roundingFactor)));
+}
+
+#endif
@@ -0,0 +1,244 @@
+// ARM DSP Kernels Test
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#elif defined(__ARM_ARCH_7EM__)
+
+uint32_t start, end;
+
+// DWT cycle counter, enabled in setup()
+#define TIME_START {noInterrupts(); start = DWT->CYCCNT;}
+#define TIME_END {end = DWT->CYCCNT; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// Differential tests against plain C, and timings of the DSP and FPU paths against generic code.
+// Run on a Cortex-M4/M7 board with pio test -e cortexm4.
+// pio test -e cortexm4_dsp enables the DSP hooks and asserts they're faster.
+
+int16_t halfwordValue(uint8_t index)
+{
+  constexpr int16_t edges[] = {0, 1, -1, 127, -128, 255, 32767, -32768};
+  return index < 8 ? edges[index] : static_cast<int16_t>(index * 2053u - 16000u);
+}
+
+constexpr uint8_t halfwordValues = 48;
+
+void test_armDsp_DualMulAdd()
+{
+  for (uint8_t i = 0; i < halfwordValues; i++)
+  {
+    for (uint8_t j = 0; j < halfwordValues; j++)
+    {
+      int16_t a0 = halfwordValue(i);
+      int16_t b0 = halfwordValue(j);
+      int16_t a1 = halfwordValue((i + j) % halfwordValues);
+
+      // Both products at -32768 * -32768 would overflow SMUAD, as documented
+      int16_t b1 = (a0 == -32768 && b0 == -32768) ? 0 : halfwordValue((i * 3u + 1u) % halfwordValues);
+
+      int32_t expected = static_cast<int32_t>(a0) * b0 + static_cast<int32_t>(a1) * b1;
+      TEST_ASSERT_EQUAL_INT32(expected, dualMulAdd(a0, b0, a1, b1));
+    }
+  }
+}
+
+void test_armDsp_ExpSmooth()
+{
+  for (uint16_t cur = 0; cur < 32768u; cur += 257u)
+  {
+    for (uint16_t prev = 0; prev < 32768u; prev += 1031u)
+    {
+      for (uint8_t alpha = 0; alpha <= 64; alpha++)
+      {
+        uint32_t expected = (static_cast<uint32_t>(cur) * alpha + static_cast<uint32_t>(prev) * (64u - alpha) + 32u) / 64u;
+        TEST_ASSERT_EQUAL_UINT16(expected, (expSmooth<6, uint16_t, 15>(cur, prev, alpha)));
+
+        uint16_t cur10 = cur >> 5;
+        uint16_t prev10 = prev >> 5;
+        uint32_t expected10 = (static_cast<uint32_t>(cur10) * alpha + static_cast<uint32_t>(prev10) * (64u - alpha) + 32u) / 64u;
+        TEST_ASSERT_EQUAL_UINT16(expected10, expSmooth(cur10, prev10, alpha));
+      }
+    }
+  }
+}
+
+template<typename X, typename Z>
+void test_armDsp_Bilinear()
+{
+  for (uint8_t i = 0; i < halfwordValues; i++)
+  {
+    Z z00 = static_cast<Z>(halfwordValue(i));
+    Z z10 = static_cast<Z>(halfwordValue(halfwordValues - 1 - i));
+    Z z01 = static_cast<Z>(halfwordValue((i * 7u) % halfwordValues));
+    Z z11 = static_cast<Z>(halfwordValue((i * 13u) % halfwordValues));
+
+    X x0 = IntegerLimits<X>::min;
+    X x1 = IntegerLimits<X>::max;
+    X x = static_cast<X>(x0 + i * 5);
+    X y = static_cast<X>(x1 - i * 3);
+
+    TEST_ASSERT_INT32_WITHIN(1,
+      (interpolateBilinearKernel<InterpolationKernel::Float, X, X, Z>(x, x0, x1, y, x0, x1, z00, z10, z01, z11)),
+      (interpolateBilinearKernel<InterpolationKernel::FixedPoint, X, X, Z>(x, x0, x1, y, x0, x1, z00, z10, z01, z11)));
+  }
+}
+
+void test_armDsp_Timing()
+{
+  volatile uint16_t cur = 20000;
+  volatile uint16_t prev = 10000;
+  volatile uint8_t alpha = 20;
+  volatile uint32_t sum;
+
+  TIME_START
+  sum = ExpSmoothSum<uint32_t, uint16_t, false>::sum(cur, prev, alpha, static_cast<uint8_t>(64 - alpha));
+  TIME_END
+  uint32_t genericTicks = TIME_DIFF;
+
+  TIME_START
+  sum = static_cast<uint32_t>(dualMulAdd(static_cast<int16_t>(cur), alpha, static_cast<int16_t>(prev), static_cast<uint8_t>(64 - alpha)));
+  TIME_END
+  uint32_t dualTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT32(840000ul, sum);
+
+  volatile uint8_t x = 100, x0 = 40, x1 = 200;
+  volatile int16_t z00 = -3000, z10 = 12000, z01 = 500, z11 = -20000;
+  volatile int16_t result;
+
+  // One bilinear row sum, as bilinearAxisSum() does for u8 axes and i16 cells
+  volatile int32_t delta1 = x1 - x, delta0 = x - x0;
+  volatile int32_t axisSum;
+
+  TIME_START
+  axisSum = static_cast<int32_t>(z00) * delta1 + static_cast<int32_t>(z10) * delta0;
+  TIME_END
+  uint32_t genericAxisTicks = TIME_DIFF;
+
+  TIME_START
+  axisSum = dualMulAdd(z00, static_cast<int16_t>(delta1), z10, static_cast<int16_t>(delta0));
+  TIME_END
+  uint32_t dualAxisTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_INT32(420000l, axisSum);
+
+  TIME_START
+  result = interpolateBilinearKernel<InterpolationKernel::FixedPoint, uint8_t, uint8_t, int16_t>(x, x0, x1, x, x0, x1, z00, z10, z01, z11);
+  TIME_END
+  uint32_t fixedTicks = TIME_DIFF;
+
+  TIME_START
+  result = interpolateBilinearKernel<InterpolationKernel::Float, uint8_t, uint8_t, int16_t>(x, x0, x1, x, x0, x1, z00, z10, z01, z11);
+  TIME_END
+  uint32_t floatTicks = TIME_DIFF;
+
+  TEST_ASSERT_INT16_WITHIN(1, -1055, result);
+
+  LoadFractionCalculator load(16000000.0f, 4, 8.6f, 8.6f);
+  volatile float ticksPerDegree = 2000.0f;
+  volatile float airflow = 40.0f;
+  volatile float loadFraction;
+
+  TIME_START
+  loadFraction = load(ticksPerDegree, airflow);
+  TIME_END
+  uint32_t loadTicks = TIME_DIFF;
+
+  TEST_ASSERT_TRUE(loadFraction > 0.0f);
+
+  snprintf(message, MAX_MESSAGE_LEN, "expSmooth sum: generic %lu, dual %lu. axis sum: generic %lu, dual %lu",
+    static_cast<unsigned long>(genericTicks), static_cast<unsigned long>(dualTicks),
+    static_cast<unsigned long>(genericAxisTicks), static_cast<unsigned long>(dualAxisTicks));
+  TEST_MESSAGE(message);
+
+  snprintf(message, MAX_MESSAGE_LEN, "bilinear u8 u8 i16: fixed %lu, float %lu. load %lu",
+    static_cast<unsigned long>(fixedTicks), static_cast<unsigned long>(floatTicks),
+    static_cast<unsigned long>(loadTicks));
+  TEST_MESSAGE(message);
+
+#if defined(__ARM_ARCH_7EM__) && defined(ENGINE_CALCULATIONS_ARM_DSP_HOOKS)
+  // The DSP hooks are only worth enabling where they beat the generic code. Emulators read 0 ticks.
+  if (genericTicks > 0)
+  {
+    TEST_ASSERT_LESS_THAN(genericTicks, dualTicks);
+    TEST_ASSERT_LESS_THAN(genericAxisTicks, dualAxisTicks);
+  }
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#elif defined(__ARM_ARCH_7EM__)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+  RUN_TEST(test_armDsp_DualMulAdd);
+  RUN_TEST(test_armDsp_ExpSmooth);
+  RUN_TEST((test_armDsp_Bilinear<uint8_t, uint8_t>));
+  RUN_TEST((test_armDsp_Bilinear<uint8_t, int8_t>));
+  RUN_TEST((test_armDsp_Bilinear<uint8_t, int16_t>));
+  RUN_TEST((test_armDsp_Bilinear<int8_t, int8_t>));
+  RUN_TEST((test_armDsp_Bilinear<int8_t, int16_t>));
+  RUN_TEST(test_armDsp_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
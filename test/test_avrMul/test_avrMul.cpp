@@ -0,0 +1,249 @@
+// AVR Multiply Kernels Test
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// Differential tests against plain C products. Run on hardware or with pio test -e simavr.
+
+// Extremes, byte boundaries, and a spread between
+uint16_t wideValue(uint8_t index)
+{
+  constexpr uint16_t edges[] = {0, 1, 0xFF, 0x100, 0x7FFF, 0x8000, 0xFEFF, 0xFFFF};
+  return index < 8 ? edges[index] : static_cast<uint16_t>(index * 1021u + 13u);
+}
+
+constexpr uint8_t wideValues = 64;
+
+void test_avrMul_MulU16U8()
+{
+  for (uint8_t i = 0; i < wideValues; i++)
+  {
+    uint16_t a = wideValue(i);
+
+    for (uint16_t b = 0; b < 256; b++)
+    {
+      uint32_t expected = static_cast<uint32_t>(a) * b;
+      TEST_ASSERT_EQUAL_UINT32(expected, static_cast<uint32_t>(mulU16U8(a, static_cast<uint8_t>(b))));
+
+      // Whatever room is left in 24 bits
+      uint32_t acc = (0xFFFFFFul - expected) >> (b & 7);
+      TEST_ASSERT_EQUAL_UINT32(acc + expected,
+        static_cast<uint32_t>(macU16U8(static_cast<Product24>(acc), a, static_cast<uint8_t>(b))));
+    }
+  }
+}
+
+void test_avrMul_MulU16U16()
+{
+  uint32_t acc = 0x12345678ul;
+
+  for (uint8_t i = 0; i < wideValues; i++)
+  {
+    for (uint8_t j = 0; j < wideValues; j++)
+    {
+      uint16_t a = wideValue(i);
+      uint16_t b = wideValue(j);
+      uint32_t expected = static_cast<uint32_t>(a) * b;
+
+      TEST_ASSERT_EQUAL_UINT32(expected, mulU16U16(a, b));
+      TEST_ASSERT_EQUAL_UINT32(acc + expected, macU16U16(acc, a, b));
+
+      acc = acc * 1664525ul + 1013904223ul;
+    }
+  }
+}
+
+void test_avrMul_ExpSmooth()
+{
+  for (uint8_t i = 0; i < wideValues; i++)
+  {
+    for (uint8_t j = 0; j < wideValues; j += 7)
+    {
+      uint16_t cur = wideValue(i);
+      uint16_t prev = wideValue(j);
+
+      for (uint8_t alpha = 0; alpha <= 64; alpha++)
+      {
+        uint32_t expected = (static_cast<uint32_t>(cur) * alpha + static_cast<uint32_t>(prev) * (64u - alpha) + 32u) / 64u;
+        TEST_ASSERT_EQUAL_UINT16(expected, (expSmooth<6, uint16_t, 16>(cur, prev, alpha)));
+      }
+    }
+  }
+}
+
+void test_avrMul_InterpolateLinear()
+{
+  for (uint8_t i = 0; i < wideValues; i++)
+  {
+    for (uint8_t j = 0; j < wideValues; j += 5)
+    {
+      uint16_t low = wideValue(i) < wideValue(j) ? wideValue(i) : wideValue(j);
+      uint16_t high = wideValue(i) < wideValue(j) ? wideValue(j) : wideValue(i);
+      if (low == high)
+      {
+        continue;
+      }
+
+      uint16_t input = low + (high - low) / 3u;
+      uint8_t output0 = static_cast<uint8_t>(i * 4u);
+      uint8_t output1 = static_cast<uint8_t>(255u - j);
+
+      // 64-bit slopes take the generic path
+      TEST_ASSERT_EQUAL_UINT8(
+        static_cast<uint8_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(input, low, high, output0, output1)),
+        (interpolateLinearKernel<InterpolationKernel::FixedPoint, uint16_t, uint8_t>(input, low, high, output0, output1)));
+
+      uint8_t lowByte = static_cast<uint8_t>(low >> 8);
+      uint8_t highByte = static_cast<uint8_t>(high >> 8);
+      if (lowByte == highByte)
+      {
+        continue;
+      }
+
+      TEST_ASSERT_EQUAL_UINT16(
+        static_cast<uint16_t>(interpolateLinearFixedUnsigned<uint64_t, 8>(static_cast<uint8_t>(lowByte + 1), lowByte, highByte, wideValue(i), wideValue(j))),
+        (interpolateLinearKernel<InterpolationKernel::FixedPoint, uint8_t, uint16_t>(static_cast<uint8_t>(lowByte + 1), lowByte, highByte, wideValue(i), wideValue(j))));
+    }
+  }
+}
+
+void test_avrMul_InterpolateBilinear()
+{
+  for (uint8_t i = 0; i < wideValues; i++)
+  {
+    uint16_t z00 = wideValue(i);
+    uint16_t z10 = wideValue(wideValues - 1 - i);
+    uint16_t z01 = wideValue((i * 7u) % wideValues);
+    uint16_t z11 = wideValue((i * 13u) % wideValues);
+
+    TEST_ASSERT_UINT16_WITHIN(1,
+      (interpolateBilinearKernel<InterpolationKernel::Float, uint16_t, uint16_t, uint16_t>(1000, 0, 60000, 50000, 100, 65535, z00, z10, z01, z11)),
+      (interpolateBilinearKernel<InterpolationKernel::FixedPoint, uint16_t, uint16_t, uint16_t>(1000, 0, 60000, 50000, 100, 65535, z00, z10, z01, z11)));
+
+    TEST_ASSERT_UINT16_WITHIN(1,
+      (interpolateBilinearKernel<InterpolationKernel::Float, uint8_t, uint8_t, uint16_t>(17, 3, 250, 200, 100, 255, z00, z10, z01, z11)),
+      (interpolateBilinearKernel<InterpolationKernel::FixedPoint, uint8_t, uint8_t, uint16_t>(17, 3, 250, 200, 100, 255, z00, z10, z01, z11)));
+
+    uint8_t z8 = static_cast<uint8_t>(z00 >> 8);
+    uint8_t z8High = static_cast<uint8_t>(z11);
+
+    TEST_ASSERT_UINT8_WITHIN(1,
+      (interpolateBilinearKernel<InterpolationKernel::Float, uint16_t, uint16_t, uint8_t>(1000, 0, 60000, 50000, 100, 65535, z8, z8High, z8High, z8)),
+      (interpolateBilinearKernel<InterpolationKernel::FixedPoint, uint16_t, uint16_t, uint8_t>(1000, 0, 60000, 50000, 100, 65535, z8, z8High, z8High, z8)));
+  }
+}
+
+void test_avrMul_Timing()
+{
+  volatile uint16_t a = 54321;
+  volatile uint16_t b = 12345;
+  volatile uint32_t result;
+
+  TIME_START
+  result = static_cast<uint32_t>(a) * b;
+  TIME_END
+  uint16_t genericTicks = TIME_DIFF;
+
+  TIME_START
+  result = mulU16U16(a, b);
+  TIME_END
+  uint16_t mulTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT32(670592745ul, result);
+
+  volatile uint16_t cur = 40000;
+  volatile uint16_t prev = 20000;
+  volatile uint8_t alpha = 20;
+  volatile uint16_t smoothed;
+
+  TIME_START
+  smoothed = expSmoothImpl<6, uint32_t>(cur, prev, alpha, static_cast<uint8_t>(64 - alpha));
+  TIME_END
+  uint16_t genericSmoothTicks = TIME_DIFF;
+
+  TIME_START
+  smoothed = expSmooth<6, uint16_t, 16>(cur, prev, alpha);
+  TIME_END
+  uint16_t smoothTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT16(26250, smoothed);
+
+  snprintf(message, MAX_MESSAGE_LEN, "16x16: generic %u ticks, mulU16U16 %u ticks. expSmooth: 32-bit %u ticks, 16x8 %u ticks",
+    genericTicks, mulTicks, genericSmoothTicks, smoothTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(genericTicks, mulTicks);
+  TEST_ASSERT_LESS_THAN(genericSmoothTicks, smoothTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_avrMul_MulU16U8);
+  RUN_TEST(test_avrMul_MulU16U16);
+  RUN_TEST(test_avrMul_ExpSmooth);
+  RUN_TEST(test_avrMul_InterpolateLinear);
+  RUN_TEST(test_avrMul_InterpolateBilinear);
+  RUN_TEST(test_avrMul_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
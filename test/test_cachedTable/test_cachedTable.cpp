@@ -0,0 +1,209 @@
+// Test cached tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef Table2D<uint8_t, uint16_t, uint8_t, 4, 3> FuelTable;
+
+FuelTable fuelTable = {
+  {1000, 2000, 4000, 6000},
+  {20, 60, 100},
+  { 40,  60,  80, 100,
+    80, 120, 150, 170,
+   120, 180, 220, 250}};
+
+// Counts how often the wrapped table is actually interpolated
+struct CountingTable
+{
+  typedef FuelTable::XType XType;
+  typedef FuelTable::YType YType;
+  typedef FuelTable::ValueType ValueType;
+
+  FuelTable &table;
+  uint16_t lookups;
+
+  uint8_t &at(size_t xIndex, size_t yIndex)
+  {
+    return table.at(xIndex, yIndex);
+  }
+
+  uint8_t lookup(uint16_t x, uint8_t y)
+  {
+    lookups++;
+    return table.lookup(x, y);
+  }
+};
+
+void test_cachedTable_Deadband()
+{
+  CountingTable counting = {fuelTable, 0};
+  CachedTable2D<CountingTable> cached(counting, 8, 1);
+
+  TEST_ASSERT_FALSE(cached.valid());
+  TEST_ASSERT_EQUAL_UINT8(fuelTable.lookup(1500, 40), cached.lookup(1500, 40));
+  TEST_ASSERT_EQUAL(1, counting.lookups);
+
+  // Jitter within the deadband
+  uint8_t output = cached.lookup(1500, 40);
+  cached.lookup(1508, 41);
+  cached.lookup(1492, 39);
+  TEST_ASSERT_EQUAL_UINT8(output, cached(1504, 40));
+  TEST_ASSERT_EQUAL(1, counting.lookups);
+
+  // Outside the deadband in either axis
+  TEST_ASSERT_EQUAL_UINT8(fuelTable.lookup(1509, 40), cached.lookup(1509, 40));
+  TEST_ASSERT_EQUAL(2, counting.lookups);
+  TEST_ASSERT_EQUAL_UINT8(fuelTable.lookup(1509, 42), cached.lookup(1509, 42));
+  TEST_ASSERT_EQUAL(3, counting.lookups);
+
+  // Drift is measured from where the output was computed, not the last call
+  cached.lookup(1515, 42);
+  cached.lookup(1517, 42);
+  TEST_ASSERT_EQUAL(3, counting.lookups);
+  cached.lookup(1518, 42);
+  TEST_ASSERT_EQUAL(4, counting.lookups);
+
+  // Unsigned inputs below the cached one don't wrap
+  cached.lookup(0, 42);
+  TEST_ASSERT_EQUAL(5, counting.lookups);
+}
+
+void test_cachedTable_SignedAxes()
+{
+  Table2D<int16_t, int16_t, int16_t, 2, 2> trim = {
+    {-30000, 30000},
+    {0, 100},
+    {-1000, 1000,
+     -1000, 1000}};
+  CachedTable2D<Table2D<int16_t, int16_t, int16_t, 2, 2>> cached(trim, 4, 4);
+
+  TEST_ASSERT_EQUAL_INT16(-1000, cached.lookup(-30000, 0));
+  TEST_ASSERT_EQUAL_INT16(-1000, cached.lookup(-29996, 4));
+
+  // A jump wider than the signed range doesn't wrap into the deadband
+  TEST_ASSERT_EQUAL_INT16(trim.lookup(30000, 0), cached.lookup(30000, 0));
+  TEST_ASSERT_EQUAL_INT16(1000, cached.lookup(30000, 0));
+  TEST_ASSERT_EQUAL_INT16(trim.lookup(-30000, 0), cached.lookup(-30000, 0));
+}
+
+void test_cachedTable_Invalidate()
+{
+  FuelTable table = fuelTable;
+  CachedTable2D<FuelTable> cached(table, 50, 5);
+
+  TEST_ASSERT_EQUAL_UINT8(60, cached.lookup(2000, 20));
+
+  cached.set(1, 0, 70);
+  TEST_ASSERT_FALSE(cached.valid());
+  TEST_ASSERT_EQUAL_UINT8(70, cached.lookup(2000, 20));
+
+  // Editing the table directly needs an explicit invalidate
+  table.at(1, 0) = 90;
+  TEST_ASSERT_EQUAL_UINT8(70, cached.lookup(2010, 20));
+  cached.invalidate();
+  TEST_ASSERT_EQUAL_UINT8(90, cached.lookup(2000, 20));
+
+  cached.setDeadband(0, 0);
+  TEST_ASSERT_FALSE(cached.valid());
+  TEST_ASSERT_EQUAL_UINT8(table.lookup(2010, 20), cached.lookup(2010, 20));
+}
+
+void test_cachedTable_Timing()
+{
+  CachedTable2D<FuelTable> cached(fuelTable, 8, 1);
+  uint8_t direct, miss, hit;
+
+  TIME_START
+  direct = fuelTable.lookup(3100, 70);
+  TIME_END
+  uint16_t directTicks = TIME_DIFF;
+
+  TIME_START
+  miss = cached.lookup(3100, 70);
+  TIME_END
+  uint16_t missTicks = TIME_DIFF;
+
+  TIME_START
+  hit = cached.lookup(3104, 71);
+  TIME_END
+  uint16_t hitTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT8(direct, miss);
+  TEST_ASSERT_EQUAL_UINT8(direct, hit);
+
+  snprintf(message, MAX_MESSAGE_LEN, "Table2D::lookup %u ticks, CachedTable2D miss %u ticks, hit %u ticks",
+    directTicks, missTicks, hitTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(directTicks, hitTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_cachedTable_Deadband);
+  RUN_TEST(test_cachedTable_SignedAxes);
+  RUN_TEST(test_cachedTable_Invalidate);
+  RUN_TEST(test_cachedTable_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
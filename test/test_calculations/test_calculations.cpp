@@ -259,6 +259,51 @@ void test_expSmooth()
   test_expSmooth<26>(cur, prev, 0.3, 127);
 }
 
+void test_calculateAlphaFixedFromTime(uint32_t deltaTime, uint32_t timeConstant)
+{
+  uint8_t expected = static_cast<uint8_t>((1.0 - exp(-static_cast<float>(deltaTime) / timeConstant)) * (1 << 6) + 0.5);
+  volatile uint8_t actual;
+
+  TIME_START
+  actual = calculateAlphaFixedFromTime(deltaTime, timeConstant);
+  TIME_END
+
+  TEST_ASSERT_UINT8_WITHIN(1, expected, actual);
+
+  snprintf(message, MAX_MESSAGE_LEN, "calculateAlphaFixedFromTime(%lu, %lu): %u ticks",
+    static_cast<unsigned long>(deltaTime), static_cast<unsigned long>(timeConstant), static_cast<unsigned>(TIME_DIFF));
+  TEST_MESSAGE(message);
+}
+
+void test_calculateAlphaFixedFromTime()
+{
+  test_calculateAlphaFixedFromTime(0, 1000);
+  test_calculateAlphaFixedFromTime(100, 1000);
+  test_calculateAlphaFixedFromTime(1000, 1000);
+  test_calculateAlphaFixedFromTime(3333, 1000);
+  test_calculateAlphaFixedFromTime(20000, 1000);
+  test_calculateAlphaFixedFromTime(150000ul, 200000ul);
+}
+
+void test_expSmoothDeltaTime()
+{
+  volatile uint16_t cur = 800, prev = 900;
+  volatile uint32_t deltaTime = 3000, timeConstant = 10000;
+  volatile uint16_t actual;
+
+  uint8_t alpha = calculateAlphaFixedFromTime(deltaTime, timeConstant);
+  uint16_t expected = expSmooth(cur, prev, alpha);
+
+  TIME_START
+  actual = expSmoothDeltaTime(cur, prev, deltaTime, timeConstant);
+  TIME_END
+
+  TEST_ASSERT_EQUAL_UINT16(expected, actual);
+
+  snprintf(message, MAX_MESSAGE_LEN, "expSmoothDeltaTime: %u ticks", static_cast<unsigned>(TIME_DIFF));
+  TEST_MESSAGE(message);
+}
+
 void test_inAscendingOrder()
 {
   uint16_t advanceRpmArr[] = {
@@ -302,6 +347,8 @@ void setup() {
   RUN_TEST(test_calculateInjectionLength);
   RUN_TEST(test_load);
   RUN_TEST(test_expSmooth);
+  RUN_TEST(test_calculateAlphaFixedFromTime);
+  RUN_TEST(test_expSmoothDeltaTime);
   RUN_TEST(test_inAscendingOrder);
 
   UNITY_END(); // stop unit testing
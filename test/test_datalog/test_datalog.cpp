@@ -0,0 +1,189 @@
+// Datalog Tests
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef DatalogEncoder<
+  DatalogChannel<DatalogChannelId::Rpm, uint16_t>,
+  DatalogChannel<DatalogChannelId::Load, uint16_t>,
+  DatalogChannel<DatalogChannelId::Advance, int8_t>,
+  DatalogChannel<DatalogChannelId::ScheduledTicks, uint32_t>> EventEncoder;
+
+void test_datalog_Varint()
+{
+  const uint32_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 2097151, 2097152, 268435455, 268435456, 0xFFFFFFFF};
+  const uint8_t lengths[] = {1, 1, 1, 2, 2, 2, 3, 3, 4, 4, 5, 5};
+  uint8_t buffer[maxVarintSize];
+
+  for (uint8_t i = 0; i < sizeof(lengths); i++)
+  {
+    uint32_t decoded = 0;
+
+    TEST_ASSERT_EQUAL_UINT8(lengths[i], encodeVarint(buffer, values[i]));
+    TEST_ASSERT_EQUAL_UINT8(lengths[i], decodeVarint(buffer, sizeof(buffer), decoded));
+    TEST_ASSERT_EQUAL_UINT32(values[i], decoded);
+  }
+
+  // 300 is 0b10_0101100
+  encodeVarint(buffer, 300);
+  TEST_ASSERT_EQUAL_HEX8(0xAC, buffer[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, buffer[1]);
+
+  // Truncated
+  uint32_t decoded;
+  TEST_ASSERT_EQUAL_UINT8(0, decodeVarint(buffer, 1, decoded));
+}
+
+void test_datalog_Header()
+{
+  EventEncoder encoder;
+  uint8_t buffer[EventEncoder::headerSize];
+
+  TEST_ASSERT_EQUAL(22, EventEncoder::headerSize);
+  TEST_ASSERT_EQUAL(14, EventEncoder::maxRecordSize);
+  TEST_ASSERT_EQUAL(22, encoder.writeHeader(buffer, 2000000, 0x12345678));
+
+  const uint8_t expected[] = {
+    'E', 'C', 'D', 'L', 1, 4,
+    0x80, 0x84, 0x1E, 0x00,
+    0x78, 0x56, 0x34, 0x12,
+    1, 3,
+    2, 3,
+    9, 2,
+    10, 5};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected));
+}
+
+void test_datalog_Records()
+{
+  EventEncoder encoder;
+  uint8_t buffer[EventEncoder::headerSize + 3 * EventEncoder::maxRecordSize];
+
+  size_t length = encoder.writeHeader(buffer, 2000000, 0xFFFFFF00);
+  size_t headerLength = length;
+
+  length += encoder.encode(buffer + length, 0xFFFFFF40, 3000, 655, -5, 0x01020304);
+  TEST_ASSERT_EQUAL(headerLength + 10, length);
+
+  // Timer wraps around between events
+  length += encoder.encode(buffer + length, 0x00000100, 3010, 650, 12, 0x01020400);
+  TEST_ASSERT_EQUAL(headerLength + 21, length);
+
+  const uint8_t expected[] = {
+    0x40, 0xB8, 0x0B, 0x8F, 0x02, 0xFB, 0x04, 0x03, 0x02, 0x01,
+    0xC0, 0x03, 0xC2, 0x0B, 0x8A, 0x02, 0x0C, 0x00, 0x04, 0x02, 0x01};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer + headerLength, sizeof(expected));
+
+  // Decode the ticks back
+  uint32_t ticks = 0xFFFFFF00;
+  uint32_t delta = 0;
+  const uint8_t *record = buffer + headerLength;
+
+  record += decodeVarint(record, 5, delta) + 9;
+  ticks += delta;
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFF40, ticks);
+
+  decodeVarint(record, 5, delta);
+  ticks += delta;
+  TEST_ASSERT_EQUAL_HEX32(0x00000100, ticks);
+}
+
+void test_datalog_Timing()
+{
+  EventEncoder encoder;
+  uint8_t buffer[EventEncoder::headerSize + EventEncoder::maxRecordSize];
+  char text[48];
+  size_t length, textLength;
+
+  length = encoder.writeHeader(buffer, 2000000, 0);
+
+  TIME_START
+  length = encoder.encode(buffer, 1500, 3000, 655, 25, 40000);
+  TIME_END
+  uint16_t encodeTicks = TIME_DIFF;
+
+  // What's streamed today
+  TIME_START
+  textLength = snprintf(text, sizeof(text), "%lu,%u,%u,%d,%lu\n", 1500ul, 3000u, 655u, 25, 40000ul);
+  TIME_END
+  uint16_t textTicks = TIME_DIFF;
+
+  snprintf(message, MAX_MESSAGE_LEN, "Datalog record %u bytes in %u ticks, text %u bytes in %u ticks",
+    static_cast<unsigned>(length), encodeTicks, static_cast<unsigned>(textLength), textTicks);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_EQUAL(11, length);
+  TEST_ASSERT_LESS_THAN(textLength, length);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(textTicks, encodeTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_datalog_Varint);
+  RUN_TEST(test_datalog_Header);
+  RUN_TEST(test_datalog_Records);
+  RUN_TEST(test_datalog_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
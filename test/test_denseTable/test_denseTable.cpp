@@ -0,0 +1,169 @@
+// Test dense lookup tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// MAF transfer function: 10-bit ADC counts to g/s * 100
+constexpr uint16_t mafCounts[] = {0, 100, 180, 250, 320, 400, 480, 560, 650, 760, 880, 1023};
+constexpr uint16_t mafFlow[] = {0, 50, 180, 420, 800, 1500, 2600, 4300, 7000, 11500, 18000, 30000};
+constexpr size_t mafLength = 12;
+
+typedef DenseLinearTable<uint16_t, uint16_t, 10> FullMafTable;
+typedef DenseLinearTable<uint16_t, uint16_t, 8, 2> QuarterMafTable;
+typedef DenseLinearTable<uint8_t, uint16_t, 8, 2> CoarseMafTable;
+
+constexpr FullMafTable fullMafTable PROGMEM = makeDenseLinearTable<uint16_t, uint16_t, 10>(mafCounts, mafFlow, mafLength);
+constexpr QuarterMafTable quarterMafTable PROGMEM =
+  makeDenseLinearTable<uint16_t, uint16_t, 8, 2>(mafCounts, mafFlow, mafLength);
+constexpr CoarseMafTable coarseMafTable PROGMEM =
+  makeDenseLinearTable<uint8_t, uint16_t, 8, 2, 7>(mafCounts, mafFlow, mafLength);
+
+void test_denseTable_Expand()
+{
+  QuarterMafTable table;
+  table.expand<uint16_t>(mafLength, mafCounts, mafFlow);
+
+  TEST_ASSERT_EQUAL(256, QuarterMafTable::size);
+
+  for (uint16_t input = 0; input < 1100; input++)
+  {
+    // Past the end uses the last bucket
+    uint16_t bucketInput = ((input < 1024 ? input : 1023) & ~3u) + 2;
+    uint16_t expected = interpolateLinearTable<uint16_t>(bucketInput, mafLength, mafCounts, mafFlow);
+
+    TEST_ASSERT_EQUAL_UINT16(expected, table.lookup(input));
+  }
+}
+
+void test_denseTable_Constexpr()
+{
+  TEST_ASSERT_EQUAL_UINT16(0, fullMafTable.lookupProgmem(0));
+  TEST_ASSERT_EQUAL_UINT16(800, fullMafTable.lookupProgmem(320));
+  TEST_ASSERT_EQUAL_UINT16(30000, fullMafTable.lookupProgmem(1023));
+  TEST_ASSERT_EQUAL_UINT16(30000, fullMafTable.lookupProgmem(1200));
+
+  // Exact interpolation vs fixed-point interpolateLinear()
+  for (uint16_t input = 0; input < 1024; input++)
+  {
+    uint16_t expected = interpolateLinearTable<uint16_t>(input, mafLength, mafCounts, mafFlow);
+    TEST_ASSERT_UINT16_WITHIN(1, expected, fullMafTable.lookupProgmem(input));
+  }
+
+  QuarterMafTable table;
+  table.expand<uint16_t>(mafLength, mafCounts, mafFlow);
+
+  for (uint16_t input = 0; input < 1024; input++)
+  {
+    TEST_ASSERT_UINT16_WITHIN(1, table.lookup(input), quarterMafTable.lookupProgmem(input));
+  }
+}
+
+void test_denseTable_OutputQuantization()
+{
+  CoarseMafTable table;
+  table.expand<uint16_t>(mafLength, mafCounts, mafFlow, 7);
+
+  TEST_ASSERT_EQUAL_UINT8(234, table.lookup(1023));
+  TEST_ASSERT_EQUAL_UINT8(6, table.lookup(320));
+
+  for (uint16_t input = 0; input < 1024; input++)
+  {
+    uint16_t full = interpolateLinearTable<uint16_t>(static_cast<uint16_t>((input & ~3u) + 2), mafLength, mafCounts, mafFlow);
+    TEST_ASSERT_EQUAL_UINT8((full + 64) >> 7, table.lookup(input));
+    TEST_ASSERT_UINT8_WITHIN(1, table.lookup(input), coarseMafTable.lookupProgmem(input));
+  }
+}
+
+void test_denseTable_Timing()
+{
+  uint16_t input = 545;
+  uint16_t sparse, dense;
+
+  TIME_START
+  sparse = interpolateLinearTable<uint16_t>(input, mafLength, mafCounts, mafFlow);
+  TIME_END
+  uint16_t sparseTicks = TIME_DIFF;
+
+  TIME_START
+  dense = fullMafTable.lookupProgmem(input);
+  TIME_END
+  uint16_t denseTicks = TIME_DIFF;
+
+  TEST_ASSERT_UINT16_WITHIN(1, sparse, dense);
+
+  snprintf(message, MAX_MESSAGE_LEN, "interpolateLinearTable %u ticks, DenseLinearTable::lookupProgmem %u ticks",
+    sparseTicks, denseTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(sparseTicks, denseTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_denseTable_Expand);
+  RUN_TEST(test_denseTable_Constexpr);
+  RUN_TEST(test_denseTable_OutputQuantization);
+  RUN_TEST(test_denseTable_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
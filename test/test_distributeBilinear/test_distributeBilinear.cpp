@@ -0,0 +1,234 @@
+// Test bilinear distribution
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef Table2D<uint8_t, uint16_t, uint8_t, 4, 3> FuelTable;
+typedef Table2D<int8_t, uint16_t, uint8_t, 4, 3> TrimTable;
+
+const FuelTable fuelTable = {
+  {1000, 2000, 4000, 6000},
+  {20, 60, 100},
+  {100, 100, 100, 100,
+   100, 100, 100, 100,
+   100, 100, 100, 100}};
+
+void test_distributeBilinear_Weights()
+{
+  FuelTable table = fuelTable;
+
+  // A quarter of the way across both axes
+  table.distribute(table.locate(1250, 30), 160);
+  TEST_ASSERT_EQUAL_UINT8(190, table.at(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(130, table.at(1, 0));
+  TEST_ASSERT_EQUAL_UINT8(130, table.at(0, 1));
+  TEST_ASSERT_EQUAL_UINT8(110, table.at(1, 1));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(2, 0));
+
+  // On a cell
+  table = fuelTable;
+  table.distribute(table.locate(4000, 60), -30);
+  TEST_ASSERT_EQUAL_UINT8(70, table.at(2, 1));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(3, 1));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(2, 2));
+
+  // Off the scale, half way between rows
+  table = fuelTable;
+  table.distribute(table.locate(8000, 80), 20);
+  TEST_ASSERT_EQUAL_UINT8(110, table.at(3, 1));
+  TEST_ASSERT_EQUAL_UINT8(110, table.at(3, 2));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(2, 1));
+}
+
+void test_distributeBilinear_Clamps()
+{
+  FuelTable table = fuelTable;
+
+  table.distribute(table.locate(1000, 20), 500);
+  TEST_ASSERT_EQUAL_UINT8(255, table.at(0, 0));
+  table.distribute(table.locate(1000, 20), -1000);
+  TEST_ASSERT_EQUAL_UINT8(0, table.at(0, 0));
+
+  TrimTable trims = {
+    {1000, 2000, 4000, 6000},
+    {20, 60, 100},
+    {0}};
+
+  trims.distribute(trims.locate(1500, 40), -100);
+  TEST_ASSERT_EQUAL_INT8(-25, trims.at(0, 0));
+  TEST_ASSERT_EQUAL_INT8(-25, trims.at(1, 1));
+
+  trims.distribute(trims.locate(1000, 20), -200);
+  TEST_ASSERT_EQUAL_INT8(-128, trims.at(0, 0));
+  trims.distribute(trims.locate(1000, 20), 400);
+  TEST_ASSERT_EQUAL_INT8(127, trims.at(0, 0));
+}
+
+void test_distributeBilinear_Layouts()
+{
+  typedef Table2D<uint8_t, uint16_t, uint8_t, 4, 3, Tiled2x2Layout> TiledTable;
+  TiledTable tiled;
+  FuelTable rowMajor = fuelTable;
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    tiled.xScale[i] = fuelTable.xScale[i];
+  }
+
+  for (size_t i = 0; i < 3; i++)
+  {
+    tiled.yScale[i] = fuelTable.yScale[i];
+  }
+
+  tiled.load(fuelTable.cells);
+
+  tiled.distribute(tiled.locate(3000, 90), 40);
+  rowMajor.distribute(rowMajor.locate(3000, 90), 40);
+
+  for (size_t yIndex = 0; yIndex < 3; yIndex++)
+  {
+    for (size_t xIndex = 0; xIndex < 4; xIndex++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(rowMajor.at(xIndex, yIndex), tiled.at(xIndex, yIndex));
+    }
+  }
+}
+
+void test_distributeBilinear_FloatAxes()
+{
+  // Spacing under 1 would truncate to 0 if the weights were found in integers
+  Table2D<uint8_t, float, float, 3, 3> table = {
+    {0.0f, 0.5f, 1.0f},
+    {0.0f, 0.5f, 1.0f},
+    {100, 100, 100,
+     100, 100, 100,
+     100, 100, 100}};
+
+  table.distribute(table.locate(0.125f, 0.25f), 160);
+  TEST_ASSERT_EQUAL_UINT8(160, table.at(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(120, table.at(1, 0));
+  TEST_ASSERT_EQUAL_UINT8(160, table.at(0, 1));
+  TEST_ASSERT_EQUAL_UINT8(120, table.at(1, 1));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(2, 2));
+}
+
+void test_distributeBilinear_WideScales()
+{
+  // offset << weightBits needs more than 32 bits here
+  TEST_ASSERT_EQUAL_UINT16(119, bilinearHighWeight<7>(FindOnScaleResult::InBetween, 4000000000ul, 0ul, 4294967295ul));
+  TEST_ASSERT_EQUAL_UINT16(64, bilinearHighWeight<7>(FindOnScaleResult::InBetween, static_cast<int32_t>(0), static_cast<int32_t>(-2000000000), static_cast<int32_t>(2000000000)));
+}
+
+// Closed-loop learning: one pair of scale searches per event for both the lookup and the update
+void test_distributeBilinear_Learning()
+{
+  FuelTable table = fuelTable;
+  const uint8_t target = 130;
+
+  for (uint8_t event = 0; event < 40; event++)
+  {
+    BilinearTableLocation<uint16_t, uint8_t> location = table.locate(2600, 72);
+    int16_t error = static_cast<int16_t>(target) - table.lookup(location);
+    table.distribute(location, error);
+  }
+
+  TEST_ASSERT_UINT8_WITHIN(1, target, table.lookup(2600, 72));
+
+  // Far away cells weren't touched
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(100, table.at(3, 2));
+}
+
+void test_distributeBilinear_Timing()
+{
+  FuelTable table = fuelTable;
+
+  TIME_START
+  BilinearTableLocation<uint16_t, uint8_t> location = table.locate(2600, 72);
+  uint8_t value = table.lookup(location);
+  table.distribute(location, 10);
+  TIME_END
+  uint16_t learnTicks = TIME_DIFF;
+
+  TIME_START
+  uint8_t plain = table.lookup(2600, 72);
+  TIME_END
+  uint16_t lookupTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT8(100, value);
+  TEST_ASSERT_GREATER_THAN(100, plain);
+
+  snprintf(message, MAX_MESSAGE_LEN, "Lookup and distribute %u ticks, lookup alone %u ticks", learnTicks, lookupTicks);
+  TEST_MESSAGE(message);
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_distributeBilinear_Weights);
+  RUN_TEST(test_distributeBilinear_Clamps);
+  RUN_TEST(test_distributeBilinear_Layouts);
+  RUN_TEST(test_distributeBilinear_FloatAxes);
+  RUN_TEST(test_distributeBilinear_WideScales);
+  RUN_TEST(test_distributeBilinear_Learning);
+  RUN_TEST(test_distributeBilinear_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
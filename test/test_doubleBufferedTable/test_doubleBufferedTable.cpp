@@ -0,0 +1,179 @@
+// Test double-buffered tables
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef Table2D<uint8_t, uint16_t, uint8_t, 4, 3> SparkTable;
+
+const SparkTable initialTable = {
+  {1000, 2000, 4000, 6000},
+  {20, 60, 100},
+  { 10,  20,  30,  35,
+     8,  15,  25,  30,
+     5,  10,  20,  25}};
+
+void test_doubleBufferedTable_Batch()
+{
+  DoubleBufferedTable<SparkTable> table(initialTable);
+
+  TEST_ASSERT_EQUAL_UINT8(15, table.lookup(2000, 60));
+  TEST_ASSERT_FALSE(table.editing());
+
+  table.set(1, 1, 40);
+  table.set(2, 1, 50);
+  TEST_ASSERT_TRUE(table.editing());
+
+  // Readers don't see edits until they're published
+  TEST_ASSERT_EQUAL_UINT8(15, table.lookup(2000, 60));
+  TEST_ASSERT_EQUAL_UINT8(15, table.active().at(1, 1));
+
+  table.publish();
+  TEST_ASSERT_FALSE(table.editing());
+  TEST_ASSERT_EQUAL(1, table.publishCount());
+  TEST_ASSERT_EQUAL_UINT8(40, table.lookup(2000, 60));
+  TEST_ASSERT_EQUAL_UINT8(50, table.active().at(2, 1));
+
+  // Publishing without edits doesn't swap
+  table.publish();
+  TEST_ASSERT_EQUAL(1, table.publishCount());
+
+  // The next batch starts from the published table, not the stale copy
+  table.set(0, 0, 12);
+  table.publish();
+  TEST_ASSERT_EQUAL(2, table.publishCount());
+  TEST_ASSERT_EQUAL_UINT8(12, table.active().at(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(40, table.active().at(1, 1));
+  TEST_ASSERT_EQUAL_UINT8(50, table.active().at(2, 1));
+}
+
+void test_doubleBufferedTable_Upload()
+{
+  DoubleBufferedTable<SparkTable> table(initialTable);
+
+  SparkTable uploaded = initialTable;
+  for (size_t i = 0; i < SparkTable::cellCount; i++)
+  {
+    uploaded.cells[i] = static_cast<uint8_t>(uploaded.cells[i] + 5);
+  }
+
+  // Cell by cell, as it arrives over serial
+  for (size_t yIndex = 0; yIndex < SparkTable::ySize; yIndex++)
+  {
+    for (size_t xIndex = 0; xIndex < SparkTable::xSize; xIndex++)
+    {
+      table.set(xIndex, yIndex, uploaded.at(xIndex, yIndex));
+      TEST_ASSERT_EQUAL_UINT8(initialTable.at(xIndex, yIndex), table.active().at(xIndex, yIndex));
+    }
+  }
+
+  table.publish();
+  TEST_ASSERT_EQUAL(1, table.publishCount());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(uploaded.cells, table.active().cells, SparkTable::cellCount);
+
+  // Whole table at once, then thrown away
+  table.load(initialTable);
+  table.discard();
+  table.publish();
+  TEST_ASSERT_EQUAL(1, table.publishCount());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(uploaded.cells, table.active().cells, SparkTable::cellCount);
+
+  table.load(initialTable);
+  table.publish();
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(initialTable.cells, table.active().cells, SparkTable::cellCount);
+}
+
+void test_doubleBufferedTable_Timing()
+{
+  DoubleBufferedTable<SparkTable> table(initialTable);
+  SparkTable single = initialTable;
+
+  table.set(1, 1, 40);
+
+  TIME_START
+  table.publish();
+  TIME_END
+  uint16_t publishTicks = TIME_DIFF;
+
+  // What readers were blocked for before: copying the table with interrupts disabled
+  TIME_START
+  single = table.active();
+  TIME_END
+  uint16_t copyTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT8(40, single.at(1, 1));
+
+  snprintf(message, MAX_MESSAGE_LEN, "DoubleBufferedTable::publish %u ticks, table copy %u ticks",
+    publishTicks, copyTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(copyTicks, publishTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_doubleBufferedTable_Batch);
+  RUN_TEST(test_doubleBufferedTable_Upload);
+  RUN_TEST(test_doubleBufferedTable_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
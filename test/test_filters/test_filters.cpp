@@ -0,0 +1,318 @@
+// Test filters
+// Copyright (C) 2021  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+const uint16_t samples[] = {
+  512, 530, 498, 1023, 505, 515, 0, 520, 511, 509, 640, 502, 499, 517, 503, 1000};
+
+const size_t sampleCount = sizeof(samples) / sizeof(samples[0]);
+
+// Sliding window average the way we used to do it: shift the window and sum it every sample
+template<typename TVal, uint8_t length, typename TSum>
+class NaiveMovingAverage
+{
+public:
+  NaiveMovingAverage(TVal initial)
+  {
+    for (uint8_t i = 0; i < length; i++)
+    {
+      _values[i] = initial;
+    }
+  }
+
+  TVal operator() (TVal cur)
+  {
+    for (uint8_t i = length - 1; i > 0; i--)
+    {
+      _values[i] = _values[i - 1];
+    }
+    _values[0] = cur;
+
+    TSum sum = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+      sum += _values[i];
+    }
+
+    return static_cast<TVal>((sum + length / 2) / length);
+  }
+
+private:
+  TVal _values[length];
+};
+
+// Median the way we used to do it: insertion sort a copy of the window
+template<typename TVal, uint8_t length>
+TVal naiveMedian(const TVal *values)
+{
+  TVal sorted[length];
+
+  for (uint8_t i = 0; i < length; i++)
+  {
+    TVal cur = values[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > cur)
+    {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = cur;
+  }
+
+  return sorted[length / 2];
+}
+
+template<uint8_t length>
+void test_movingAverage()
+{
+  MovingAverage<uint16_t, length, 10> average(512);
+  NaiveMovingAverage<uint16_t, length, uint32_t> naive(512);
+  volatile uint16_t actual, expected;
+  uint16_t ticks = 0, naiveTicks = 0;
+
+  for (size_t i = 0; i < sampleCount; i++)
+  {
+    TIME_START
+    expected = naive(samples[i]);
+    TIME_END
+    naiveTicks += TIME_DIFF;
+
+    TIME_START
+    actual = average(samples[i]);
+    TIME_END
+    ticks += TIME_DIFF;
+
+    TEST_ASSERT_EQUAL_UINT16(expected, actual);
+  }
+
+  snprintf(message, MAX_MESSAGE_LEN, "MovingAverage<%u>: %u ticks, naive: %u ticks",
+    static_cast<unsigned>(length), static_cast<unsigned>(ticks / sampleCount), static_cast<unsigned>(naiveTicks / sampleCount));
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(naiveTicks, ticks);
+#endif
+}
+
+void test_movingAverage4()
+{
+  test_movingAverage<4>();
+}
+
+void test_movingAverage10()
+{
+  test_movingAverage<10>();
+}
+
+void test_movingAverage_Overflow()
+{
+  // 16 full-scale 16-bit samples need a 20-bit sum
+  MovingAverage<uint16_t, 16> average(65535);
+
+  TEST_ASSERT_EQUAL_UINT16(65535, average(65535));
+  TEST_ASSERT_EQUAL_UINT16(61439, average(0));
+}
+
+void test_movingAverage_Signed()
+{
+  MovingAverage<int8_t, 4> average(0);
+
+  average(-100);
+  average(-100);
+  average(-100);
+
+  TEST_ASSERT_EQUAL_INT8(-75, average.average());
+  TEST_ASSERT_EQUAL_INT8(-100, average(-100));
+  TEST_ASSERT_EQUAL_INT8(-74, average(3));
+}
+
+template<uint8_t length>
+void test_medianFilter()
+{
+  MedianFilter<uint16_t, length> median(512);
+  uint16_t window[length];
+  volatile uint16_t actual, expected;
+  uint16_t ticks = 0, naiveTicks = 0;
+
+  for (uint8_t i = 0; i < length; i++)
+  {
+    window[i] = 512;
+  }
+
+  for (size_t i = 0; i < sampleCount; i++)
+  {
+    window[i % length] = samples[i];
+
+    TIME_START
+    expected = naiveMedian<uint16_t, length>(window);
+    TIME_END
+    naiveTicks += TIME_DIFF;
+
+    TIME_START
+    actual = median(samples[i]);
+    TIME_END
+    ticks += TIME_DIFF;
+
+    TEST_ASSERT_EQUAL_UINT16(expected, actual);
+  }
+
+  snprintf(message, MAX_MESSAGE_LEN, "MedianFilter<%u>: %u ticks, naive: %u ticks",
+    static_cast<unsigned>(length), static_cast<unsigned>(ticks / sampleCount), static_cast<unsigned>(naiveTicks / sampleCount));
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(naiveTicks, ticks);
+#endif
+}
+
+void test_medianFilter3()
+{
+  test_medianFilter<3>();
+}
+
+void test_medianFilter5()
+{
+  test_medianFilter<5>();
+}
+
+void test_medianFilter7()
+{
+  test_medianFilter<7>();
+}
+
+void test_median_RejectsSpike()
+{
+  TEST_ASSERT_EQUAL_UINT8(10, median3<uint8_t>(10, 255, 9));
+  TEST_ASSERT_EQUAL_UINT8(10, median5<uint8_t>(10, 255, 9, 11, 0));
+  TEST_ASSERT_EQUAL_INT16(-3, median7<int16_t>(-3, 255, -9, 11, 0, -32768, -4));
+}
+
+void test_decimator()
+{
+  Decimator<10, 12> decimator;
+  uint16_t output;
+  uint16_t ticks = 0;
+
+  TEST_ASSERT_EQUAL(16, decimator.samplesPerOutput);
+
+  for (uint8_t i = 0; i < 15; i++)
+  {
+    decimator.add(i % 2 == 0 ? 1023 : 1022);
+  }
+
+  TEST_ASSERT_FALSE(decimator.read(output));
+
+  TIME_START
+  decimator.add(1022);
+  TIME_END
+  ticks = TIME_DIFF;
+
+  TEST_ASSERT_TRUE(decimator.read(output));
+  TEST_ASSERT_EQUAL_UINT16(4090, output);
+  TEST_ASSERT_FALSE(decimator.read(output));
+
+  snprintf(message, MAX_MESSAGE_LEN, "Decimator::add with output: %u ticks", ticks);
+  TEST_MESSAGE(message);
+
+  TIME_START
+  decimator.add(1023);
+  TIME_END
+  ticks = TIME_DIFF;
+
+  snprintf(message, MAX_MESSAGE_LEN, "Decimator::add: %u ticks", ticks);
+  TEST_MESSAGE(message);
+}
+
+void test_decimator_IntoExpSmooth()
+{
+  typedef Decimator<10, 12, 6> MapDecimator;
+  MapDecimator decimator;
+  uint16_t output;
+  uint16_t smoothed = 2000;
+
+  for (uint8_t i = 0; i < 64; i++)
+  {
+    decimator.add(512);
+  }
+
+  TEST_ASSERT_TRUE(decimator.read(output));
+  TEST_ASSERT_EQUAL_UINT16(2048, output);
+
+  smoothed = expSmooth<6, uint16_t, MapDecimator::valueBits>(output, smoothed, 32);
+  TEST_ASSERT_EQUAL_UINT16(2024, smoothed);
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_movingAverage4);
+  RUN_TEST(test_movingAverage10);
+  RUN_TEST(test_movingAverage_Overflow);
+  RUN_TEST(test_movingAverage_Signed);
+  RUN_TEST(test_medianFilter3);
+  RUN_TEST(test_medianFilter5);
+  RUN_TEST(test_medianFilter7);
+  RUN_TEST(test_median_RejectsSpike);
+  RUN_TEST(test_decimator);
+  RUN_TEST(test_decimator_IntoExpSmooth);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
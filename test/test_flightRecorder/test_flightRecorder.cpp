@@ -0,0 +1,226 @@
+// Flight Recorder Tests
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// Calls interrupt() partway through being copied, like an ISR firing during read()
+void (*interrupt)() = nullptr;
+
+struct InterruptedSnapshot
+{
+  uint16_t value;
+
+  InterruptedSnapshot &operator=(const InterruptedSnapshot &other)
+  {
+    value = other.value;
+
+    void (*pending)() = interrupt;
+    interrupt = nullptr;
+    if (pending)
+    {
+      pending();
+    }
+
+    return *this;
+  }
+};
+
+FlightRecorder<InterruptedSnapshot, 2> interruptedRecorder;
+uint16_t nextValue;
+
+void recordFive()
+{
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    InterruptedSnapshot snapshot;
+    snapshot.value = nextValue++;
+    interruptedRecorder.record(snapshot);
+  }
+}
+
+void test_flightRecorder_Order()
+{
+  FlightRecorder<uint16_t, 3> recorder;
+  uint16_t value;
+
+  TEST_ASSERT_EQUAL(8, recorder.capacity);
+  TEST_ASSERT_FALSE(recorder.read(value));
+
+  for (uint16_t i = 0; i < 5; i++)
+  {
+    recorder.record(i);
+  }
+
+  TEST_ASSERT_EQUAL(5, recorder.available());
+
+  for (uint16_t i = 0; i < 5; i++)
+  {
+    TEST_ASSERT_TRUE(recorder.read(value));
+    TEST_ASSERT_EQUAL_UINT16(i, value);
+  }
+
+  TEST_ASSERT_FALSE(recorder.read(value));
+  TEST_ASSERT_EQUAL(0, recorder.lost());
+}
+
+void test_flightRecorder_Overwrite()
+{
+  FlightRecorder<uint16_t, 3> recorder;
+  uint16_t value;
+
+  for (uint16_t i = 0; i < 20; i++)
+  {
+    recorder.record(i);
+  }
+
+  // Keeps the last 8
+  TEST_ASSERT_EQUAL(8, recorder.available());
+
+  for (uint16_t i = 12; i < 20; i++)
+  {
+    TEST_ASSERT_TRUE(recorder.read(value));
+    TEST_ASSERT_EQUAL_UINT16(i, value);
+  }
+
+  TEST_ASSERT_FALSE(recorder.read(value));
+  TEST_ASSERT_EQUAL(12, recorder.lost());
+  TEST_ASSERT_EQUAL(20, recorder.recorded());
+}
+
+void test_flightRecorder_CounterWrap()
+{
+  FlightRecorder<uint16_t, 3> recorder;
+  uint16_t value;
+
+  for (uint32_t i = 0; i < 70000; i++)
+  {
+    recorder.record(static_cast<uint16_t>(i));
+
+    if (i % 4 == 3)
+    {
+      while (recorder.read(value))
+      {
+      }
+
+      TEST_ASSERT_EQUAL_UINT16(static_cast<uint16_t>(i), value);
+    }
+  }
+
+  TEST_ASSERT_EQUAL(0, recorder.lost());
+}
+
+void test_flightRecorder_OverwrittenWhileReading()
+{
+  InterruptedSnapshot snapshot;
+  nextValue = 0;
+
+  // Fill, then lap the slot being read while it's copied
+  recordFive();
+  interrupt = recordFive;
+
+  // 0 is already lost. 1 is copied, then overwritten along with 2 to 5.
+  TEST_ASSERT_TRUE(interruptedRecorder.read(snapshot));
+  TEST_ASSERT_EQUAL_UINT16(6, snapshot.value);
+  TEST_ASSERT_EQUAL(6, interruptedRecorder.lost());
+
+  TEST_ASSERT_TRUE(interruptedRecorder.read(snapshot));
+  TEST_ASSERT_EQUAL_UINT16(7, snapshot.value);
+  TEST_ASSERT_TRUE(interruptedRecorder.read(snapshot));
+  TEST_ASSERT_EQUAL_UINT16(8, snapshot.value);
+  TEST_ASSERT_TRUE(interruptedRecorder.read(snapshot));
+  TEST_ASSERT_EQUAL_UINT16(9, snapshot.value);
+  TEST_ASSERT_FALSE(interruptedRecorder.read(snapshot));
+}
+
+void test_flightRecorder_Timing()
+{
+  FlightRecorder<EventSnapshot, 5> recorder;
+  EventSnapshot snapshot = {123456, 90, 3000, 655, 1200, 25, 8000, 130000};
+  EventSnapshot out;
+
+  TIME_START
+  recorder.record(snapshot);
+  TIME_END
+  uint16_t recordTicks = TIME_DIFF;
+
+  TIME_START
+  recorder.read(out);
+  TIME_END
+  uint16_t readTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT32(snapshot.scheduledTicks, out.scheduledTicks);
+  TEST_ASSERT_EQUAL_INT16(snapshot.advance, out.advance);
+
+  snprintf(message, MAX_MESSAGE_LEN, "FlightRecorder<EventSnapshot, 5> %u bytes, record %u ticks, read %u ticks",
+    static_cast<unsigned>(sizeof(recorder)), recordTicks, readTicks);
+  TEST_MESSAGE(message);
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_flightRecorder_Order);
+  RUN_TEST(test_flightRecorder_Overwrite);
+  RUN_TEST(test_flightRecorder_CounterWrap);
+  RUN_TEST(test_flightRecorder_OverwrittenWhileReading);
+  RUN_TEST(test_flightRecorder_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
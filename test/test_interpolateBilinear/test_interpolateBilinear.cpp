@@ -303,12 +303,109 @@ Z interpolateBilinearFloat(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01
   return static_cast<Z>(interpolateBilinearXFirst<float, float, float>(x, x0, x1, y, y0, y1, z00, z10, z01, z11) + 0.5);
 }
 
+// Round away from zero
+template<typename X, typename Y, typename Z>
+Z interpolateBilinearSignedFloat(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01, Z z11)
+{
+  float z = interpolateBilinearXFirst<float, float, float>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+  return static_cast<Z>(z < 0 ? z - 0.5 : z + 0.5);
+}
+
 template<typename X, typename Y, typename Z>
 Z interpolateBilinearUFixed64(X x, X x0, X x1, Y y, Y y0, Y y1, Z z00, Z z10, Z z01, Z z11)
 {
   return static_cast<Z>(interpolateBilinearXFirst<uint64_t, uint64_t, uint64_t>(x, x0, x1, y, y0, y1, z00, z10, z01, z11));
 }
 
+template<typename X, typename Y, typename Z>
+void test_interpolateBilinearSigned()
+{
+  volatile X x, x0, x1;
+  volatile Y y, y0, y1;
+  volatile Z z00, z10;
+  volatile Z z01, z11;
+  volatile Z actual;
+  volatile Z reference;
+  uint16_t fixedTicks;
+  uint16_t floatTicks;
+
+  x0 = 0;
+  x1 = 127;
+  y0 = 0;
+  y1 = 127;
+
+  z00 = -100;
+  z10 = 60;
+  z01 = 40;
+  z11 = -120;
+
+  x = 63;
+  y = 63;
+
+  TIME_START
+  actual = interpolateBilinear<X, Y, Z>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+  TIME_END
+  fixedTicks = TIME_DIFF;
+  TEST_ASSERT_EQUAL(-30, actual); // -29.926
+
+  TIME_START
+  reference = interpolateBilinearSignedFloat<X, Y, Z>(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+  TIME_END
+  floatTicks = TIME_DIFF;
+  TEST_ASSERT_EQUAL(-30, reference);
+
+  x = 100;
+  y = 20;
+  TEST_ASSERT_EQUAL(8, (interpolateBilinear<X, Y, Z>(x, x0, x1, y, y0, y1, z00, z10, z01, z11))); // 8.351
+
+  x = 10;
+  y = 110;
+  TEST_ASSERT_EQUAL(12, (interpolateBilinear<X, Y, Z>(x, x0, x1, y, y0, y1, z00, z10, z01, z11))); // 12.034
+
+  snprintf(message, MAX_MESSAGE_LEN, "Signed fixed point %u ticks, float %u ticks", fixedTicks, floatTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(floatTicks, fixedTicks);
+#endif
+}
+
+void test_interpolateBilinearTableSigned()
+{
+  // Ignition advance: RPM x load
+  const uint16_t rpmScale[] = {1000, 3000, 6000};
+  const uint8_t loadScale[] = {20, 100};
+  const int8_t advance[] = {
+    10, 30, 35,   //  20
+    -5, 12, 20};  // 100
+
+  TEST_ASSERT_EQUAL(2, (interpolateBilinearTable<int8_t>(static_cast<uint16_t>(1000), static_cast<uint8_t>(60), 3, 2, rpmScale, loadScale, advance)));
+  TEST_ASSERT_EQUAL(-5, (interpolateBilinearTable<int8_t>(static_cast<uint16_t>(500), static_cast<uint8_t>(255), 3, 2, rpmScale, loadScale, advance)));
+  TEST_ASSERT_EQUAL(12, (interpolateBilinearTable<int8_t>(static_cast<uint16_t>(2000), static_cast<uint8_t>(60), 3, 2, rpmScale, loadScale, advance)));
+}
+
+void test_interpolateBilinearWideCells()
+{
+  // Products of 8-bit x deltas and cells near the top of uint16_t overflow a 16-bit product
+  volatile uint8_t x0 = 0, x1 = 255;
+  volatile uint16_t y0 = 0, y1 = 65535;
+  volatile uint16_t z00 = 60000, z10 = 65535, z01 = 50000, z11 = 65535;
+  const uint8_t xs[] = {1, 63, 128, 254};
+  const uint16_t ys[] = {0, 1000, 32768, 65535};
+
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    for (uint8_t j = 0; j < 4; j++)
+    {
+      uint16_t expected = interpolateBilinearFloat<uint8_t, uint16_t, uint16_t>(xs[i], x0, x1, ys[j], y0, y1, z00, z10, z01, z11);
+      uint16_t actual = interpolateBilinear<uint8_t, uint16_t, uint16_t>(xs[i], x0, x1, ys[j], y0, y1, z00, z10, z01, z11);
+
+      snprintf(message, MAX_MESSAGE_LEN, "x %u y %u", xs[i], ys[j]);
+      TEST_ASSERT_UINT16_WITHIN_MESSAGE(1, expected, actual, message);
+    }
+  }
+}
+
 void setup() {
   // NOTE!!! Wait for >2 secs
   // if board doesn't support software reset via Serial.DTR/RTS
@@ -339,6 +436,7 @@ void setup() {
 
   RUN_TEST((test_interpolateBilinear<uint8_t, uint16_t, uint16_t, 1435, 30>));
   RUN_TEST((test_interpolateBilinear<uint8_t, uint16_t, uint16_t, 2502, 150, interpolateBilinearFloat>));
+  RUN_TEST(test_interpolateBilinearWideCells);
 
   RUN_TEST((test_interpolateBilinear<uint8_t, uint16_t, uint32_t, 3346, 30, interpolateBilinearUFixed64>));
   RUN_TEST((test_interpolateBilinear<uint8_t, uint16_t, uint32_t, 2550, 150, interpolateBilinearFloat>));
@@ -357,6 +455,20 @@ void setup() {
   RUN_TEST((test_interpolateBilinear<uint16_t, uint16_t, uint16_t, 2502, 150, interpolateBilinearFloat>));
   RUN_TEST(test_interpolateBilinearTable);
 
+  RUN_TEST((test_interpolateBilinearSigned<uint8_t, uint8_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint8_t, uint8_t, int16_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint8_t, uint16_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint8_t, uint16_t, int16_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint16_t, uint8_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint16_t, uint8_t, int16_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint16_t, uint16_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<uint16_t, uint16_t, int16_t>));
+  RUN_TEST((test_interpolateBilinearSigned<int8_t, int8_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<int8_t, int8_t, int16_t>));
+  RUN_TEST((test_interpolateBilinearSigned<int16_t, int16_t, int8_t>));
+  RUN_TEST((test_interpolateBilinearSigned<int16_t, int16_t, int16_t>));
+  RUN_TEST(test_interpolateBilinearTableSigned);
+
   UNITY_END(); // stop unit testing
 }
 
@@ -195,6 +195,125 @@ void test_interpolateLinearTable()
   TEST_ASSERT_EQUAL(expected, actual);
 }
 
+template<typename InputType, typename OutputType>
+void test_interpolateLinearSigned()
+{
+  volatile InputType input;
+  volatile InputType inputLow;
+  volatile InputType inputHigh;
+  volatile OutputType outputLow;
+  volatile OutputType outputHigh;
+
+  volatile OutputType actual;
+  volatile float reference;
+  uint16_t fixedTicks;
+  uint16_t floatTicks;
+
+  inputLow = 0;
+  inputHigh = 127;
+  outputLow = -95;
+  outputHigh = 95;
+
+  input = 63;
+  TIME_START
+  actual = interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh);
+  TIME_END
+  fixedTicks = TIME_DIFF;
+  TEST_ASSERT_EQUAL(-1, actual); // -0.748
+
+  TIME_START
+  reference = interpolateLinear<InputType, OutputType, float>(input, inputLow, inputHigh, outputLow, outputHigh);
+  TIME_END
+  floatTicks = TIME_DIFF;
+  TEST_ASSERT_FLOAT_WITHIN(0.001, -0.748, reference);
+
+  // Mirrored
+  outputLow = 95;
+  outputHigh = -95;
+  input = 64;
+  actual = interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh);
+  TEST_ASSERT_EQUAL(-1, actual); // -0.748
+
+  outputLow = -100;
+  outputHigh = 20;
+  input = 60;
+  actual = interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh);
+  TEST_ASSERT_EQUAL(-43, actual); // -43.307
+
+  outputLow = 20;
+  outputHigh = -100;
+  input = 67;
+  actual = interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh);
+  TEST_ASSERT_EQUAL(-43, actual); // -43.307
+
+  snprintf(message, MAX_MESSAGE_LEN, "Signed fixed point %u ticks, float %u ticks", fixedTicks, floatTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(floatTicks, fixedTicks);
+#endif
+}
+
+template<typename InputType, typename OutputType>
+void test_interpolateLinearSignedInput()
+{
+  volatile InputType input;
+  volatile InputType inputLow;
+  volatile InputType inputHigh;
+  volatile OutputType outputLow;
+  volatile OutputType outputHigh;
+
+  inputLow = -100;
+  inputHigh = 27;
+  outputLow = -95;
+  outputHigh = 95;
+
+  input = -37;
+  TEST_ASSERT_EQUAL(-1, (interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh)));
+
+  input = -100;
+  TEST_ASSERT_EQUAL(-95, (interpolateLinear<InputType, OutputType>(input, inputLow, inputHigh, outputLow, outputHigh)));
+
+  const InputType inputScale[] = {-100, -50, 0, 50};
+  const OutputType outputArray[] = {-20, -10, 10, 30};
+
+  TEST_ASSERT_EQUAL(-15, (interpolateLinearTable<OutputType>(static_cast<InputType>(-75), 4, inputScale, outputArray)));
+  TEST_ASSERT_EQUAL(0, (interpolateLinearTable<OutputType>(static_cast<InputType>(-25), 4, inputScale, outputArray)));
+  TEST_ASSERT_EQUAL(-20, (interpolateLinearTable<OutputType>(static_cast<InputType>(-120), 4, inputScale, outputArray)));
+}
+
+void test_interpolateLinearSignedWide()
+{
+  volatile int16_t input;
+  volatile int16_t inputLow = -30000;
+  volatile int16_t inputHigh = 30000;
+  volatile int16_t outputLow = -20000;
+  volatile int16_t outputHigh = 20000;
+
+  // Full-range differences would overflow 16-bit int on AVR if subtracted before upcasting
+  input = 0;
+  TEST_ASSERT_INT16_WITHIN(2, 0, (interpolateLinear<int16_t, int16_t>(input, inputLow, inputHigh, outputLow, outputHigh)));
+
+  input = 15000;
+  TEST_ASSERT_INT16_WITHIN(2, 10000, (interpolateLinear<int16_t, int16_t>(input, inputLow, inputHigh, outputLow, outputHigh)));
+
+  input = -29999;
+  TEST_ASSERT_INT16_WITHIN(2, -19999, (interpolateLinear<int16_t, int16_t>(input, inputLow, inputHigh, outputLow, outputHigh)));
+}
+
+void test_interpolateLinearSignedLimits()
+{
+  // The rounded slope overshoots the far endpoint, which must not wrap past the int16 limits
+  TEST_ASSERT_EQUAL_INT16(-32768, (interpolateLinear<int16_t, int16_t>(-16320, -32768, -16320, -1, -32768)));
+  TEST_ASSERT_EQUAL_INT16(-32768, (interpolateLinear<uint16_t, int16_t>(16448, 0, 16448, -1, -32768)));
+  TEST_ASSERT_EQUAL_INT16(32767, (interpolateLinear<int16_t, int16_t>(-16320, -32768, -16320, -1, 32767)));
+  TEST_ASSERT_EQUAL_INT16(32767, (interpolateLinear<uint16_t, int16_t>(16448, 0, 16448, -1, 32767)));
+
+  TEST_ASSERT_EQUAL_INT16(-32768, (interpolateLinearKernel<InterpolationKernel::FixedPoint, int16_t, int16_t>(-16320, -32768, -16320, -1, -32768)));
+  TEST_ASSERT_EQUAL_INT16(-32768, (interpolateLinearKernel<InterpolationKernel::FixedPoint, uint16_t, int16_t>(16448, 0, 16448, -1, -32768)));
+  TEST_ASSERT_EQUAL_INT16(-1, (interpolateLinearKernel<InterpolationKernel::FixedPoint, uint16_t, int16_t>(0, 0, 16448, -1, -32768)));
+}
+
 template<typename InputType, typename OutputType, typename SlopeType>
 OutputType interpolateLinearReturnOutputType(InputType input, InputType inputLow, InputType inputHigh, OutputType output0, OutputType output1)
 {
@@ -255,6 +374,19 @@ void setup() {
 
   RUN_TEST(test_interpolateLinearTable);
 
+  RUN_TEST((test_interpolateLinearSigned<uint8_t, int8_t>));
+  RUN_TEST((test_interpolateLinearSigned<uint8_t, int16_t>));
+  RUN_TEST((test_interpolateLinearSigned<uint16_t, int8_t>));
+  RUN_TEST((test_interpolateLinearSigned<uint16_t, int16_t>));
+  RUN_TEST((test_interpolateLinearSigned<int8_t, int8_t>));
+  RUN_TEST((test_interpolateLinearSigned<int8_t, int16_t>));
+  RUN_TEST((test_interpolateLinearSigned<int16_t, int8_t>));
+  RUN_TEST((test_interpolateLinearSigned<int16_t, int16_t>));
+  RUN_TEST((test_interpolateLinearSignedInput<int8_t, int8_t>));
+  RUN_TEST((test_interpolateLinearSignedInput<int16_t, int16_t>));
+  RUN_TEST(test_interpolateLinearSignedWide);
+  RUN_TEST(test_interpolateLinearSignedLimits);
+
   UNITY_END(); // stop unit testing
 }
 
@@ -0,0 +1,258 @@
+// Test multilinear interpolation
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+const uint8_t xScale[] = {0, 100, 150, 200, 250};
+const uint8_t yScale[] = {0, 100, 200};
+
+const uint8_t cells2D[] = {
+    0, 100, 200,  40, 90,  //   0
+   50, 150, 250,  60, 10,  // 100
+   20,  30,  40, 200, 70}; // 200
+
+// cell = 2*i + 3*j + 5*k + 7*l so any interpolation of it is exact
+const uint8_t linearScale[] = {0, 10, 20, 30};
+const size_t linearLengths[] = {4, 4, 4, 4};
+const uint8_t *linearScales[] = {linearScale, linearScale, linearScale, linearScale};
+uint8_t linearCells[4 * 4 * 4 * 4];
+
+void fillLinearCells()
+{
+  for (uint8_t l = 0; l < 4; l++)
+    for (uint8_t k = 0; k < 4; k++)
+      for (uint8_t j = 0; j < 4; j++)
+        for (uint8_t i = 0; i < 4; i++)
+        {
+          linearCells[((l * 4 + k) * 4 + j) * 4 + i] = 2 * i + 3 * j + 5 * k + 7 * l;
+        }
+}
+
+void test_interpolateMultilinear_MatchesBilinear()
+{
+  const size_t lengths[] = {5, 3};
+  const uint8_t *scales[] = {xScale, yScale};
+
+  for (uint16_t x = 1; x < 250; x += 3)
+  {
+    for (uint16_t y = 1; y < 200; y += 3)
+    {
+      const uint8_t inputs[] = {static_cast<uint8_t>(x), static_cast<uint8_t>(y)};
+
+      size_t xIndex, yIndex;
+      uint8_t x0, x1, y0, y1;
+      FindOnScaleResult xResult = findOnScale(inputs[0], xScale, 5, xIndex, x0, x1);
+      FindOnScaleResult yResult = findOnScale(inputs[1], yScale, 3, yIndex, y0, y1);
+
+      uint8_t actual = interpolateMultilinearTable<2, uint8_t, uint32_t, uint16_t>(inputs, lengths, scales, cells2D);
+
+      if (FindOnScaleResult::InBetween == xResult && FindOnScaleResult::InBetween == yResult)
+      {
+        uint8_t expected = interpolateBilinear<uint8_t, uint8_t, uint8_t>(inputs[0], x0, x1, inputs[1], y0, y1,
+          cells2D[yIndex * 5 + xIndex], cells2D[yIndex * 5 + xIndex + 1],
+          cells2D[(yIndex + 1) * 5 + xIndex], cells2D[(yIndex + 1) * 5 + xIndex + 1]);
+
+        TEST_ASSERT_EQUAL_UINT8(expected, actual);
+      }
+      else
+      {
+        uint8_t expected = interpolateBilinearTable<uint8_t>(inputs[0], inputs[1], 5, 3, xScale, yScale, cells2D);
+        TEST_ASSERT_UINT8_WITHIN(1, expected, actual);
+      }
+    }
+  }
+}
+
+void test_interpolateMultilinear_Edges()
+{
+  const size_t lengths[] = {5, 3};
+  const uint8_t *scales[] = {xScale, yScale};
+
+  const uint8_t onCell[] = {150, 100};
+  TEST_ASSERT_EQUAL_UINT8(250, (interpolateMultilinearTable<2, uint8_t, uint32_t, uint16_t>(onCell, lengths, scales, cells2D)));
+
+  const uint8_t offScale[] = {255, 255};
+  TEST_ASSERT_EQUAL_UINT8(70, (interpolateMultilinearTable<2, uint8_t, uint32_t, uint16_t>(offScale, lengths, scales, cells2D)));
+
+  const uint8_t belowScale[] = {50, 0};
+  TEST_ASSERT_EQUAL_UINT8(50, (interpolateMultilinearTable<2, uint8_t, uint32_t, uint16_t>(belowScale, lengths, scales, cells2D)));
+}
+
+void test_interpolateMultilinear_3D()
+{
+  for (uint8_t x = 0; x <= 30; x += 3)
+  {
+    for (uint8_t y = 0; y <= 30; y += 5)
+    {
+      for (uint8_t z = 0; z <= 30; z += 7)
+      {
+        const uint8_t inputs[] = {x, y, z};
+        // Drop the l axis by sticking to its first slice
+        uint8_t expected = (2 * x + 3 * y + 5 * z + 5) / 10;
+        uint8_t actual = interpolateMultilinearTable<3, uint8_t, uint32_t, uint16_t>(inputs, linearLengths,
+          linearScales, linearCells);
+        TEST_ASSERT_UINT8_WITHIN(1, expected, actual);
+      }
+    }
+  }
+
+  // Compare against the two-bilinear-lookups-then-linear path of Table3D
+  Table3D<uint8_t, uint8_t, uint8_t, uint8_t, 2, 2, 2> table = {
+    {0, 100},
+    {0, 100},
+    {0, 80},
+    { 0, 100,
+     50, 150,
+     80, 180,
+    130, 230}};
+
+  const size_t lengths[] = {2, 2, 2};
+  const uint8_t *scales[] = {table.xScale, table.yScale, table.wScale};
+
+  for (uint8_t x = 0; x < 120; x += 7)
+  {
+    for (uint8_t y = 0; y < 120; y += 11)
+    {
+      for (uint8_t w = 0; w < 100; w += 9)
+      {
+        const uint8_t inputs[] = {x, y, w};
+        TEST_ASSERT_UINT8_WITHIN(1, table.lookup(x, y, w),
+          (interpolateMultilinearTable<3, uint8_t, uint32_t, uint16_t>(inputs, lengths, scales, table.cells)));
+      }
+    }
+  }
+}
+
+void test_interpolateMultilinear_4D()
+{
+  for (uint8_t i = 0; i <= 30; i += 7)
+  {
+    for (uint8_t j = 0; j <= 30; j += 5)
+    {
+      for (uint8_t k = 0; k <= 30; k += 9)
+      {
+        for (uint8_t l = 0; l <= 30; l += 4)
+        {
+          const uint8_t inputs[] = {i, j, k, l};
+          uint8_t expected = (2 * i + 3 * j + 5 * k + 7 * l + 5) / 10;
+          uint8_t actual = interpolateMultilinearTable<4, uint8_t, uint64_t, uint16_t>(inputs, linearLengths,
+            linearScales, linearCells);
+          TEST_ASSERT_UINT8_WITHIN(1, expected, actual);
+        }
+      }
+    }
+  }
+
+  // Float
+  const uint8_t inputs[] = {15, 15, 15, 15};
+  TEST_ASSERT_EQUAL_UINT8(26, (interpolateMultilinearTable<4, uint8_t>(inputs, linearLengths, linearScales, linearCells)));
+}
+
+void test_interpolateMultilinear_Timing()
+{
+  const size_t lengths[] = {5, 3};
+  const uint8_t *scales[] = {xScale, yScale};
+  const uint8_t inputs2D[] = {125, 150};
+  const uint8_t inputs3D[] = {15, 15, 15};
+  const uint8_t inputs4D[] = {15, 15, 15, 15};
+  uint8_t bilinearOutput, output2D, output3D, output4D;
+
+  TIME_START
+  bilinearOutput = interpolateBilinearTable<uint8_t>(inputs2D[0], inputs2D[1], 5, 3, xScale, yScale, cells2D);
+  TIME_END
+  uint16_t bilinearTicks = TIME_DIFF;
+
+  TIME_START
+  output2D = interpolateMultilinearTable<2, uint8_t, uint32_t, uint16_t>(inputs2D, lengths, scales, cells2D);
+  TIME_END
+  uint16_t ticks2D = TIME_DIFF;
+
+  TIME_START
+  output3D = interpolateMultilinearTable<3, uint8_t, uint32_t, uint16_t>(inputs3D, linearLengths, linearScales, linearCells);
+  TIME_END
+  uint16_t ticks3D = TIME_DIFF;
+
+  TIME_START
+  output4D = interpolateMultilinearTable<4, uint8_t, uint64_t, uint16_t>(inputs4D, linearLengths, linearScales, linearCells);
+  TIME_END
+  uint16_t ticks4D = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT8(bilinearOutput, output2D);
+  TEST_ASSERT_EQUAL_UINT8(15, output3D);
+  TEST_ASSERT_EQUAL_UINT8(26, output4D);
+
+  snprintf(message, MAX_MESSAGE_LEN, "interpolateBilinearTable %u ticks, multilinear N=2 %u ticks, N=3 %u ticks, N=4 %u ticks",
+    bilinearTicks, ticks2D, ticks3D, ticks4D);
+  TEST_MESSAGE(message);
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  fillLinearCells();
+
+  RUN_TEST(test_interpolateMultilinear_MatchesBilinear);
+  RUN_TEST(test_interpolateMultilinear_Edges);
+  RUN_TEST(test_interpolateMultilinear_3D);
+  RUN_TEST(test_interpolateMultilinear_4D);
+  RUN_TEST(test_interpolateMultilinear_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
@@ -0,0 +1,294 @@
+// Inverse Interpolation Tests
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// Throttle angle (tenths of a degree) -> load (kPa)
+const uint16_t throttleScale[] = {0, 20, 50, 100, 200, 400, 600, 900};
+const uint8_t loadByThrottle[] = {20, 32, 48, 70, 98, 120, 130, 135};
+
+// Spark advance falls as load rises
+const uint8_t loadScale[] = {20, 40, 60, 80, 100};
+const uint8_t advanceByLoad[] = {40, 34, 27, 20, 14};
+
+// Torque (Nm) by RPM (x) and load (y), rising with load in every column
+const uint16_t rpmScale[] = {1000, 2000, 4000, 6000};
+const uint8_t torqueLoadScale[] = {20, 60, 100};
+const uint8_t torqueTable[] = {
+   20,  30,  35,  30,
+   80, 100, 110, 100,
+  140, 170, 190, 180};
+
+void test_findOnScaleBinary_MatchesLinear()
+{
+  const uint8_t scale[] = {10, 20, 20, 35, 60, 61, 200};
+
+  for (uint8_t length = 2; length <= sizeof(scale); length++)
+  {
+    for (uint16_t input = 0; input < 256; input++)
+    {
+      size_t linearIndex = 0, binaryIndex = 0;
+      uint8_t linearLow = 0, linearHigh = 0, binaryLow = 0, binaryHigh = 0;
+
+      FindOnScaleResult linear = findOnScale(static_cast<uint8_t>(input), scale, length, linearIndex, linearLow, linearHigh);
+      FindOnScaleResult binary = findOnScaleBinary(static_cast<uint8_t>(input), scale, length, binaryIndex, binaryLow, binaryHigh);
+
+      snprintf(message, MAX_MESSAGE_LEN, "Length %u input %u", length, input);
+      TEST_ASSERT_EQUAL_MESSAGE(static_cast<uint8_t>(linear), static_cast<uint8_t>(binary), message);
+      TEST_ASSERT_EQUAL_MESSAGE(linearIndex, binaryIndex, message);
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(linearLow, binaryLow, message);
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(linearHigh, binaryHigh, message);
+    }
+  }
+}
+
+void test_inverseInterpolateLinearTable_RoundTrip()
+{
+  for (uint16_t throttle = 0; throttle <= 900; throttle += 5)
+  {
+    uint8_t load = interpolateLinearTable<uint8_t>(throttle, 8, throttleScale, loadByThrottle);
+    uint16_t inverse = inverseInterpolateLinearTable<uint16_t>(load, 8, throttleScale, loadByThrottle);
+
+    // Loads round to whole kPa, so the throttle that gives them is exact to a step of the inverse slope
+    uint8_t loadBack = interpolateLinearTable<uint8_t>(inverse, 8, throttleScale, loadByThrottle);
+
+    snprintf(message, MAX_MESSAGE_LEN, "Throttle %u load %u inverse %u", throttle, load, inverse);
+    TEST_ASSERT_UINT8_WITHIN_MESSAGE(1, load, loadBack, message);
+  }
+
+  // Scale values come back exactly
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(throttleScale[i], inverseInterpolateLinearTable<uint16_t>(loadByThrottle[i], 8, throttleScale, loadByThrottle));
+  }
+}
+
+void test_inverseInterpolateLinearTable_OffScale()
+{
+  FindOnScaleResult result;
+
+  TEST_ASSERT_EQUAL_UINT16(0, inverseInterpolateLinearTable<uint16_t>(static_cast<uint8_t>(10), 8, throttleScale, loadByThrottle, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleLow, result);
+
+  TEST_ASSERT_EQUAL_UINT16(900, inverseInterpolateLinearTable<uint16_t>(static_cast<uint8_t>(200), 8, throttleScale, loadByThrottle, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleHigh, result);
+
+  TEST_ASSERT_EQUAL_UINT16(100, inverseInterpolateLinearTable<uint16_t>(static_cast<uint8_t>(70), 8, throttleScale, loadByThrottle, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::Exact, result);
+
+  TEST_ASSERT_EQUAL_UINT16(150, inverseInterpolateLinearTable<uint16_t>(static_cast<uint8_t>(84), 8, throttleScale, loadByThrottle, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::InBetween, result);
+}
+
+void test_inverseInterpolateLinearTable_Descending()
+{
+  FindOnScaleResult result;
+
+  // Results are about the target on the outputs, so high advance is off the high end at low load
+  TEST_ASSERT_EQUAL_UINT8(20, inverseInterpolateLinearTable<uint8_t>(static_cast<uint8_t>(45), 5, loadScale, advanceByLoad, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleHigh, result);
+
+  TEST_ASSERT_EQUAL_UINT8(100, inverseInterpolateLinearTable<uint8_t>(static_cast<uint8_t>(10), 5, loadScale, advanceByLoad, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleLow, result);
+
+  TEST_ASSERT_EQUAL_UINT8(60, inverseInterpolateLinearTable<uint8_t>(static_cast<uint8_t>(27), 5, loadScale, advanceByLoad, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::Exact, result);
+
+  TEST_ASSERT_EQUAL_UINT8(30, inverseInterpolateLinearTable<uint8_t>(static_cast<uint8_t>(37), 5, loadScale, advanceByLoad, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::InBetween, result);
+
+  for (uint8_t load = 20; load <= 100; load++)
+  {
+    uint8_t advance = interpolateLinearTable<uint8_t>(load, 5, loadScale, advanceByLoad);
+    uint8_t inverse = inverseInterpolateLinearTable<uint8_t>(advance, 5, loadScale, advanceByLoad);
+
+    snprintf(message, MAX_MESSAGE_LEN, "Load %u advance %u inverse %u", load, advance, inverse);
+    TEST_ASSERT_UINT8_WITHIN_MESSAGE(1, advance, interpolateLinearTable<uint8_t>(inverse, 5, loadScale, advanceByLoad), message);
+  }
+}
+
+void test_inverseInterpolateLinearTable_WideTarget()
+{
+  // 16-bit load back to an 8-bit throttle, where segments are much less than 1 throttle per load
+  const uint8_t throttle[] = {0, 50, 60, 100};
+  const uint16_t load[] = {0, 10000, 20000, 30000};
+  FindOnScaleResult result;
+
+  TEST_ASSERT_EQUAL_UINT8(52, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(12000), 4, throttle, load, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::InBetween, result);
+  TEST_ASSERT_EQUAL_UINT8(55, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(15000), 4, throttle, load));
+  TEST_ASSERT_EQUAL_UINT8(59, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(19000), 4, throttle, load));
+  TEST_ASSERT_EQUAL_UINT8(80, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(25000), 4, throttle, load));
+
+  // And descending, rounding the same way
+  const uint16_t loadDescending[] = {30000, 20000, 10000, 0};
+  TEST_ASSERT_EQUAL_UINT8(58, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(12000), 4, throttle, loadDescending));
+  TEST_ASSERT_EQUAL_UINT8(55, inverseInterpolateLinearTable<uint8_t>(static_cast<uint16_t>(15000), 4, throttle, loadDescending));
+}
+
+void test_inverseInterpolateLinearTable_Float()
+{
+  const float inputs[] = {0.0f, 10.0f, 20.0f};
+  const float outputs[] = {0.0f, 0.5f, 1.0f};
+  FindOnScaleResult result;
+
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, inverseInterpolateLinearTable<float>(0.25f, 3, inputs, outputs, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::InBetween, result);
+  TEST_ASSERT_EQUAL_FLOAT(17.5f, inverseInterpolateLinearTable<float>(0.875f, 3, inputs, outputs));
+
+  // Integer inputs of float outputs round to nearest
+  const uint8_t throttle[] = {0, 10, 20};
+  TEST_ASSERT_EQUAL_UINT8(6, inverseInterpolateLinearTable<uint8_t>(0.3f, 3, throttle, outputs));
+
+  // 32-bit by 32-bit products would overflow 64 bits, so they're solved in floating point too
+  const uint32_t wideInputs[] = {0, 4000000000ul};
+  const uint32_t wideOutputs[] = {0, 4000000000ul};
+  TEST_ASSERT_UINT32_WITHIN(256, 3000000000ul, inverseInterpolateLinearTable<uint32_t>(3000000000ul, 2, wideInputs, wideOutputs));
+}
+
+void test_inverseInterpolateBilinearTable()
+{
+  for (uint16_t rpm = 800; rpm <= 6500; rpm += 150)
+  {
+    for (uint8_t load = 20; load <= 100; load += 3)
+    {
+      uint8_t torque = interpolateBilinearTable<uint8_t>(rpm, load, 4, 3, rpmScale, torqueLoadScale, torqueTable);
+      uint8_t inverse = inverseInterpolateBilinearTableY<uint8_t>(rpm, torque, 4, 3, rpmScale, torqueLoadScale, torqueTable);
+      uint8_t torqueBack = interpolateBilinearTable<uint8_t>(rpm, inverse, 4, 3, rpmScale, torqueLoadScale, torqueTable);
+
+      snprintf(message, MAX_MESSAGE_LEN, "RPM %u load %u torque %u inverse %u", rpm, load, torque, inverse);
+      TEST_ASSERT_UINT8_WITHIN_MESSAGE(2, torque, torqueBack, message);
+    }
+  }
+
+  FindOnScaleResult result;
+
+  TEST_ASSERT_EQUAL_UINT8(20, inverseInterpolateBilinearTableY<uint8_t>(static_cast<uint16_t>(4000), static_cast<uint8_t>(10), 4, 3, rpmScale, torqueLoadScale, torqueTable, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleLow, result);
+
+  TEST_ASSERT_EQUAL_UINT8(100, inverseInterpolateBilinearTableY<uint8_t>(static_cast<uint16_t>(3000), static_cast<uint8_t>(250), 4, 3, rpmScale, torqueLoadScale, torqueTable, result));
+  TEST_ASSERT_EQUAL(FindOnScaleResult::OffScaleHigh, result);
+
+  // Torque falls from 4000 to 6000 RPM at every load, so fix the load and solve for RPM there
+  const uint16_t highRpmScale[] = {4000, 6000};
+  const uint8_t highRpmTable[] = {
+    35, 30,
+   110, 100,
+   190, 180};
+
+  uint16_t rpm = inverseInterpolateBilinearTableX<uint16_t>(static_cast<uint8_t>(60), static_cast<uint8_t>(105), 2, 3, highRpmScale, torqueLoadScale, highRpmTable, result);
+  TEST_ASSERT_EQUAL(FindOnScaleResult::InBetween, result);
+  TEST_ASSERT_EQUAL_UINT16(5000, rpm);
+}
+
+// Scan used before the inverse lookup: step the input until the output passes the target
+uint16_t scanInverse(uint8_t target)
+{
+  uint16_t throttle = 0;
+
+  while (throttle < 900 && interpolateLinearTable<uint8_t>(throttle, 8, throttleScale, loadByThrottle) < target)
+  {
+    throttle++;
+  }
+
+  return throttle;
+}
+
+void test_inverseInterpolateLinearTable_Timing()
+{
+  uint16_t inverse, scanned;
+
+  TIME_START
+  inverse = inverseInterpolateLinearTable<uint16_t>(static_cast<uint8_t>(125), 8, throttleScale, loadByThrottle);
+  TIME_END
+  uint16_t inverseTicks = TIME_DIFF;
+
+  // Only a few steps of the scan, or it would overflow the 16-bit timer
+  TIME_START
+  scanned = scanInverse(23);
+  TIME_END
+  uint16_t scanTicks = TIME_DIFF;
+
+  TEST_ASSERT_UINT16_WITHIN(1, 500, inverse);
+  TEST_ASSERT_UINT16_WITHIN(1, 5, scanned);
+
+  snprintf(message, MAX_MESSAGE_LEN, "inverseInterpolateLinearTable %u ticks, 5 step scan %u ticks",
+    inverseTicks, scanTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(scanTicks, inverseTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_findOnScaleBinary_MatchesLinear);
+  RUN_TEST(test_inverseInterpolateLinearTable_RoundTrip);
+  RUN_TEST(test_inverseInterpolateLinearTable_OffScale);
+  RUN_TEST(test_inverseInterpolateLinearTable_Descending);
+  RUN_TEST(test_inverseInterpolateLinearTable_WideTarget);
+  RUN_TEST(test_inverseInterpolateLinearTable_Float);
+  RUN_TEST(test_inverseInterpolateBilinearTable);
+  RUN_TEST(test_inverseInterpolateLinearTable_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
@@ -0,0 +1,278 @@
+// Kernel Traits Test
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#elif defined(__ARM_ARCH_7EM__)
+
+uint32_t start, end;
+
+// DWT cycle counter, enabled in setup()
+#define TIME_START {noInterrupts(); start = DWT->CYCCNT;}
+#define TIME_END {end = DWT->CYCCNT; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+// Prints "kernel ..." lines for tools/selectKernels to turn into kernelSelection.h:
+//   kernel target <macro>
+//   kernel linear <input> <output> fixed <ticks> float <ticks>
+//   kernel bilinear <x> <y> <z> fixed <ticks> float <ticks>
+
+template<typename T> const char *typeName();
+template<> const char *typeName<uint8_t>() { return "u8"; }
+template<> const char *typeName<uint16_t>() { return "u16"; }
+template<> const char *typeName<uint32_t>() { return "u32"; }
+template<> const char *typeName<int8_t>() { return "i8"; }
+template<> const char *typeName<int16_t>() { return "i16"; }
+
+constexpr uint8_t samples = 4;
+
+// A segment from about min/2 spanning 3/4 of the positive range, with samples inside it
+template<typename T>
+T sampleLow()
+{
+  return static_cast<T>(IntegerLimits<T>::min / 2);
+}
+
+template<typename T>
+T sampleHigh()
+{
+  return static_cast<T>(sampleLow<T>() + IntegerLimits<T>::max / 4 * 3);
+}
+
+template<typename T>
+T sample(uint8_t index)
+{
+  constexpr uint8_t halves[samples] = {1, 2, 3, 5};
+  return static_cast<T>(sampleLow<T>() + IntegerLimits<T>::max / 8 * halves[index]);
+}
+
+// Outputs from about an eighth to seven eighths of the range, descending for odd samples
+template<typename T>
+T sampleOutput(uint8_t index, bool high)
+{
+  T low = static_cast<T>(IntegerLimits<T>::min / 2 + IntegerLimits<T>::max / 8);
+  T top = static_cast<T>(IntegerLimits<T>::max - IntegerLimits<T>::max / 8);
+  return (high != (index & 1)) ? top : low;
+}
+
+template<typename T>
+void assertBetween(T a, T b, T actual)
+{
+  TEST_ASSERT_TRUE(actual >= (a < b ? a : b));
+  TEST_ASSERT_TRUE(actual <= (a < b ? b : a));
+}
+
+void test_kernelTraits_Target()
+{
+  snprintf(message, MAX_MESSAGE_LEN, "kernel target %s", KERNEL_TRAITS_TARGET);
+  TEST_MESSAGE(message);
+}
+
+template<typename InputType, typename OutputType>
+void test_kernelTraits_Linear()
+{
+  volatile InputType input, inputLow, inputHigh;
+  volatile OutputType output0, output1;
+  volatile OutputType fixedResult, floatResult;
+  uint32_t fixedTicks = 0;
+  uint32_t floatTicks = 0;
+
+  inputLow = sampleLow<InputType>();
+  inputHigh = sampleHigh<InputType>();
+
+  for (uint8_t i = 0; i < samples; i++)
+  {
+    input = sample<InputType>(i);
+    output0 = sampleOutput<OutputType>(i, false);
+    output1 = sampleOutput<OutputType>(i, true);
+
+    TIME_START
+    fixedResult = interpolateLinearKernel<InterpolationKernel::FixedPoint, InputType, OutputType>(
+      input, inputLow, inputHigh, output0, output1);
+    TIME_END
+    fixedTicks += TIME_DIFF;
+
+    TIME_START
+    floatResult = interpolateLinearKernel<InterpolationKernel::Float, InputType, OutputType>(
+      input, inputLow, inputHigh, output0, output1);
+    TIME_END
+    floatTicks += TIME_DIFF;
+
+    assertBetween<OutputType>(output0, output1, fixedResult);
+    assertBetween<OutputType>(output0, output1, floatResult);
+  }
+
+  snprintf(message, MAX_MESSAGE_LEN, "kernel linear %s %s fixed %lu float %lu",
+    typeName<InputType>(), typeName<OutputType>(),
+    static_cast<unsigned long>(fixedTicks), static_cast<unsigned long>(floatTicks));
+  TEST_MESSAGE(message);
+}
+
+template<typename X, typename Y, typename Z>
+void test_kernelTraits_Bilinear()
+{
+  volatile X x, x0, x1;
+  volatile Y y, y0, y1;
+  volatile Z z00, z10, z01, z11;
+  volatile Z fixedResult, floatResult;
+  uint32_t fixedTicks = 0;
+  uint32_t floatTicks = 0;
+
+  x0 = sampleLow<X>();
+  x1 = sampleHigh<X>();
+  y0 = sampleLow<Y>();
+  y1 = sampleHigh<Y>();
+
+  for (uint8_t i = 0; i < samples; i++)
+  {
+    x = sample<X>(i);
+    y = sample<Y>(samples - 1 - i);
+    z00 = z11 = sampleOutput<Z>(i, false);
+    z10 = z01 = sampleOutput<Z>(i, true);
+
+    TIME_START
+    fixedResult = interpolateBilinearKernel<InterpolationKernel::FixedPoint, X, Y, Z>(
+      x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+    TIME_END
+    fixedTicks += TIME_DIFF;
+
+    TIME_START
+    floatResult = interpolateBilinearKernel<InterpolationKernel::Float, X, Y, Z>(
+      x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+    TIME_END
+    floatTicks += TIME_DIFF;
+
+    // Both are exact to rounding
+    TEST_ASSERT_INT32_WITHIN(1, static_cast<int32_t>(floatResult), static_cast<int32_t>(fixedResult));
+    assertBetween<Z>(z00, z10, fixedResult);
+  }
+
+  snprintf(message, MAX_MESSAGE_LEN, "kernel bilinear %s %s %s fixed %lu float %lu",
+    typeName<X>(), typeName<Y>(), typeName<Z>(),
+    static_cast<unsigned long>(fixedTicks), static_cast<unsigned long>(floatTicks));
+  TEST_MESSAGE(message);
+}
+
+void test_kernelTraits_Dispatch()
+{
+  // interpolateLinear() and interpolateBilinear() give what the selected kernel gives
+  TEST_ASSERT_EQUAL_UINT16((interpolateLinearKernel<LinearKernelTraits<uint16_t, uint16_t>::kernel, uint16_t, uint16_t>(
+      1000, 0, 4000, 100, 900)),
+    (interpolateLinear<uint16_t, uint16_t>(1000, 0, 4000, 100, 900)));
+  TEST_ASSERT_EQUAL_UINT32((interpolateLinearKernel<LinearKernelTraits<uint8_t, uint32_t>::kernel, uint8_t, uint32_t>(
+      10, 0, 40, 100000, 900000)),
+    (interpolateLinear<uint8_t, uint32_t>(10, 0, 40, 100000, 900000)));
+  TEST_ASSERT_EQUAL_INT16((interpolateBilinearKernel<BilinearKernelTraits<uint8_t, uint8_t, int16_t>::kernel, uint8_t, uint8_t, int16_t>(
+      10, 0, 40, 30, 20, 60, -1000, 1000, 2000, -2000)),
+    (interpolateBilinear<uint8_t, uint8_t, int16_t>(10, 0, 40, 30, 20, 60, -1000, 1000, 2000, -2000)));
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#elif defined(__ARM_ARCH_7EM__)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+  RUN_TEST(test_kernelTraits_Target);
+
+  RUN_TEST((test_kernelTraits_Linear<uint8_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint8_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint8_t, uint32_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint16_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint16_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint16_t, uint32_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint32_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint32_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint32_t, uint32_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint8_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint8_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint16_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Linear<uint16_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Linear<int8_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Linear<int8_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Linear<int16_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Linear<int16_t, int16_t>));
+
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint8_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint8_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint16_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint16_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint8_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint8_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint16_t, uint8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint16_t, uint16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint8_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint8_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint16_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint8_t, uint16_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint8_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint8_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint16_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<uint16_t, uint16_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<int8_t, int8_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<int8_t, int8_t, int16_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<int16_t, int16_t, int8_t>));
+  RUN_TEST((test_kernelTraits_Bilinear<int16_t, int16_t, int16_t>));
+
+  RUN_TEST(test_kernelTraits_Dispatch);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
@@ -0,0 +1,270 @@
+// Test packed 12-bit arrays
+// Copyright (C) 2021  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+const uint16_t rpmScale[] = {
+  700, 950, 1200, 1500, 2000, 2600, 3100, 3700, 4300, 4900, 5000, 6000, 6500, 7000, 7200, 7500};
+
+const uint8_t loadScale[] = {
+  10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 120, 140, 160, 180, 200, 250};
+
+const size_t rpmLength = sizeof(rpmScale) / sizeof(rpmScale[0]);
+const size_t loadLength = sizeof(loadScale) / sizeof(loadScale[0]);
+
+const uint16_t veTable[] = {
+   800,  910, 1020, 1130, 1240, 1350, 1460, 1570, 1680, 1790, 1900, 2010, 2120, 2230, 2340, 2450,
+   890, 1008, 1126, 1244, 1362, 1479, 1595, 1710, 1824, 1937, 2049, 2159, 2269, 2377, 2484, 2590,
+   980, 1106, 1232, 1355, 1474, 1589, 1699, 1804, 1905, 2002, 2096, 2189, 2283, 2377, 2474, 2575,
+  1070, 1204, 1335, 1457, 1569, 1670, 1762, 1848, 1933, 2020, 2115, 2220, 2335, 2460, 2593, 2728,
+  1160, 1302, 1434, 1549, 1645, 1726, 1803, 1884, 1980, 2095, 2227, 2370, 2512, 2644, 2759, 2855,
+  1250, 1399, 1529, 1630, 1706, 1774, 1855, 1962, 2097, 2248, 2395, 2519, 2615, 2688, 2757, 2842,
+  1340, 1495, 1619, 1702, 1763, 1835, 1945, 2093, 2252, 2389, 2485, 2549, 2614, 2710, 2847, 3007,
+  1430, 1590, 1704, 1768, 1824, 1922, 2073, 2239, 2369, 2444, 2497, 2580, 2717, 2885, 3029, 3119,
+  1520, 1684, 1785, 1833, 1900, 2037, 2212, 2349, 2416, 2464, 2565, 2730, 2894, 2995, 3042, 3110,
+  1610, 1777, 1862, 1900, 1995, 2168, 2329, 2404, 2444, 2549, 2727, 2879, 2946, 2989, 3104, 3285,
+  1700, 1869, 1936, 1975, 2107, 2295, 2405, 2437, 2525, 2707, 2859, 2909, 2960, 3113, 3294, 3382,
+  1790, 1959, 2009, 2060, 2230, 2399, 2449, 2500, 2670, 2839, 2889, 2940, 3110, 3279, 3329, 3380,
+  1880, 2049, 2083, 2155, 2352, 2475, 2494, 2617, 2814, 2886, 2920, 3090, 3259, 3292, 3365, 3562,
+  1970, 2137, 2157, 2260, 2464, 2528, 2570, 2765, 2895, 2909, 3053, 3239, 3272, 3349, 3555, 3644,
+  2060, 2224, 2234, 2373, 2559, 2577, 2687, 2889, 2922, 3004, 3214, 3269, 3325, 3535, 3616, 3650,
+  2150, 2310, 2315, 2488, 2635, 2642, 2827, 2959, 2970, 3165, 3282, 3300, 3502, 3604, 3630, 3839};
+
+const uint8_t veTablePacked[] = {
+  PACK12( 800,  910), PACK12(1020, 1130), PACK12(1240, 1350), PACK12(1460, 1570),
+  PACK12(1680, 1790), PACK12(1900, 2010), PACK12(2120, 2230), PACK12(2340, 2450),
+  PACK12( 890, 1008), PACK12(1126, 1244), PACK12(1362, 1479), PACK12(1595, 1710),
+  PACK12(1824, 1937), PACK12(2049, 2159), PACK12(2269, 2377), PACK12(2484, 2590),
+  PACK12( 980, 1106), PACK12(1232, 1355), PACK12(1474, 1589), PACK12(1699, 1804),
+  PACK12(1905, 2002), PACK12(2096, 2189), PACK12(2283, 2377), PACK12(2474, 2575),
+  PACK12(1070, 1204), PACK12(1335, 1457), PACK12(1569, 1670), PACK12(1762, 1848),
+  PACK12(1933, 2020), PACK12(2115, 2220), PACK12(2335, 2460), PACK12(2593, 2728),
+  PACK12(1160, 1302), PACK12(1434, 1549), PACK12(1645, 1726), PACK12(1803, 1884),
+  PACK12(1980, 2095), PACK12(2227, 2370), PACK12(2512, 2644), PACK12(2759, 2855),
+  PACK12(1250, 1399), PACK12(1529, 1630), PACK12(1706, 1774), PACK12(1855, 1962),
+  PACK12(2097, 2248), PACK12(2395, 2519), PACK12(2615, 2688), PACK12(2757, 2842),
+  PACK12(1340, 1495), PACK12(1619, 1702), PACK12(1763, 1835), PACK12(1945, 2093),
+  PACK12(2252, 2389), PACK12(2485, 2549), PACK12(2614, 2710), PACK12(2847, 3007),
+  PACK12(1430, 1590), PACK12(1704, 1768), PACK12(1824, 1922), PACK12(2073, 2239),
+  PACK12(2369, 2444), PACK12(2497, 2580), PACK12(2717, 2885), PACK12(3029, 3119),
+  PACK12(1520, 1684), PACK12(1785, 1833), PACK12(1900, 2037), PACK12(2212, 2349),
+  PACK12(2416, 2464), PACK12(2565, 2730), PACK12(2894, 2995), PACK12(3042, 3110),
+  PACK12(1610, 1777), PACK12(1862, 1900), PACK12(1995, 2168), PACK12(2329, 2404),
+  PACK12(2444, 2549), PACK12(2727, 2879), PACK12(2946, 2989), PACK12(3104, 3285),
+  PACK12(1700, 1869), PACK12(1936, 1975), PACK12(2107, 2295), PACK12(2405, 2437),
+  PACK12(2525, 2707), PACK12(2859, 2909), PACK12(2960, 3113), PACK12(3294, 3382),
+  PACK12(1790, 1959), PACK12(2009, 2060), PACK12(2230, 2399), PACK12(2449, 2500),
+  PACK12(2670, 2839), PACK12(2889, 2940), PACK12(3110, 3279), PACK12(3329, 3380),
+  PACK12(1880, 2049), PACK12(2083, 2155), PACK12(2352, 2475), PACK12(2494, 2617),
+  PACK12(2814, 2886), PACK12(2920, 3090), PACK12(3259, 3292), PACK12(3365, 3562),
+  PACK12(1970, 2137), PACK12(2157, 2260), PACK12(2464, 2528), PACK12(2570, 2765),
+  PACK12(2895, 2909), PACK12(3053, 3239), PACK12(3272, 3349), PACK12(3555, 3644),
+  PACK12(2060, 2224), PACK12(2234, 2373), PACK12(2559, 2577), PACK12(2687, 2889),
+  PACK12(2922, 3004), PACK12(3214, 3269), PACK12(3325, 3535), PACK12(3616, 3650),
+  PACK12(2150, 2310), PACK12(2315, 2488), PACK12(2635, 2642), PACK12(2827, 2959),
+  PACK12(2970, 3165), PACK12(3282, 3300), PACK12(3502, 3604), PACK12(3630, 3839)};
+
+const uint8_t veTablePackedProgmem[] PROGMEM = {
+  PACK12( 800,  910), PACK12(1020, 1130), PACK12(1240, 1350), PACK12(1460, 1570),
+  PACK12(1680, 1790), PACK12(1900, 2010), PACK12(2120, 2230), PACK12(2340, 2450),
+  PACK12( 890, 1008), PACK12(1126, 1244), PACK12(1362, 1479), PACK12(1595, 1710),
+  PACK12(1824, 1937), PACK12(2049, 2159), PACK12(2269, 2377), PACK12(2484, 2590),
+  PACK12( 980, 1106), PACK12(1232, 1355), PACK12(1474, 1589), PACK12(1699, 1804),
+  PACK12(1905, 2002), PACK12(2096, 2189), PACK12(2283, 2377), PACK12(2474, 2575),
+  PACK12(1070, 1204), PACK12(1335, 1457), PACK12(1569, 1670), PACK12(1762, 1848),
+  PACK12(1933, 2020), PACK12(2115, 2220), PACK12(2335, 2460), PACK12(2593, 2728),
+  PACK12(1160, 1302), PACK12(1434, 1549), PACK12(1645, 1726), PACK12(1803, 1884),
+  PACK12(1980, 2095), PACK12(2227, 2370), PACK12(2512, 2644), PACK12(2759, 2855),
+  PACK12(1250, 1399), PACK12(1529, 1630), PACK12(1706, 1774), PACK12(1855, 1962),
+  PACK12(2097, 2248), PACK12(2395, 2519), PACK12(2615, 2688), PACK12(2757, 2842),
+  PACK12(1340, 1495), PACK12(1619, 1702), PACK12(1763, 1835), PACK12(1945, 2093),
+  PACK12(2252, 2389), PACK12(2485, 2549), PACK12(2614, 2710), PACK12(2847, 3007),
+  PACK12(1430, 1590), PACK12(1704, 1768), PACK12(1824, 1922), PACK12(2073, 2239),
+  PACK12(2369, 2444), PACK12(2497, 2580), PACK12(2717, 2885), PACK12(3029, 3119),
+  PACK12(1520, 1684), PACK12(1785, 1833), PACK12(1900, 2037), PACK12(2212, 2349),
+  PACK12(2416, 2464), PACK12(2565, 2730), PACK12(2894, 2995), PACK12(3042, 3110),
+  PACK12(1610, 1777), PACK12(1862, 1900), PACK12(1995, 2168), PACK12(2329, 2404),
+  PACK12(2444, 2549), PACK12(2727, 2879), PACK12(2946, 2989), PACK12(3104, 3285),
+  PACK12(1700, 1869), PACK12(1936, 1975), PACK12(2107, 2295), PACK12(2405, 2437),
+  PACK12(2525, 2707), PACK12(2859, 2909), PACK12(2960, 3113), PACK12(3294, 3382),
+  PACK12(1790, 1959), PACK12(2009, 2060), PACK12(2230, 2399), PACK12(2449, 2500),
+  PACK12(2670, 2839), PACK12(2889, 2940), PACK12(3110, 3279), PACK12(3329, 3380),
+  PACK12(1880, 2049), PACK12(2083, 2155), PACK12(2352, 2475), PACK12(2494, 2617),
+  PACK12(2814, 2886), PACK12(2920, 3090), PACK12(3259, 3292), PACK12(3365, 3562),
+  PACK12(1970, 2137), PACK12(2157, 2260), PACK12(2464, 2528), PACK12(2570, 2765),
+  PACK12(2895, 2909), PACK12(3053, 3239), PACK12(3272, 3349), PACK12(3555, 3644),
+  PACK12(2060, 2224), PACK12(2234, 2373), PACK12(2559, 2577), PACK12(2687, 2889),
+  PACK12(2922, 3004), PACK12(3214, 3269), PACK12(3325, 3535), PACK12(3616, 3650),
+  PACK12(2150, 2310), PACK12(2315, 2488), PACK12(2635, 2642), PACK12(2827, 2959),
+  PACK12(2970, 3165), PACK12(3282, 3300), PACK12(3502, 3604), PACK12(3630, 3839)};
+
+void test_packedArray12_Size()
+{
+  TEST_ASSERT_EQUAL(packedArray12Size(rpmLength * loadLength), sizeof(veTablePacked));
+  TEST_ASSERT_EQUAL(sizeof(veTable) * 3 / 4, sizeof(veTablePacked));
+  TEST_ASSERT_EQUAL(5, packedArray12Size(3));
+}
+
+void test_packedArray12_Read()
+{
+  PackedArray12<> packed(veTablePacked);
+  PackedArray12<ProgmemArray<uint8_t>> packedProgmem = ProgmemArray<uint8_t>(veTablePackedProgmem);
+
+  for (size_t i = 0; i < rpmLength * loadLength; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(veTable[i], packed[i]);
+    TEST_ASSERT_EQUAL_UINT16(veTable[i], packedProgmem[i]);
+  }
+}
+
+void test_packedArray12_ReadPair()
+{
+  PackedArray12<> packed(veTablePacked);
+
+  for (size_t i = 0; i < rpmLength * loadLength - 1; i++)
+  {
+    uint16_t first, second;
+    packed.readPair(i, first, second);
+    TEST_ASSERT_EQUAL_UINT16(veTable[i], first);
+    TEST_ASSERT_EQUAL_UINT16(veTable[i + 1], second);
+  }
+}
+
+void test_packedArray12_Set()
+{
+  uint8_t bytes[packedArray12Size(5)] = {0};
+  PackedArray12<uint8_t *> packed(bytes);
+
+  packed.set(0, 0xABC);
+  packed.set(1, 0x123);
+  packed.set(2, 0xFFF);
+  packed.set(3, 0x000);
+  packed.set(4, 0x801);
+
+  TEST_ASSERT_EQUAL_UINT16(0xABC, packed[0]);
+  TEST_ASSERT_EQUAL_UINT16(0x123, packed[1]);
+  TEST_ASSERT_EQUAL_UINT16(0xFFF, packed[2]);
+  TEST_ASSERT_EQUAL_UINT16(0x000, packed[3]);
+  TEST_ASSERT_EQUAL_UINT16(0x801, packed[4]);
+
+  const uint8_t expected[] = {PACK12(0xABC, 0x123), PACK12(0xFFF, 0x000)};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, bytes, sizeof(expected));
+}
+
+template<typename ZArray>
+uint16_t timeInterpolateBilinearTable(uint16_t rpm, uint8_t load, ZArray table, uint16_t &output)
+{
+  TIME_START
+  output = interpolateBilinearTable<uint16_t>(rpm, load, rpmLength, loadLength, rpmScale, loadScale, table);
+  TIME_END
+
+  return TIME_DIFF;
+}
+
+void test_interpolateBilinearTable_Packed()
+{
+  const uint16_t rpms[] = {650, 800, 2000, 4400, 7000, 8000};
+  const uint8_t loads[] = {5, 15, 55, 80, 155, 255};
+
+  for (size_t i = 0; i < sizeof(rpms) / sizeof(rpms[0]); i++)
+  {
+    uint16_t output, packedOutput, packedProgmemOutput;
+
+    uint16_t ticks = timeInterpolateBilinearTable(rpms[i], loads[i], veTable, output);
+    uint16_t packedTicks = timeInterpolateBilinearTable(rpms[i], loads[i],
+      PackedArray12<>(veTablePacked), packedOutput);
+    uint16_t packedProgmemTicks = timeInterpolateBilinearTable(rpms[i], loads[i],
+      PackedArray12<ProgmemArray<uint8_t>>(ProgmemArray<uint8_t>(veTablePackedProgmem)), packedProgmemOutput);
+
+    TEST_ASSERT_EQUAL_UINT16(output, packedOutput);
+    TEST_ASSERT_EQUAL_UINT16(output, packedProgmemOutput);
+
+    snprintf(message, MAX_MESSAGE_LEN,
+      "interpolateBilinearTable(%u, %u): uint16_t %u ticks, packed %u ticks, packed PROGMEM %u ticks",
+      rpms[i], loads[i], ticks, packedTicks, packedProgmemTicks);
+    TEST_MESSAGE(message);
+  }
+}
+
+void test_interpolateLinearTable_Packed()
+{
+  PackedArray12<> packed(veTablePacked);
+
+  // First row of the table
+  for (uint16_t rpm = 600; rpm < 8000; rpm += 50)
+  {
+    uint16_t expected = interpolateLinearTable<uint16_t>(rpm, rpmLength, rpmScale, veTable);
+    uint16_t actual = interpolateLinearTable<uint16_t>(rpm, rpmLength, rpmScale, packed);
+    TEST_ASSERT_EQUAL_UINT16(expected, actual);
+  }
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_packedArray12_Size);
+  RUN_TEST(test_packedArray12_Read);
+  RUN_TEST(test_packedArray12_ReadPair);
+  RUN_TEST(test_packedArray12_Set);
+  RUN_TEST(test_interpolateBilinearTable_Packed);
+  RUN_TEST(test_interpolateLinearTable_Packed);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
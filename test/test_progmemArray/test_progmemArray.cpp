@@ -0,0 +1,242 @@
+// Test program memory arrays
+// Copyright (C) 2021  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+const uint16_t rpmScaleSram[] = {
+  700, 950, 1200, 1500, 2000, 2600, 3100, 3700, 4300, 4900, 5000, 6000, 6500, 7000, 7200, 7500};
+const uint16_t rpmScaleProgmem[] PROGMEM = {
+  700, 950, 1200, 1500, 2000, 2600, 3100, 3700, 4300, 4900, 5000, 6000, 6500, 7000, 7200, 7500};
+
+const uint8_t loadScaleSram[] = {
+  10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 120, 140, 160, 180, 200, 250};
+const uint8_t loadScaleProgmem[] PROGMEM = {
+  10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 120, 140, 160, 180, 200, 250};
+
+const size_t rpmLength = sizeof(rpmScaleSram) / sizeof(rpmScaleSram[0]);
+const size_t loadLength = sizeof(loadScaleSram) / sizeof(loadScaleSram[0]);
+
+const uint16_t veTableSram[] = {
+  20000, 20900, 21800, 22700, 23600, 24500, 25400, 26300, 27200, 28100, 29000, 29900, 30800, 31700, 32600, 33500,
+  21500, 22442, 23384, 24324, 25262, 26196, 27126, 28052, 28972, 29887, 30796, 31699, 32596, 33487, 34372, 35252,
+  23000, 23984, 24962, 25926, 26872, 27796, 28696, 29572, 30426, 31261, 32084, 32899, 33715, 34537, 35372, 36226,
+  24500, 25524, 26526, 27487, 28396, 29252, 30061, 30842, 31615, 32403, 33226, 34100, 35027, 36004, 37016, 38043,
+  26000, 27062, 28072, 28996, 29826, 30584, 31315, 32072, 32902, 33827, 34838, 35900, 36962, 37973, 38896, 39726,
+  27500, 28596, 29596, 30452, 31184, 31874, 32626, 33512, 34538, 35643, 36727, 37699, 38526, 39241, 39936, 40711,
+  29000, 30126, 31096, 31861, 32515, 33226, 34127, 35216, 36362, 37397, 38226, 38898, 39572, 40403, 41439, 42586,
+  30500, 31652, 32572, 33242, 33872, 34712, 35816, 36997, 37996, 38723, 39336, 40100, 41139, 42326, 43397, 44195,
+  32000, 33172, 34026, 34615, 35302, 36338, 37562, 38596, 39283, 39872, 40727, 41901, 43073, 43925, 44513, 45202,
+  33500, 34687, 35461, 36003, 36827, 38043, 39197, 39923, 40472, 41348, 42586, 43699, 44382, 44946, 45874, 47126,
+  35000, 36196, 36884, 37426, 38438, 39727, 40626, 41136, 41927, 43186, 44296, 44898, 45502, 46617, 47873, 48660,
+  36500, 37699, 38299, 38900, 40100, 41299, 41898, 42500, 43701, 44899, 45498, 46100, 47302, 48499, 49097, 49700,
+  38000, 39196, 39715, 40427, 41762, 42726, 43172, 44139, 45473, 46182, 46702, 47902, 49096, 49612, 50328, 51664,
+  39500, 40687, 41137, 42004, 43373, 44041, 44603, 45926, 46925, 47346, 48417, 49699, 50212, 50949, 52328, 53121,
+  41000, 42172, 42572, 43616, 44896, 45336, 46239, 47597, 48113, 48874, 50273, 50897, 51528, 52928, 53681, 54203,
+  42500, 43652, 44026, 45243, 46326, 46711, 47986, 48995, 49402, 50726, 51660, 52100, 53464, 54321, 54803, 56199
+};
+const uint16_t veTableProgmem[] PROGMEM = {
+  20000, 20900, 21800, 22700, 23600, 24500, 25400, 26300, 27200, 28100, 29000, 29900, 30800, 31700, 32600, 33500,
+  21500, 22442, 23384, 24324, 25262, 26196, 27126, 28052, 28972, 29887, 30796, 31699, 32596, 33487, 34372, 35252,
+  23000, 23984, 24962, 25926, 26872, 27796, 28696, 29572, 30426, 31261, 32084, 32899, 33715, 34537, 35372, 36226,
+  24500, 25524, 26526, 27487, 28396, 29252, 30061, 30842, 31615, 32403, 33226, 34100, 35027, 36004, 37016, 38043,
+  26000, 27062, 28072, 28996, 29826, 30584, 31315, 32072, 32902, 33827, 34838, 35900, 36962, 37973, 38896, 39726,
+  27500, 28596, 29596, 30452, 31184, 31874, 32626, 33512, 34538, 35643, 36727, 37699, 38526, 39241, 39936, 40711,
+  29000, 30126, 31096, 31861, 32515, 33226, 34127, 35216, 36362, 37397, 38226, 38898, 39572, 40403, 41439, 42586,
+  30500, 31652, 32572, 33242, 33872, 34712, 35816, 36997, 37996, 38723, 39336, 40100, 41139, 42326, 43397, 44195,
+  32000, 33172, 34026, 34615, 35302, 36338, 37562, 38596, 39283, 39872, 40727, 41901, 43073, 43925, 44513, 45202,
+  33500, 34687, 35461, 36003, 36827, 38043, 39197, 39923, 40472, 41348, 42586, 43699, 44382, 44946, 45874, 47126,
+  35000, 36196, 36884, 37426, 38438, 39727, 40626, 41136, 41927, 43186, 44296, 44898, 45502, 46617, 47873, 48660,
+  36500, 37699, 38299, 38900, 40100, 41299, 41898, 42500, 43701, 44899, 45498, 46100, 47302, 48499, 49097, 49700,
+  38000, 39196, 39715, 40427, 41762, 42726, 43172, 44139, 45473, 46182, 46702, 47902, 49096, 49612, 50328, 51664,
+  39500, 40687, 41137, 42004, 43373, 44041, 44603, 45926, 46925, 47346, 48417, 49699, 50212, 50949, 52328, 53121,
+  41000, 42172, 42572, 43616, 44896, 45336, 46239, 47597, 48113, 48874, 50273, 50897, 51528, 52928, 53681, 54203,
+  42500, 43652, 44026, 45243, 46326, 46711, 47986, 48995, 49402, 50726, 51660, 52100, 53464, 54321, 54803, 56199
+};
+
+const int16_t signedProgmem[] PROGMEM = {-32768, -1, 0, 1, 32767};
+const uint32_t unsignedLongProgmem[] PROGMEM = {0, 1, 4294967295ul, 123456789ul};
+const float floatProgmem[] PROGMEM = {-1.5, 0.0, 3.14159, 1e10};
+
+void test_progmemArray_Read()
+{
+  ProgmemArray<uint8_t> loadScale(loadScaleProgmem);
+  ProgmemArray<uint16_t> rpmScale(rpmScaleProgmem);
+  ProgmemArray<int16_t> signedArray(signedProgmem);
+  ProgmemArray<uint32_t> unsignedLongArray(unsignedLongProgmem);
+  ProgmemArray<float> floatArray(floatProgmem);
+
+  TEST_ASSERT_EQUAL_UINT8(10, loadScale[0]);
+  TEST_ASSERT_EQUAL_UINT8(250, loadScale[15]);
+  TEST_ASSERT_EQUAL_UINT16(700, rpmScale[0]);
+  TEST_ASSERT_EQUAL_UINT16(7500, rpmScale[15]);
+  TEST_ASSERT_EQUAL_INT16(-32768, signedArray[0]);
+  TEST_ASSERT_EQUAL_INT16(-1, signedArray[1]);
+  TEST_ASSERT_EQUAL_INT16(32767, signedArray[4]);
+  TEST_ASSERT_EQUAL_UINT32(4294967295ul, unsignedLongArray[2]);
+  TEST_ASSERT_EQUAL_UINT32(123456789ul, unsignedLongArray[3]);
+  TEST_ASSERT_EQUAL_FLOAT(-1.5, floatArray[0]);
+  TEST_ASSERT_EQUAL_FLOAT(3.14159, floatArray[2]);
+  TEST_ASSERT_EQUAL_FLOAT(1e10, floatArray[3]);
+}
+
+void test_farProgmemArray_Read()
+{
+  FarProgmemArray<uint8_t> loadScale = FAR_PROGMEM_ARRAY(uint8_t, loadScaleProgmem);
+  FarProgmemArray<uint16_t> rpmScale = FAR_PROGMEM_ARRAY(uint16_t, rpmScaleProgmem);
+  FarProgmemArray<int16_t> signedArray = FAR_PROGMEM_ARRAY(int16_t, signedProgmem);
+  FarProgmemArray<float> floatArray = FAR_PROGMEM_ARRAY(float, floatProgmem);
+
+  TEST_ASSERT_EQUAL_UINT8(10, loadScale[0]);
+  TEST_ASSERT_EQUAL_UINT8(250, loadScale[15]);
+  TEST_ASSERT_EQUAL_UINT16(700, rpmScale[0]);
+  TEST_ASSERT_EQUAL_UINT16(7500, rpmScale[15]);
+  TEST_ASSERT_EQUAL_INT16(-32768, signedArray[0]);
+  TEST_ASSERT_EQUAL_FLOAT(3.14159, floatArray[2]);
+}
+
+void test_inAscendingOrder_Progmem()
+{
+  TEST_ASSERT_TRUE(inAscendingOrder(ProgmemArray<uint16_t>(rpmScaleProgmem), rpmLength));
+  TEST_ASSERT_TRUE(inAscendingOrder(ProgmemArray<uint8_t>(loadScaleProgmem), loadLength));
+}
+
+template<typename ScaleArray>
+uint16_t timeFindOnScale(uint16_t rpm, ScaleArray scale, size_t &lowIndex)
+{
+  uint16_t low, high;
+
+  TIME_START
+  findOnScale(rpm, scale, rpmLength, lowIndex, low, high);
+  TIME_END
+
+  return TIME_DIFF;
+}
+
+void test_findOnScale_SramVsFlash()
+{
+  const uint16_t rpms[] = {650, 800, 2000, 4400, 7400, 8000};
+
+  for (size_t i = 0; i < sizeof(rpms) / sizeof(rpms[0]); i++)
+  {
+    size_t sramIndex, progmemIndex, farIndex;
+
+    uint16_t sramTicks = timeFindOnScale(rpms[i], rpmScaleSram, sramIndex);
+    uint16_t progmemTicks = timeFindOnScale(rpms[i], ProgmemArray<uint16_t>(rpmScaleProgmem), progmemIndex);
+    uint16_t farTicks = timeFindOnScale(rpms[i], FAR_PROGMEM_ARRAY(uint16_t, rpmScaleProgmem), farIndex);
+
+    TEST_ASSERT_EQUAL(sramIndex, progmemIndex);
+    TEST_ASSERT_EQUAL(sramIndex, farIndex);
+
+    snprintf(message, MAX_MESSAGE_LEN, "findOnScale(%u): SRAM %u ticks, PROGMEM %u ticks, far PROGMEM %u ticks",
+      rpms[i], sramTicks, progmemTicks, farTicks);
+    TEST_MESSAGE(message);
+  }
+}
+
+template<typename XArray, typename YArray, typename ZArray>
+uint16_t timeInterpolateBilinearTable(uint16_t rpm, uint8_t load, XArray rpmScale, YArray loadScale, ZArray veTable,
+  uint16_t &output)
+{
+  TIME_START
+  output = interpolateBilinearTable<uint16_t>(rpm, load, rpmLength, loadLength, rpmScale, loadScale, veTable);
+  TIME_END
+
+  return TIME_DIFF;
+}
+
+void test_interpolateBilinearTable_SramVsFlash()
+{
+  const uint16_t rpms[] = {650, 800, 2000, 4400, 7000, 8000};
+  const uint8_t loads[] = {5, 15, 55, 80, 155, 255};
+
+  for (size_t i = 0; i < sizeof(rpms) / sizeof(rpms[0]); i++)
+  {
+    uint16_t sramOutput, progmemOutput, farOutput;
+
+    uint16_t sramTicks = timeInterpolateBilinearTable(rpms[i], loads[i],
+      rpmScaleSram, loadScaleSram, veTableSram, sramOutput);
+    uint16_t progmemTicks = timeInterpolateBilinearTable(rpms[i], loads[i],
+      ProgmemArray<uint16_t>(rpmScaleProgmem), ProgmemArray<uint8_t>(loadScaleProgmem),
+      ProgmemArray<uint16_t>(veTableProgmem), progmemOutput);
+    uint16_t farTicks = timeInterpolateBilinearTable(rpms[i], loads[i],
+      FAR_PROGMEM_ARRAY(uint16_t, rpmScaleProgmem), FAR_PROGMEM_ARRAY(uint8_t, loadScaleProgmem),
+      FAR_PROGMEM_ARRAY(uint16_t, veTableProgmem), farOutput);
+
+    TEST_ASSERT_EQUAL_UINT16(sramOutput, progmemOutput);
+    TEST_ASSERT_EQUAL_UINT16(sramOutput, farOutput);
+
+    snprintf(message, MAX_MESSAGE_LEN,
+      "interpolateBilinearTable(%u, %u): SRAM %u ticks, PROGMEM %u ticks, far PROGMEM %u ticks",
+      rpms[i], loads[i], sramTicks, progmemTicks, farTicks);
+    TEST_MESSAGE(message);
+  }
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_progmemArray_Read);
+  RUN_TEST(test_farProgmemArray_Read);
+  RUN_TEST(test_inAscendingOrder_Progmem);
+  RUN_TEST(test_findOnScale_SramVsFlash);
+  RUN_TEST(test_interpolateBilinearTable_SramVsFlash);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
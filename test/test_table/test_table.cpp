@@ -0,0 +1,200 @@
+// Test tables
+// Copyright (C) 2021  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+const uint8_t rowMajorCells[] = {
+    0, 100, 200,  40, 90,  //   0
+   50, 150, 250,  60, 10,  // 100
+   20,  30,  40, 200, 70}; // 200
+
+typedef Table2D<uint8_t, uint8_t, uint8_t, 5, 3, RowMajorLayout> RowMajorTable;
+typedef Table2D<uint8_t, uint8_t, uint8_t, 5, 3, ColumnMajorLayout> ColumnMajorTable;
+typedef Table2D<uint8_t, uint8_t, uint8_t, 5, 3, Tiled2x2Layout> TiledTable;
+
+template<typename Table>
+void loadTable(Table &table)
+{
+  const uint8_t xScale[] = {0, 100, 150, 200, 250};
+  const uint8_t yScale[] = {0, 100, 200};
+
+  for (size_t i = 0; i < Table::xSize; i++)
+  {
+    table.xScale[i] = xScale[i];
+  }
+
+  for (size_t i = 0; i < Table::ySize; i++)
+  {
+    table.yScale[i] = yScale[i];
+  }
+
+  table.load(rowMajorCells);
+}
+
+void test_table2D_NonSquare()
+{
+  RowMajorTable table = {
+    {0, 100, 150, 200, 250},
+    {0, 100, 200},
+    {  0, 100, 200,  40, 90,
+      50, 150, 250,  60, 10,
+      20,  30,  40, 200, 70}};
+
+  TEST_ASSERT_EQUAL_UINT8(75, table.lookup(50, 50));
+  TEST_ASSERT_EQUAL_UINT8(50, table.lookup(50, 0));
+  TEST_ASSERT_EQUAL_UINT8(25, table.lookup(0, 50));
+  TEST_ASSERT_EQUAL_UINT8(250, table.lookup(150, 100));
+  TEST_ASSERT_EQUAL_UINT8(70, table.lookup(255, 255));
+  TEST_ASSERT_EQUAL_UINT8(130, table.lookup(200, 150));
+  TEST_ASSERT_EQUAL_UINT8(40, table.at(3, 0));
+  TEST_ASSERT_EQUAL_UINT8(200, table.at(3, 2));
+}
+
+void test_table2D_Layouts()
+{
+  RowMajorTable rowMajor;
+  ColumnMajorTable columnMajor;
+  TiledTable tiled;
+
+  loadTable(rowMajor);
+  loadTable(columnMajor);
+  loadTable(tiled);
+
+  TEST_ASSERT_EQUAL(15, sizeof(rowMajor.cells));
+  TEST_ASSERT_EQUAL(15, sizeof(columnMajor.cells));
+  TEST_ASSERT_EQUAL(24, sizeof(tiled.cells));
+
+  TEST_ASSERT_EQUAL_UINT8(50, columnMajor.cells[1]);
+  TEST_ASSERT_EQUAL_UINT8(50, tiled.cells[2]);
+
+  for (uint16_t x = 0; x < 256; x += 5)
+  {
+    for (uint16_t y = 0; y < 256; y += 5)
+    {
+      uint8_t expected = rowMajor.lookup(x, y);
+      TEST_ASSERT_EQUAL_UINT8(expected, columnMajor.lookup(x, y));
+      TEST_ASSERT_EQUAL_UINT8(expected, tiled.lookup(x, y));
+    }
+  }
+}
+
+template<typename Table>
+uint16_t timeLookup(const Table &table, uint8_t x, uint8_t y, uint8_t &output)
+{
+  TIME_START
+  output = table.lookup(x, y);
+  TIME_END
+
+  return TIME_DIFF;
+}
+
+void test_table2D_LayoutTiming()
+{
+  RowMajorTable rowMajor;
+  ColumnMajorTable columnMajor;
+  TiledTable tiled;
+
+  loadTable(rowMajor);
+  loadTable(columnMajor);
+  loadTable(tiled);
+
+  uint8_t rowMajorOutput, columnMajorOutput, tiledOutput;
+
+  uint16_t rowMajorTicks = timeLookup(rowMajor, 125, 150, rowMajorOutput);
+  uint16_t columnMajorTicks = timeLookup(columnMajor, 125, 150, columnMajorOutput);
+  uint16_t tiledTicks = timeLookup(tiled, 125, 150, tiledOutput);
+
+  TEST_ASSERT_EQUAL_UINT8(rowMajorOutput, columnMajorOutput);
+  TEST_ASSERT_EQUAL_UINT8(rowMajorOutput, tiledOutput);
+
+  snprintf(message, MAX_MESSAGE_LEN, "Table2D::lookup: row-major %u ticks, column-major %u ticks, tiled %u ticks",
+    rowMajorTicks, columnMajorTicks, tiledTicks);
+  TEST_MESSAGE(message);
+}
+
+void test_table3D()
+{
+  Table3D<uint8_t, uint8_t, uint8_t, uint8_t, 2, 2, 2> table = {
+    {0, 100},
+    {0, 100},
+    {0, 80},
+    { 0, 100,    //  0
+     50, 150,
+     80, 180,    // 80
+    130, 230}};
+
+  TEST_ASSERT_EQUAL_UINT8(75, table.lookup(50, 50, 0));
+  TEST_ASSERT_EQUAL_UINT8(155, table.lookup(50, 50, 80));
+  TEST_ASSERT_EQUAL_UINT8(115, table.lookup(50, 50, 40));
+  TEST_ASSERT_EQUAL_UINT8(155, table.lookup(50, 50, 255));
+  TEST_ASSERT_EQUAL_UINT8(180, table.at(1, 0, 1));
+  TEST_ASSERT_EQUAL_UINT8(230, table.lookup(100, 100, 100));
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_table2D_NonSquare);
+  RUN_TEST(test_table2D_Layouts);
+  RUN_TEST(test_table2D_LayoutTiming);
+  RUN_TEST(test_table3D);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
@@ -0,0 +1,241 @@
+// Test table heatmaps
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef Table2D<uint8_t, uint16_t, uint8_t, 4, 3> VeTable;
+
+const VeTable veTable = {
+  {1000, 2000, 4000, 6000},
+  {20, 60, 100},
+  { 40,  60,  80, 100,
+    80, 120, 150, 170,
+   120, 180, 220, 250}};
+
+// Collects dump() output like Serial would print it
+struct StringPrinter
+{
+  char buffer[128];
+  size_t length;
+
+  void append(const char *text)
+  {
+    while (*text && length < sizeof(buffer) - 1)
+    {
+      buffer[length++] = *text++;
+    }
+
+    buffer[length] = 0;
+  }
+
+  void print(char c)
+  {
+    char text[2] = {c, 0};
+    append(text);
+  }
+
+  void print(unsigned long value)
+  {
+    char text[12];
+    snprintf(text, sizeof(text), "%lu", value);
+    append(text);
+  }
+
+  void println()
+  {
+    append("\n");
+  }
+};
+
+void test_tableHeatmap_Nearest()
+{
+  TableHeatmap<4, 3> heatmap;
+
+  // Outputs are the same as without a heatmap
+  TEST_ASSERT_EQUAL_UINT8(veTable.lookup(1400, 30), veTable.lookup(1400, 30, heatmap));
+  TEST_ASSERT_EQUAL_UINT8(veTable.lookup(1600, 50), veTable.lookup(1600, 50, heatmap));
+  veTable.lookup(2000, 60, heatmap);
+  veTable.lookup(9000, 0, heatmap);
+  veTable.lookup(9000, 0, heatmap);
+
+  TEST_ASSERT_EQUAL_UINT16(1, heatmap.count(0, 0));
+  TEST_ASSERT_EQUAL_UINT16(2, heatmap.count(1, 1));
+  TEST_ASSERT_EQUAL_UINT16(2, heatmap.count(3, 0));
+  TEST_ASSERT_EQUAL_UINT16(0, heatmap.count(2, 2));
+
+  StringPrinter printer = {{0}, 0};
+  heatmap.dump(printer);
+  TEST_ASSERT_EQUAL_STRING("1\t0\t0\t2\n0\t2\t0\t0\n0\t0\t0\t0\n", printer.buffer);
+
+  heatmap.reset();
+  TEST_ASSERT_EQUAL_UINT16(0, heatmap.count(1, 1));
+}
+
+void test_tableHeatmap_Weighted()
+{
+  TableHeatmap<4, 3, uint16_t, HeatmapMode::Weighted> heatmap;
+
+  // A quarter of the way across both axes
+  veTable.lookup(1250, 30, heatmap);
+  TEST_ASSERT_EQUAL_UINT16(9, heatmap.count(0, 0));
+  TEST_ASSERT_EQUAL_UINT16(3, heatmap.count(1, 0));
+  TEST_ASSERT_EQUAL_UINT16(3, heatmap.count(0, 1));
+  TEST_ASSERT_EQUAL_UINT16(1, heatmap.count(1, 1));
+
+  // On a column, half way between rows
+  veTable.lookup(4000, 80, heatmap);
+  TEST_ASSERT_EQUAL_UINT16(8, heatmap.count(2, 1));
+  TEST_ASSERT_EQUAL_UINT16(8, heatmap.count(2, 2));
+  TEST_ASSERT_EQUAL_UINT16(0, heatmap.count(3, 1));
+
+  // Off the scale
+  veTable.lookup(500, 255, heatmap);
+  TEST_ASSERT_EQUAL_UINT16(16, heatmap.count(0, 2));
+}
+
+void test_tableHeatmap_FloatAxes()
+{
+  // Spacing under 1 would truncate to 0 if the weights were found in integers
+  const float xScale[] = {0.0f, 0.5f, 1.0f};
+  const float yScale[] = {0.0f, 0.5f, 1.0f};
+  BilinearTableLocation<float, float> location = locateBilinearTable(0.125f, 0.25f, 3, 3, xScale, yScale);
+
+  TableHeatmap<3, 3, uint16_t, HeatmapMode::Weighted> weighted;
+  weighted.record(location);
+  TEST_ASSERT_EQUAL_UINT16(6, weighted.count(0, 0));
+  TEST_ASSERT_EQUAL_UINT16(2, weighted.count(1, 0));
+  TEST_ASSERT_EQUAL_UINT16(6, weighted.count(0, 1));
+  TEST_ASSERT_EQUAL_UINT16(2, weighted.count(1, 1));
+
+  TableHeatmap<3, 3> nearest;
+  nearest.record(location);
+  nearest.record(locateBilinearTable(0.375f, 0.875f, 3, 3, xScale, yScale));
+  TEST_ASSERT_EQUAL_UINT16(1, nearest.count(0, 0));
+  TEST_ASSERT_EQUAL_UINT16(1, nearest.count(1, 2));
+}
+
+void test_tableHeatmap_Saturates()
+{
+  TableHeatmap<4, 3, uint8_t> heatmap;
+
+  for (uint16_t i = 0; i < 300; i++)
+  {
+    veTable.lookup(1000, 20, heatmap);
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(255, heatmap.count(0, 0));
+
+  TableHeatmap<4, 3, uint8_t, HeatmapMode::Weighted> weighted;
+
+  for (uint16_t i = 0; i < 20; i++)
+  {
+    veTable.lookup(1000, 20, weighted);
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(255, weighted.count(0, 0));
+}
+
+void test_tableHeatmap_Timing()
+{
+  NullTableHeatmap nullHeatmap;
+  TableHeatmap<4, 3> nearestHeatmap;
+  TableHeatmap<4, 3, uint16_t, HeatmapMode::Weighted> weightedHeatmap;
+  uint8_t plain, none, nearest, weighted;
+
+  TIME_START
+  plain = veTable.lookup(3100, 70);
+  TIME_END
+  uint16_t plainTicks = TIME_DIFF;
+
+  TIME_START
+  none = veTable.lookup(3100, 70, nullHeatmap);
+  TIME_END
+  uint16_t nullTicks = TIME_DIFF;
+
+  TIME_START
+  nearest = veTable.lookup(3100, 70, nearestHeatmap);
+  TIME_END
+  uint16_t nearestTicks = TIME_DIFF;
+
+  TIME_START
+  weighted = veTable.lookup(3100, 70, weightedHeatmap);
+  TIME_END
+  uint16_t weightedTicks = TIME_DIFF;
+
+  TEST_ASSERT_EQUAL_UINT8(plain, none);
+  TEST_ASSERT_EQUAL_UINT8(plain, nearest);
+  TEST_ASSERT_EQUAL_UINT8(plain, weighted);
+
+  snprintf(message, MAX_MESSAGE_LEN, "Table2D::lookup %u ticks, null heatmap %u ticks, nearest %u ticks, weighted %u ticks",
+    plainTicks, nullTicks, nearestTicks, weightedTicks);
+  TEST_MESSAGE(message);
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_tableHeatmap_Nearest);
+  RUN_TEST(test_tableHeatmap_Weighted);
+  RUN_TEST(test_tableHeatmap_FloatAxes);
+  RUN_TEST(test_tableHeatmap_Saturates);
+  RUN_TEST(test_tableHeatmap_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
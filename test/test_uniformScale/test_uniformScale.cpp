@@ -0,0 +1,199 @@
+// Test uniform scales
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "EngineCalculations.h"
+
+#define MAX_MESSAGE_LEN 255
+
+char message[MAX_MESSAGE_LEN];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+// clean stuff up here
+}
+
+#ifdef __AVR_ATmega2560__
+
+uint16_t start, end;
+
+#define TIME_START {noInterrupts(); start = TCNT1;}
+#define TIME_END {end = TCNT1; interrupts();}
+#define TIME_DIFF (end - start)
+
+#else
+
+#define TIME_START
+#define TIME_END
+#define TIME_DIFF (0)
+
+#endif
+
+typedef UniformScale<uint16_t, 500, 500> RpmScale;
+const uint16_t rpmArray[] = {500, 1000, 1500, 2000, 2500, 3000, 3500, 4000};
+const uint16_t rpmOutputs[] = {1200, 1350, 1800, 2400, 2600, 2550, 2300, 2000};
+
+typedef UniformScale<uint8_t, 16, 16> LoadScale;
+const uint8_t loadArray[] = {16, 32, 48, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, 224, 240};
+const uint8_t loadOutputs[] = {10, 30, 35, 60, 62, 90, 120, 121, 140, 160, 150, 170, 200, 230, 255};
+
+template<typename T, typename Scale, typename ScaleArray>
+void checkFindOnScale(Scale scale, ScaleArray array, size_t length, int32_t maxInput, int32_t minInput = 0)
+{
+  for (int32_t i = minInput; i <= maxInput; i++)
+  {
+    T input = static_cast<T>(i);
+    size_t expectedIndex, actualIndex;
+    T expectedLow = 0, expectedHigh = 0, actualLow = 0, actualHigh = 0;
+
+    FindOnScaleResult expected = findOnScale(input, array, length, expectedIndex, expectedLow, expectedHigh);
+    FindOnScaleResult actual = findOnScale(input, scale, length, actualIndex, actualLow, actualHigh);
+
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(expected), static_cast<uint8_t>(actual));
+    TEST_ASSERT_EQUAL(expectedIndex, actualIndex);
+
+    if (FindOnScaleResult::OffScaleLow != expected)
+    {
+      TEST_ASSERT_EQUAL(expectedLow, actualLow);
+    }
+
+    if (FindOnScaleResult::OffScaleHigh != expected)
+    {
+      TEST_ASSERT_EQUAL(expectedHigh, actualHigh);
+    }
+  }
+}
+
+void test_uniformScale_Index()
+{
+  RpmScale rpm;
+  TEST_ASSERT_EQUAL_UINT16(500, rpm[0]);
+  TEST_ASSERT_EQUAL_UINT16(4000, rpm[7]);
+  TEST_ASSERT_TRUE(inAscendingOrder(rpm, 8));
+
+  TEST_ASSERT_EQUAL_UINT8(4, LoadScale::Step::shift);
+}
+
+void test_uniformScale_FindOnScale()
+{
+  checkFindOnScale<uint16_t>(RpmScale(), rpmArray, 8, 5000);
+  checkFindOnScale<uint8_t>(LoadScale(), loadArray, 15, 255);
+}
+
+void test_uniformScale_FindOnScaleSigned()
+{
+  // Spans wider than int8_t's max, so the offset from start doesn't fit in the scale type
+  const int8_t trimArray[] = {-100, -75, -50, -25, 0, 25, 50, 75, 100};
+  checkFindOnScale<int8_t>(UniformScale<int8_t, -100, 25>(), trimArray, 9, 127, -128);
+
+  const int8_t trimArrayPow2[] = {-96, -64, -32, 0, 32, 64, 96};
+  checkFindOnScale<int8_t>(UniformScale<int8_t, -96, 32>(), trimArrayPow2, 7, 127, -128);
+}
+
+void test_uniformScale_InterpolateLinear()
+{
+  // Array scales use an 8-bit slope, which is off by more than 1 over a step of 500
+  for (uint16_t rpm = 0; rpm < 5000; rpm += 7)
+  {
+    uint16_t expected = static_cast<uint16_t>(interpolateLinearTable<float>(static_cast<float>(rpm), 8, rpmArray, rpmOutputs) + 0.5f);
+    TEST_ASSERT_EQUAL_UINT16(expected, interpolateLinearTable<uint16_t>(rpm, 8, RpmScale(), rpmOutputs));
+  }
+
+  for (uint16_t load = 0; load < 256; load++)
+  {
+    TEST_ASSERT_UINT8_WITHIN(1, interpolateLinearTable<uint8_t>(static_cast<uint8_t>(load), 15, loadArray, loadOutputs),
+      interpolateLinearTable<uint8_t>(static_cast<uint8_t>(load), 15, LoadScale(), loadOutputs));
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(41, interpolateLinearTable<uint8_t>(static_cast<uint8_t>(52), 15, LoadScale(), loadOutputs));
+  TEST_ASSERT_EQUAL_UINT16(2100, interpolateLinearTable<uint16_t>(static_cast<uint16_t>(1750), 8, RpmScale(), rpmOutputs));
+}
+
+void test_uniformScale_MixedBilinear()
+{
+  const uint8_t cells[] = {
+      0, 100, 200,  40, 90, 120, 130, 135,
+     50, 150, 250,  60, 10,  30,  50,  70,
+     20,  30,  40, 200, 70, 100,   0, 255};
+  const uint8_t yScale[] = {0, 100, 200};
+
+  for (uint16_t rpm = 0; rpm < 5000; rpm += 17)
+  {
+    for (uint16_t y = 0; y < 256; y += 13)
+    {
+      TEST_ASSERT_EQUAL_UINT8(
+        interpolateBilinearTable<uint8_t>(rpm, static_cast<uint8_t>(y), 8, 3, rpmArray, yScale, cells),
+        interpolateBilinearTable<uint8_t>(rpm, static_cast<uint8_t>(y), 8, 3, RpmScale(), yScale, cells));
+    }
+  }
+}
+
+void test_uniformScale_Timing()
+{
+  uint8_t load = 52;
+  uint8_t arrayOutput, uniformOutput;
+
+  TIME_START
+  arrayOutput = interpolateLinearTable<uint8_t>(load, 15, loadArray, loadOutputs);
+  TIME_END
+  uint16_t arrayTicks = TIME_DIFF;
+
+  TIME_START
+  uniformOutput = interpolateLinearTable<uint8_t>(load, 15, LoadScale(), loadOutputs);
+  TIME_END
+  uint16_t uniformTicks = TIME_DIFF;
+
+  TEST_ASSERT_UINT8_WITHIN(1, arrayOutput, uniformOutput);
+
+  snprintf(message, MAX_MESSAGE_LEN, "interpolateLinearTable: array scale %u ticks, power-of-two UniformScale %u ticks",
+    arrayTicks, uniformTicks);
+  TEST_MESSAGE(message);
+
+#ifdef __AVR_ATmega2560__
+  TEST_ASSERT_LESS_THAN(arrayTicks, uniformTicks);
+#endif
+}
+
+void setup() {
+  // NOTE!!! Wait for >2 secs
+  // if board doesn't support software reset via Serial.DTR/RTS
+  delay(200);
+
+  UNITY_BEGIN();    // IMPORTANT LINE!
+
+#ifdef __AVR_ATmega2560__
+  // Set Timer 1 to run in normal counting mode (no PWM, rollover to 0)
+  TCCR1A = 0;
+  // Set Timer 1 to use no prescaling (run in sync with system clock)
+  TCCR1B = 1;
+#endif
+
+  RUN_TEST(test_uniformScale_Index);
+  RUN_TEST(test_uniformScale_FindOnScale);
+  RUN_TEST(test_uniformScale_FindOnScaleSigned);
+  RUN_TEST(test_uniformScale_InterpolateLinear);
+  RUN_TEST(test_uniformScale_MixedBilinear);
+  RUN_TEST(test_uniformScale_Timing);
+
+  UNITY_END(); // stop unit testing
+}
+
+void loop() {
+}
@@ -0,0 +1,500 @@
+// VE Table Autotune
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Fits a VE table to wideband logs. Each sample says the cells around its RPM and load should
+// have interpolated to VE * measured lambda / target lambda. Those are linear equations in the
+// cells, weighted by the same bilinear weights interpolateBilinearTable() uses, so the fit is a
+// sparse least-squares problem, regularized toward smooth tables and toward the current one.
+//
+// Samples are weighted and accumulated into normal equations on every core, each thread in its
+// own buffers, which are summed when all logs are done. Each cell only couples to its eight
+// neighbors, so a cell's equation is a 3x3 stencil and the system is solved with conjugate
+// gradients.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc tools/autotune.cpp src/*.cpp -o autotune
+//
+// The table type below must match the ECU's. Override its size with
+// -DAUTOTUNE_X_LENGTH=n -DAUTOTUNE_Y_LENGTH=n.
+//
+// Usage:
+//   autotune [options] table.bin output.bin log.ecdl...
+//
+// table.bin is the Table2D image the logs were recorded with. output.bin gets the tuned table,
+// with the same scales. Logs are datalogs (see datalog.h) with Rpm, Load and MeasuredLambda
+// channels, and Lambda for the target if it wasn't stoichiometric.
+//
+// Options:
+//   --threads n      Worker threads (all cores)
+//   --smoothing s    Weight of differences between neighbor cells, per average sample per cell (0.05)
+//   --prior p        Weight of the current table, per average sample per cell (0.001)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EngineCalculations.h"
+
+#include "replayLog.h"
+#include "datalogReader.h"
+
+#ifndef AUTOTUNE_X_LENGTH
+#define AUTOTUNE_X_LENGTH 16
+#endif
+
+#ifndef AUTOTUNE_Y_LENGTH
+#define AUTOTUNE_Y_LENGTH 16
+#endif
+
+// VE percent by RPM and load percent
+typedef Table2D<uint8_t, uint16_t, uint8_t, AUTOTUNE_X_LENGTH, AUTOTUNE_Y_LENGTH> VeTable;
+
+constexpr size_t xLength = VeTable::xSize;
+constexpr size_t yLength = VeTable::ySize;
+constexpr size_t cellCount = xLength * yLength;
+
+// Coefficients of a cell's equation on itself and its neighbors, by (dy + 1) * 3 + (dx + 1)
+constexpr uint8_t stencilSize = 9;
+
+// Records per unit of work
+constexpr uint32_t chunkSize = 1 << 16;
+
+// Cell index of x, y in the solver, independent of the table's layout
+inline size_t cellIndex(size_t xIndex, size_t yIndex)
+{
+  return yIndex * xLength + xIndex;
+}
+
+struct NormalEquations
+{
+  std::vector<double> lhs;  // cellCount * stencilSize
+  std::vector<double> rhs;  // cellCount
+  std::vector<uint32_t> hits;
+  uint64_t samples = 0;
+  uint64_t rejected = 0;
+
+  NormalEquations()
+    : lhs(cellCount * stencilSize, 0.0), rhs(cellCount, 0.0), hits(cellCount, 0)
+  {
+  }
+
+  void add(const NormalEquations &other)
+  {
+    for (size_t i = 0; i < lhs.size(); i++)
+    {
+      lhs[i] += other.lhs[i];
+    }
+
+    for (size_t i = 0; i < cellCount; i++)
+    {
+      rhs[i] += other.rhs[i];
+      hits[i] += other.hits[i];
+    }
+
+    samples += other.samples;
+    rejected += other.rejected;
+  }
+};
+
+struct Chunk
+{
+  const DatalogReader *log;
+  const uint8_t *position;
+  uint32_t ticks;
+  uint32_t count;
+};
+
+struct LogChannels
+{
+  int rpm;
+  int load;
+  int measuredLambda;
+  int lambda;
+};
+
+// Weight of the high cell on one axis, 0 unless between two scale values
+template<typename T>
+double highWeight(FindOnScaleResult result, T input, T low, T high)
+{
+  if (FindOnScaleResult::InBetween != result)
+  {
+    return 0.0;
+  }
+
+  return (static_cast<double>(input) - low) / (static_cast<double>(high) - low);
+}
+
+static void accumulate(const VeTable &table, const Chunk &chunk, const LogChannels &channels, NormalEquations &equations)
+{
+  DatalogReader reader = *chunk.log;
+  reader.seek(chunk.position, chunk.ticks);
+
+  for (uint32_t record = 0; record < chunk.count && reader.next(); record++)
+  {
+    uint16_t rpm = reader.value<uint16_t>(channels.rpm);
+    uint8_t loadPercent = static_cast<uint8_t>(reader.value<uint16_t>(channels.load) / 10);
+    double measuredLambda = reader.value<uint16_t>(channels.measuredLambda) * (1.0 / 1000.0);
+    double targetLambda = channels.lambda < 0 ? 1.0 : reader.value<uint16_t>(channels.lambda) * (1.0 / 100.0);
+
+    // Wideband warming up, or fuel cut
+    if (measuredLambda < 0.5 || measuredLambda > 2.0 || targetLambda <= 0.0)
+    {
+      equations.rejected++;
+      continue;
+    }
+
+    // Same scale search and interpolation the ECU did for this sample
+    BilinearTableLocation<uint16_t, uint8_t> location = table.locate(rpm, loadPercent);
+    double observed = table.lookup(location) * measuredLambda / targetLambda;
+
+    double x1 = highWeight(location.xResult, location.x, location.xLow, location.xHigh);
+    double y1 = highWeight(location.yResult, location.y, location.yLow, location.yHigh);
+    const double weights[4] = {(1 - x1) * (1 - y1), x1 * (1 - y1), (1 - x1) * y1, x1 * y1};
+
+    for (uint8_t a = 0; a < 4; a++)
+    {
+      if (weights[a] == 0.0)
+      {
+        continue;
+      }
+
+      size_t cellA = cellIndex(location.xLowIndex + (a & 1u), location.yLowIndex + (a >> 1));
+      equations.rhs[cellA] += weights[a] * observed;
+      equations.hits[cellA]++;
+
+      for (uint8_t b = 0; b < 4; b++)
+      {
+        if (weights[b] == 0.0)
+        {
+          continue;
+        }
+
+        int dx = static_cast<int>(b & 1u) - static_cast<int>(a & 1u);
+        int dy = static_cast<int>(b >> 1) - static_cast<int>(a >> 1);
+        equations.lhs[cellA * stencilSize + (dy + 1) * 3 + (dx + 1)] += weights[a] * weights[b];
+      }
+    }
+
+    equations.samples++;
+  }
+}
+
+// Normal equations plus regularization, applied to cells without forming a matrix
+class RegularizedSystem
+{
+public:
+  RegularizedSystem(const NormalEquations &equations, double smoothing, double prior)
+    : _equations(equations), _smoothing(smoothing), _prior(prior)
+  {
+  }
+
+  void multiply(const std::vector<double> &cells, std::vector<double> &out) const
+  {
+    for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+    {
+      for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+      {
+        size_t cell = cellIndex(xIndex, yIndex);
+        const double *stencil = &_equations.lhs[cell * stencilSize];
+        double sum = _prior * cells[cell];
+
+        for (int dy = -1; dy <= 1; dy++)
+        {
+          for (int dx = -1; dx <= 1; dx++)
+          {
+            double coefficient = stencil[(dy + 1) * 3 + (dx + 1)];
+
+            if (coefficient != 0.0)
+            {
+              sum += coefficient * cells[cellIndex(xIndex + dx, yIndex + dy)];
+            }
+          }
+        }
+
+        // Smoothing is the sum of (cell - neighbor)^2 over edges, whose gradient is the graph Laplacian
+        const int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const int *offset : offsets)
+        {
+          size_t neighborX = xIndex + offset[0];
+          size_t neighborY = yIndex + offset[1];
+
+          if (neighborX < xLength && neighborY < yLength)
+          {
+            sum += _smoothing * (cells[cell] - cells[cellIndex(neighborX, neighborY)]);
+          }
+        }
+
+        out[cell] = sum;
+      }
+    }
+  }
+
+  // Conjugate gradients. The system is symmetric positive definite as long as prior > 0.
+  unsigned solve(const std::vector<double> &priorCells, std::vector<double> &cells) const
+  {
+    std::vector<double> residual(cellCount), direction(cellCount), product(cellCount);
+
+    multiply(cells, product);
+
+    for (size_t i = 0; i < cellCount; i++)
+    {
+      residual[i] = _equations.rhs[i] + _prior * priorCells[i] - product[i];
+      direction[i] = residual[i];
+    }
+
+    double residualSquared = dot(residual, residual);
+    double tolerance = 1e-20 * (dot(_equations.rhs, _equations.rhs) + 1.0);
+    unsigned iteration = 0;
+
+    for (; iteration < 10 * cellCount && residualSquared > tolerance; iteration++)
+    {
+      multiply(direction, product);
+
+      double step = residualSquared / dot(direction, product);
+
+      for (size_t i = 0; i < cellCount; i++)
+      {
+        cells[i] += step * direction[i];
+        residual[i] -= step * product[i];
+      }
+
+      double nextResidualSquared = dot(residual, residual);
+
+      for (size_t i = 0; i < cellCount; i++)
+      {
+        direction[i] = residual[i] + (nextResidualSquared / residualSquared) * direction[i];
+      }
+
+      residualSquared = nextResidualSquared;
+    }
+
+    return iteration;
+  }
+
+private:
+  static double dot(const std::vector<double> &a, const std::vector<double> &b)
+  {
+    double sum = 0.0;
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      sum += a[i] * b[i];
+    }
+
+    return sum;
+  }
+
+  const NormalEquations &_equations;
+  double _smoothing;
+  double _prior;
+};
+
+static int usage()
+{
+  fprintf(stderr, "usage: autotune [--threads n] [--smoothing s] [--prior p] table.bin output.bin log.ecdl...\n");
+  return 2;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threadCount = std::thread::hardware_concurrency();
+  double smoothing = 0.05;
+  double prior = 0.001;
+  int arg = 1;
+
+  for (; arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0; arg += 2)
+  {
+    if (strcmp(argv[arg], "--threads") == 0)
+    {
+      threadCount = atoi(argv[arg + 1]);
+    }
+    else if (strcmp(argv[arg], "--smoothing") == 0)
+    {
+      smoothing = atof(argv[arg + 1]);
+    }
+    else if (strcmp(argv[arg], "--prior") == 0)
+    {
+      prior = atof(argv[arg + 1]);
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  if (argc - arg < 3 || prior <= 0.0 || smoothing < 0.0)
+  {
+    return usage();
+  }
+
+  if (threadCount == 0)
+  {
+    threadCount = 1;
+  }
+
+  const char *tablePath = argv[arg];
+  const char *outputPath = argv[arg + 1];
+  int logCount = argc - arg - 2;
+  char **logPaths = argv + arg + 2;
+
+  VeTable table;
+  FILE *tableFile = fopen(tablePath, "rb");
+  if (!tableFile || fread(&table, sizeof(table), 1, tableFile) != 1)
+  {
+    fprintf(stderr, "%s: can't read a %zux%zu table\n", tablePath, xLength, yLength);
+    return 1;
+  }
+  fclose(tableFile);
+
+  // Map the logs and split them into chunks any thread can start at
+  std::vector<MappedFile> files(logCount);
+  std::vector<DatalogReader> logs(logCount);
+  std::vector<LogChannels> channels(logCount);
+  std::vector<Chunk> chunks;
+
+  for (int i = 0; i < logCount; i++)
+  {
+    DatalogReader &log = logs[i];
+
+    if (!files[i].openRead(logPaths[i]) || !log.open(files[i].data(), files[i].size()))
+    {
+      fprintf(stderr, "%s: not a datalog\n", logPaths[i]);
+      return 1;
+    }
+
+    channels[i].rpm = log.channelIndex(DatalogChannelId::Rpm);
+    channels[i].load = log.channelIndex(DatalogChannelId::Load);
+    channels[i].measuredLambda = log.channelIndex(DatalogChannelId::MeasuredLambda);
+    channels[i].lambda = log.channelIndex(DatalogChannelId::Lambda);
+
+    if (channels[i].rpm < 0 || channels[i].load < 0 || channels[i].measuredLambda < 0)
+    {
+      fprintf(stderr, "%s: needs Rpm, Load and MeasuredLambda channels\n", logPaths[i]);
+      return 1;
+    }
+
+    // Only varints are decoded here, to find where each chunk starts
+    DatalogReader scan = log;
+    Chunk chunk = {&log, scan.position(), scan.ticks(), 0};
+
+    while (scan.next())
+    {
+      if (++chunk.count == chunkSize)
+      {
+        chunks.push_back(chunk);
+        chunk = {&log, scan.position(), scan.ticks(), 0};
+      }
+    }
+
+    if (chunk.count > 0)
+    {
+      chunks.push_back(chunk);
+    }
+  }
+
+  // Workers take chunks in order until there are none left
+  std::vector<NormalEquations> threadEquations(threadCount);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> nextChunk(0);
+
+  for (unsigned t = 0; t < threadCount; t++)
+  {
+    threads.emplace_back([&, t]() {
+      // Counted on every record, so keep them off the cache lines of other workers' equations
+      NormalEquations local;
+
+      for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+      {
+        const Chunk &chunk = chunks[i];
+        accumulate(table, chunk, channels[chunk.log - logs.data()], local);
+      }
+
+      threadEquations[t] = std::move(local);
+    });
+  }
+
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  NormalEquations equations;
+  for (const NormalEquations &threadEquation : threadEquations)
+  {
+    equations.add(threadEquation);
+  }
+
+  if (equations.samples == 0)
+  {
+    fprintf(stderr, "No usable samples\n");
+    return 1;
+  }
+
+  // Regularization scales with the data, so the same settings suit short and long logs
+  double samplesPerCell = static_cast<double>(equations.samples) / cellCount;
+
+  std::vector<double> priorCells(cellCount), cells(cellCount);
+  for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+  {
+    for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+    {
+      priorCells[cellIndex(xIndex, yIndex)] = table.at(xIndex, yIndex);
+    }
+  }
+  cells = priorCells;
+
+  RegularizedSystem system(equations, smoothing * samplesPerCell, prior * samplesPerCell);
+  unsigned iterations = system.solve(priorCells, cells);
+
+  VeTable tuned = table;
+  unsigned cellsHit = 0;
+  double maxChange = 0.0;
+
+  for (size_t yIndex = 0; yIndex < yLength; yIndex++)
+  {
+    for (size_t xIndex = 0; xIndex < xLength; xIndex++)
+    {
+      size_t cell = cellIndex(xIndex, yIndex);
+      double value = floor(cells[cell] + 0.5);
+
+      tuned.at(xIndex, yIndex) = value < 0 ? 0 : value > IntegerLimits<uint8_t>::max ? IntegerLimits<uint8_t>::max : static_cast<uint8_t>(value);
+
+      cellsHit += equations.hits[cell] > 0;
+      maxChange = fmax(maxChange, fabs(cells[cell] - priorCells[cell]));
+    }
+  }
+
+  FILE *outputFile = fopen(outputPath, "wb");
+  if (!outputFile || fwrite(&tuned, sizeof(tuned), 1, outputFile) != 1 || fclose(outputFile) != 0)
+  {
+    perror(outputPath);
+    return 1;
+  }
+
+  fprintf(stderr, "%llu samples (%llu rejected) in %zu chunks on %u threads, %u of %zu cells hit, "
+    "solved in %u iterations, largest change %.1f\n",
+    static_cast<unsigned long long>(equations.samples), static_cast<unsigned long long>(equations.rejected),
+    chunks.size(), threadCount, cellsHit, cellCount, iterations, maxChange);
+
+  return 0;
+}
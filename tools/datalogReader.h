@@ -0,0 +1,202 @@
+// Datalog Reader
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_TOOLS_DATALOG_READER_H_
+#define ENGINE_CALCULATIONS_TOOLS_DATALOG_READER_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "datalog.h"
+
+struct DatalogSchemaChannel
+{
+  DatalogChannelId id;
+  DatalogType type;
+  uint8_t offset;  // Offset of the value from the end of the record's varint
+};
+
+/**
+ * @brief Reads a datalog written by DatalogEncoder in place
+ * 
+ * Nothing is copied: values are read straight out of the buffer, like a memory-mapped log,
+ * as each record is visited.
+ * 
+ * Ex:
+ *   DatalogReader reader;
+ *   if (reader.open(data, size)) {
+ *     int rpm = reader.channelIndex(DatalogChannelId::Rpm);
+ *     while (reader.next()) use(reader.ticks(), reader.value<uint16_t>(rpm));
+ *   }
+ */
+class DatalogReader
+{
+public:
+  // Read the header. Returns false if it isn't a datalog this reader understands.
+  bool open(const uint8_t *data, size_t size)
+  {
+    if (size < 14 || memcmp(data, datalogMagic, sizeof(datalogMagic)) != 0 || data[4] != datalogVersion)
+    {
+      return false;
+    }
+
+    _channelCount = data[5];
+    memcpy(&_ticksPerSecond, data + 6, sizeof(_ticksPerSecond));
+    memcpy(&_ticks, data + 10, sizeof(_ticks));
+
+    size_t headerSize = 14 + 2 * static_cast<size_t>(_channelCount);
+    if (size < headerSize)
+    {
+      return false;
+    }
+
+    size_t offset = 0;
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+      DatalogSchemaChannel &channel = _channels[i];
+      channel.id = static_cast<DatalogChannelId>(data[14 + 2 * i]);
+      channel.type = static_cast<DatalogType>(data[15 + 2 * i]);
+      channel.offset = static_cast<uint8_t>(offset);
+
+      uint8_t width = datalogTypeSize(channel.type);
+      if (width == 0 || offset + width > 255)
+      {
+        return false;
+      }
+
+      offset += width;
+    }
+
+    _valuesSize = offset;
+    _cursor = data + headerSize;
+    _end = data + size;
+    _values = nullptr;
+
+    return true;
+  }
+
+  // Move to the next record. Returns false at the end of the log or at a truncated record.
+  bool next()
+  {
+    uint32_t deltaTicks;
+    uint8_t length = decodeVarint(_cursor, _end - _cursor, deltaTicks);
+
+    if (length == 0 || static_cast<size_t>(_end - _cursor) < length + _valuesSize)
+    {
+      return false;
+    }
+
+    _ticks += deltaTicks;
+    _values = _cursor + length;
+    _cursor = _values + _valuesSize;
+
+    return true;
+  }
+
+  // Where the next record starts, to seek() back to later
+  const uint8_t *position() const
+  {
+    return _cursor;
+  }
+
+  // Continue from a position() in the same log, with the ticks of the record before it
+  void seek(const uint8_t *position, uint32_t ticks)
+  {
+    _cursor = position;
+    _ticks = ticks;
+    _values = nullptr;
+  }
+
+  uint32_t ticks() const
+  {
+    return _ticks;
+  }
+
+  uint32_t ticksPerSecond() const
+  {
+    return _ticksPerSecond;
+  }
+
+  uint8_t channelCount() const
+  {
+    return _channelCount;
+  }
+
+  const DatalogSchemaChannel &channel(uint8_t index) const
+  {
+    return _channels[index];
+  }
+
+  // Index of the first channel with id, or -1 if the log doesn't have it
+  int channelIndex(DatalogChannelId id) const
+  {
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+      if (_channels[i].id == id)
+      {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  // Value of a channel in the current record, converted to T
+  template<typename T>
+  T value(uint8_t index) const
+  {
+    const DatalogSchemaChannel &channel = _channels[index];
+    const uint8_t *in = _values + channel.offset;
+
+    switch (channel.type)
+    {
+    case DatalogType::UInt8: return static_cast<T>(read<uint8_t>(in));
+    case DatalogType::Int8: return static_cast<T>(read<int8_t>(in));
+    case DatalogType::UInt16: return static_cast<T>(read<uint16_t>(in));
+    case DatalogType::Int16: return static_cast<T>(read<int16_t>(in));
+    case DatalogType::UInt32: return static_cast<T>(read<uint32_t>(in));
+    case DatalogType::Int32: return static_cast<T>(read<int32_t>(in));
+    case DatalogType::Float: return static_cast<T>(read<float>(in));
+    }
+
+    return 0;
+  }
+
+private:
+  // Records aren't aligned
+  template<typename T>
+  static T read(const uint8_t *in)
+  {
+    T value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+  }
+
+  DatalogSchemaChannel _channels[255];
+  uint8_t _channelCount = 0;
+  size_t _valuesSize = 0;
+  uint32_t _ticksPerSecond = 0;
+  uint32_t _ticks = 0;
+  const uint8_t *_cursor = nullptr;
+  const uint8_t *_end = nullptr;
+  const uint8_t *_values = nullptr;
+};
+
+#endif
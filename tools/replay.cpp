@@ -0,0 +1,522 @@
+// Log Replay
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Replays a recorded input log through the calculators and tables, and writes an output log with
+// one record per input record. See replayLog.h for the format.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/replay.cpp src/*.cpp -o replay
+//
+// Usage:
+//   replay [options] input.log output.log   Replay input.log into output.log
+//   replay --generate count input.log        Write a synthetic input log of count events
+//   replay --encode input.log input.ecdl     Convert an input log to a datalog
+//   replay --dump output.log                 Print an output log as tab-separated text
+//
+// The input can also be a datalog (see datalog.h) with CrankAngle and Maf channels, and
+// optionally Map and Tps, in the units of the input log.
+//
+// Options:
+//   --cylinders n         Cylinders per airflow sensor (4)
+//   --bore cm             Cylinder bore (8.6)
+//   --stroke cm           Cylinder stroke (8.6)
+//   --injector cc/min     Injector flow (440)
+//   --lambda-table file   Table2D image of target lambda (built in)
+//   --advance-table file  Table2D image of spark advance (built in)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include <vector>
+
+#include "EngineCalculations.h"
+
+#include "replayLog.h"
+#include "datalogReader.h"
+
+// RPM by load percent, the same axes for both tables
+typedef Table2D<uint8_t, uint16_t, uint8_t, 8, 8> ReplayTable;
+
+ReplayTable lambdaTable = {
+  {800, 1500, 2500, 3500, 4500, 5500, 6500, 7500},
+  {10, 20, 40, 60, 80, 100, 120, 150},
+  {100, 100, 100, 100, 100, 100, 100, 100,
+   100, 100, 100, 100, 100, 100, 100, 100,
+   100, 100, 100, 100, 100, 100, 100, 100,
+   100, 100, 100, 100,  98,  96,  95,  95,
+    95,  95,  94,  92,  90,  88,  87,  86,
+    90,  90,  88,  86,  85,  84,  83,  82,
+    88,  88,  86,  84,  83,  82,  81,  80,
+    86,  86,  84,  82,  81,  80,  79,  78}};
+
+ReplayTable advanceTable = {
+  {800, 1500, 2500, 3500, 4500, 5500, 6500, 7500},
+  {10, 20, 40, 60, 80, 100, 120, 150},
+  {15, 22, 32, 38, 40, 40, 40, 40,
+   14, 20, 30, 36, 38, 38, 38, 38,
+   12, 18, 27, 32, 34, 35, 35, 35,
+   10, 15, 23, 28, 30, 31, 31, 31,
+    8, 12, 19, 24, 26, 27, 27, 27,
+    6, 10, 16, 20, 22, 23, 23, 23,
+    5,  8, 13, 17, 19, 20, 20, 20,
+    4,  6, 10, 14, 16, 17, 17, 17}};
+
+struct ReplayConfig
+{
+  int cylindersPerAirflowSensor = 4;
+  float cylinderBoreCm = 8.6;
+  float cylinderStrokeCm = 8.6;
+  float injectorFlowCcPerMin = 440;
+};
+
+// Records are replayed a batch at a time, one stage over the whole batch before the next, so
+// each stage's loop stays small and its inputs stay in cache
+constexpr size_t batchSize = 1024;
+
+struct ReplayBatch
+{
+  float crankSpeedDegreesPerTick[batchSize];
+  float inverseCrankSpeedTicksPerDegree[batchSize];
+  float airflowGramsPerSecond[batchSize];
+  float loadFraction[batchSize];
+};
+
+class Replayer
+{
+public:
+  Replayer(uint32_t ticksPerSecond, const ReplayConfig &config)
+    : _rpmCalculator(ticksPerSecond),
+      _loadCalculator(ticksPerSecond, config.cylindersPerAirflowSensor, config.cylinderBoreCm, config.cylinderStrokeCm),
+      _injectionCalculator(ticksPerSecond, config.injectorFlowCcPerMin, config.cylindersPerAirflowSensor),
+      _sharedScales(memcmp(lambdaTable.xScale, advanceTable.xScale, sizeof(lambdaTable.xScale)) == 0
+        && memcmp(lambdaTable.yScale, advanceTable.yScale, sizeof(lambdaTable.yScale)) == 0)
+  {
+  }
+
+  void run(const ReplayInput *inputs, ReplayOutput *outputs, uint32_t count)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    // First event has no previous event to measure crank speed from
+    memset(&outputs[0], 0, sizeof(ReplayOutput));
+    outputs[0].ticks = inputs[0].ticks;
+
+    for (uint32_t start = 1; start < count; start += batchSize)
+    {
+      size_t length = count - start < batchSize ? count - start : batchSize;
+      runBatch(inputs + start, outputs + start, length);
+    }
+  }
+
+private:
+  // inputs[-1] is the previous event
+  void runBatch(const ReplayInput *inputs, ReplayOutput *outputs, size_t length)
+  {
+    for (size_t i = 0; i < length; i++)
+    {
+      // Unsigned difference handles timer wraparound
+      float deltaTicks = static_cast<float>(inputs[i].ticks - inputs[i - 1].ticks);
+      float deltaDegrees = inputs[i].crankAngle * (1.0f / 16.0f);
+
+      _batch.crankSpeedDegreesPerTick[i] = deltaDegrees / deltaTicks;
+      _batch.inverseCrankSpeedTicksPerDegree[i] = deltaTicks / deltaDegrees;
+      _batch.airflowGramsPerSecond[i] = inputs[i].maf * (1.0f / 100.0f);
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+      float rpm = _rpmCalculator(_batch.crankSpeedDegreesPerTick[i]);
+      _batch.loadFraction[i] = _loadCalculator(_batch.inverseCrankSpeedTicksPerDegree[i], _batch.airflowGramsPerSecond[i]);
+
+      outputs[i].ticks = inputs[i].ticks;
+      outputs[i].rpm = saturate<uint16_t>(rpm + 0.5f);
+      outputs[i].load = saturate<uint16_t>(_batch.loadFraction[i] * 1000.0f + 0.5f);
+      outputs[i].reserved = 0;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+      uint8_t loadPercent = saturate<uint8_t>(_batch.loadFraction[i] * 100.0f + 0.5f);
+
+      // Search the scales once for both tables when they share them
+      BilinearTableLocation<uint16_t, uint8_t> location = lambdaTable.locate(outputs[i].rpm, loadPercent);
+      outputs[i].lambda = lambdaTable.lookup(location);
+      outputs[i].advance = _sharedScales
+        ? advanceTable.lookup(location)
+        : advanceTable.lookup(outputs[i].rpm, loadPercent);
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+      // Stoichiometric fuel/air ratio of gasoline is 1/14.7
+      float targetFuelAirRatio = 100.0f / (14.7f * outputs[i].lambda);
+      float injectionTicks = _injectionCalculator(targetFuelAirRatio,
+        _batch.inverseCrankSpeedTicksPerDegree[i], _batch.airflowGramsPerSecond[i]);
+
+      outputs[i].injectionTicks = saturate<uint32_t>(injectionTicks + 0.5f);
+    }
+  }
+
+  template<typename T>
+  static T saturate(float value)
+  {
+    constexpr float max = static_cast<float>(static_cast<T>(~static_cast<T>(0)));
+
+    if (!(value > 0.0f))
+    {
+      return 0;
+    }
+
+    return value >= max ? static_cast<T>(~static_cast<T>(0)) : static_cast<T>(value);
+  }
+
+  RpmCalculator _rpmCalculator;
+  LoadFractionCalculator _loadCalculator;
+  InjectionLengthCalculator _injectionCalculator;
+  bool _sharedScales;
+  ReplayBatch _batch;
+};
+
+static bool loadTable(const char *path, ReplayTable &table)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file)
+  {
+    return false;
+  }
+
+  bool ok = fread(&table, sizeof(table), 1, file) == 1;
+  fclose(file);
+
+  if (!ok)
+  {
+    errno = EINVAL;
+  }
+
+  return ok;
+}
+
+static double secondsNow()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static int generate(uint32_t count, const char *path)
+{
+  constexpr uint32_t ticksPerSecond = 2000000;
+  constexpr uint16_t crankAngle = 10 * 16;
+
+  MappedFile file;
+  if (!file.create(path, replayLogSize(sizeof(ReplayInput), count)))
+  {
+    perror(path);
+    return 1;
+  }
+
+  ReplayInput *inputs = initReplayLog<ReplayInput>(file, replayInputMagic, ticksPerSecond, count);
+
+  // Speed and throttle sweep slowly, like a drive, with airflow following both
+  double seconds = 0;
+  uint32_t ticks = 0;
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    double rpm = 3500 + 2500 * sin(seconds * 0.2);
+    double throttle = 0.5 + 0.45 * sin(seconds * 0.13);
+    double maf = rpm * throttle * 0.03;
+
+    inputs[i].ticks = ticks;
+    inputs[i].crankAngle = crankAngle;
+    inputs[i].maf = static_cast<uint16_t>(maf * 100);
+    inputs[i].map = static_cast<uint16_t>((20 + 80 * throttle) * 10);
+    inputs[i].tps = static_cast<uint16_t>(throttle * 1000);
+    inputs[i].reserved = 0;
+
+    double eventSeconds = (crankAngle / 16.0) / (rpm * 6.0);
+    seconds += eventSeconds;
+    ticks += static_cast<uint32_t>(eventSeconds * ticksPerSecond);
+  }
+
+  return 0;
+}
+
+typedef DatalogEncoder<
+  DatalogChannel<DatalogChannelId::CrankAngle, uint16_t>,
+  DatalogChannel<DatalogChannelId::Maf, uint16_t>,
+  DatalogChannel<DatalogChannelId::Map, uint16_t>,
+  DatalogChannel<DatalogChannelId::Tps, uint16_t>> ReplayDatalogEncoder;
+
+// Encode an input log the way the ECU would stream it
+static int encode(const char *inputPath, const char *outputPath)
+{
+  MappedFile inputFile;
+  ReplayLogHeader header;
+
+  if (!inputFile.openRead(inputPath))
+  {
+    perror(inputPath);
+    return 1;
+  }
+
+  const ReplayInput *inputs = replayRecords<ReplayInput>(inputFile, replayInputMagic, header);
+  if (!inputs)
+  {
+    fprintf(stderr, "%s: not a replay input log\n", inputPath);
+    return 1;
+  }
+
+  FILE *output = fopen(outputPath, "wb");
+  if (!output)
+  {
+    perror(outputPath);
+    return 1;
+  }
+
+  ReplayDatalogEncoder encoder;
+  uint8_t buffer[ReplayDatalogEncoder::headerSize > ReplayDatalogEncoder::maxRecordSize
+    ? ReplayDatalogEncoder::headerSize : ReplayDatalogEncoder::maxRecordSize];
+
+  uint32_t baseTicks = header.recordCount > 0 ? inputs[0].ticks : 0;
+  fwrite(buffer, encoder.writeHeader(buffer, header.ticksPerSecond, baseTicks), 1, output);
+
+  for (uint32_t i = 0; i < header.recordCount; i++)
+  {
+    const ReplayInput &input = inputs[i];
+    fwrite(buffer, encoder.encode(buffer, input.ticks, input.crankAngle, input.maf, input.map, input.tps), 1, output);
+  }
+
+  long size = ftell(output);
+
+  if (fclose(output) != 0)
+  {
+    perror(outputPath);
+    return 1;
+  }
+
+  fprintf(stderr, "%lu events, %ld bytes, %.2f bytes/event\n",
+    static_cast<unsigned long>(header.recordCount), size, header.recordCount ? static_cast<double>(size) / header.recordCount : 0.0);
+
+  return 0;
+}
+
+// Decode a datalog into input records. Returns false if the datalog lacks the channels to replay.
+static bool readDatalogInputs(const MappedFile &file, uint32_t &outTicksPerSecond, std::vector<ReplayInput> &outInputs)
+{
+  DatalogReader reader;
+
+  if (!reader.open(file.data(), file.size()))
+  {
+    return false;
+  }
+
+  int crankAngle = reader.channelIndex(DatalogChannelId::CrankAngle);
+  int maf = reader.channelIndex(DatalogChannelId::Maf);
+  int map = reader.channelIndex(DatalogChannelId::Map);
+  int tps = reader.channelIndex(DatalogChannelId::Tps);
+
+  if (crankAngle < 0 || maf < 0)
+  {
+    return false;
+  }
+
+  outTicksPerSecond = reader.ticksPerSecond();
+
+  while (reader.next())
+  {
+    ReplayInput input = {};
+    input.ticks = reader.ticks();
+    input.crankAngle = reader.value<uint16_t>(crankAngle);
+    input.maf = reader.value<uint16_t>(maf);
+    input.map = map < 0 ? 0 : reader.value<uint16_t>(map);
+    input.tps = tps < 0 ? 0 : reader.value<uint16_t>(tps);
+
+    outInputs.push_back(input);
+  }
+
+  return true;
+}
+
+static int dump(const char *path)
+{
+  MappedFile file;
+  ReplayLogHeader header;
+
+  if (!file.openRead(path))
+  {
+    perror(path);
+    return 1;
+  }
+
+  const ReplayOutput *outputs = replayRecords<ReplayOutput>(file, replayOutputMagic, header);
+  if (!outputs)
+  {
+    fprintf(stderr, "%s: not a replay output log\n", path);
+    return 1;
+  }
+
+  printf("ticks\trpm\tload\tlambda\tadvance\tinjectionTicks\n");
+
+  for (uint32_t i = 0; i < header.recordCount; i++)
+  {
+    const ReplayOutput &output = outputs[i];
+    printf("%lu\t%u\t%u.%u\t%u.%02u\t%u\t%lu\n",
+      static_cast<unsigned long>(output.ticks), output.rpm,
+      output.load / 10, output.load % 10,
+      output.lambda / 100, output.lambda % 100,
+      output.advance, static_cast<unsigned long>(output.injectionTicks));
+  }
+
+  return 0;
+}
+
+static int usage()
+{
+  fprintf(stderr,
+    "usage: replay [options] input.log output.log\n"
+    "       replay --generate count input.log\n"
+    "       replay --encode input.log input.ecdl\n"
+    "       replay --dump output.log\n");
+  return 2;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc == 4 && strcmp(argv[1], "--generate") == 0)
+  {
+    return generate(strtoul(argv[2], nullptr, 10), argv[3]);
+  }
+
+  if (argc == 4 && strcmp(argv[1], "--encode") == 0)
+  {
+    return encode(argv[2], argv[3]);
+  }
+
+  if (argc == 3 && strcmp(argv[1], "--dump") == 0)
+  {
+    return dump(argv[2]);
+  }
+
+  ReplayConfig config;
+  int arg = 1;
+
+  for (; arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0; arg += 2)
+  {
+    const char *option = argv[arg];
+    const char *value = argv[arg + 1];
+
+    if (strcmp(option, "--cylinders") == 0)
+    {
+      config.cylindersPerAirflowSensor = atoi(value);
+    }
+    else if (strcmp(option, "--bore") == 0)
+    {
+      config.cylinderBoreCm = atof(value);
+    }
+    else if (strcmp(option, "--stroke") == 0)
+    {
+      config.cylinderStrokeCm = atof(value);
+    }
+    else if (strcmp(option, "--injector") == 0)
+    {
+      config.injectorFlowCcPerMin = atof(value);
+    }
+    else if (strcmp(option, "--lambda-table") == 0 || strcmp(option, "--advance-table") == 0)
+    {
+      ReplayTable &table = strcmp(option, "--lambda-table") == 0 ? lambdaTable : advanceTable;
+
+      if (!loadTable(value, table))
+      {
+        perror(value);
+        return 1;
+      }
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  if (argc - arg != 2)
+  {
+    return usage();
+  }
+
+  const char *inputPath = argv[arg];
+  const char *outputPath = argv[arg + 1];
+
+  MappedFile inputFile;
+  ReplayLogHeader header;
+
+  if (!inputFile.openRead(inputPath))
+  {
+    perror(inputPath);
+    return 1;
+  }
+
+  const ReplayInput *inputs;
+  std::vector<ReplayInput> datalogInputs;
+
+  if (memcmp(inputFile.data(), datalogMagic, sizeof(datalogMagic)) == 0)
+  {
+    if (!readDatalogInputs(inputFile, header.ticksPerSecond, datalogInputs))
+    {
+      fprintf(stderr, "%s: datalog has no CrankAngle and Maf channels to replay\n", inputPath);
+      return 1;
+    }
+
+    inputs = datalogInputs.data();
+    header.recordCount = datalogInputs.size();
+  }
+  else
+  {
+    inputs = replayRecords<ReplayInput>(inputFile, replayInputMagic, header);
+    if (!inputs)
+    {
+      fprintf(stderr, "%s: not a replay input log or datalog\n", inputPath);
+      return 1;
+    }
+  }
+
+  MappedFile outputFile;
+  if (!outputFile.create(outputPath, replayLogSize(sizeof(ReplayOutput), header.recordCount)))
+  {
+    perror(outputPath);
+    return 1;
+  }
+
+  ReplayOutput *outputs = initReplayLog<ReplayOutput>(outputFile, replayOutputMagic, header.ticksPerSecond, header.recordCount);
+
+  Replayer replayer(header.ticksPerSecond, config);
+
+  double start = secondsNow();
+  replayer.run(inputs, outputs, header.recordCount);
+  double elapsed = secondsNow() - start;
+
+  fprintf(stderr, "%lu events in %.3f s, %.1f M events/s\n",
+    static_cast<unsigned long>(header.recordCount), elapsed, header.recordCount / elapsed * 1e-6);
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+// Replay Log Format
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ENGINE_CALCULATIONS_TOOLS_REPLAY_LOG_H_
+#define ENGINE_CALCULATIONS_TOOLS_REPLAY_LOG_H_
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fault in mapped pages up front, not one at a time in the replay loop
+#ifdef MAP_POPULATE
+#define REPLAY_MAP_FLAGS MAP_POPULATE
+#else
+#define REPLAY_MAP_FLAGS 0
+#endif
+
+/*
+Replay logs are a header followed by fixed-size little-endian records, so a log can be
+memory-mapped and read in place. Input logs hold crank events with the sensor samples taken
+at them. Output logs hold what the calculators made of each input record, one for one.
+ */
+
+constexpr char replayInputMagic[4] = {'E', 'C', 'R', 'I'};
+constexpr char replayOutputMagic[4] = {'E', 'C', 'R', 'O'};
+constexpr uint16_t replayLogVersion = 1;
+
+struct ReplayLogHeader
+{
+  char magic[4];
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t ticksPerSecond;
+  uint32_t recordCount;
+};
+
+// One crank event
+struct ReplayInput
+{
+  uint32_t ticks;         // Timer ticks at the crank event
+  uint16_t crankAngle;    // Crank angle since the previous event, 1/16 degree
+  uint16_t maf;           // Airflow, 1/100 g/s
+  uint16_t map;           // Manifold pressure, 1/10 kPa
+  uint16_t tps;           // Throttle position, 1/10 percent
+  uint32_t reserved;
+};
+
+// Calculator outputs at one crank event. Zero for the first event, which has no crank speed.
+struct ReplayOutput
+{
+  uint32_t ticks;           // Timer ticks at the crank event
+  uint32_t injectionTicks;  // Injection length, timer ticks
+  uint16_t rpm;             // Engine speed, RPM
+  uint16_t load;            // Load, 1/10 percent
+  uint8_t lambda;           // Target lambda, 1/100
+  uint8_t advance;          // Spark advance, degrees BTDC
+  uint16_t reserved;
+};
+
+static_assert(sizeof(ReplayLogHeader) == 16, "Header must match the file format");
+static_assert(sizeof(ReplayInput) == 16, "Input record must match the file format");
+static_assert(sizeof(ReplayOutput) == 16, "Output record must match the file format");
+
+// Read-only or read-write mapping of a whole file
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  // Map an existing file to read. Returns false and sets errno on failure.
+  bool openRead(const char *path)
+  {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE | REPLAY_MAP_FLAGS, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == data)
+    {
+      return false;
+    }
+
+    // Logs are read front to back once
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    _data = static_cast<uint8_t *>(data);
+    _size = info.st_size;
+    return true;
+  }
+
+  // Create or truncate a file of size bytes and map it to write. Returns false and sets errno on failure.
+  bool create(const char *path, size_t size)
+  {
+    close();
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    if (ftruncate(fd, size) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | REPLAY_MAP_FLAGS, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == data)
+    {
+      return false;
+    }
+
+    _data = static_cast<uint8_t *>(data);
+    _size = size;
+    return true;
+  }
+
+  void close()
+  {
+    if (_data)
+    {
+      munmap(_data, _size);
+      _data = nullptr;
+      _size = 0;
+    }
+  }
+
+  uint8_t *data() const
+  {
+    return _data;
+  }
+
+  size_t size() const
+  {
+    return _size;
+  }
+
+private:
+  uint8_t *_data = nullptr;
+  size_t _size = 0;
+};
+
+// Records of a mapped log, or nullptr if the header doesn't match magic and Record
+template<typename Record>
+const Record *replayRecords(const MappedFile &file, const char (&magic)[4], ReplayLogHeader &outHeader)
+{
+  if (file.size() < sizeof(ReplayLogHeader))
+  {
+    return nullptr;
+  }
+
+  memcpy(&outHeader, file.data(), sizeof(ReplayLogHeader));
+
+  if (memcmp(outHeader.magic, magic, sizeof(outHeader.magic)) != 0
+    || outHeader.version != replayLogVersion
+    || outHeader.recordSize != sizeof(Record)
+    || file.size() < sizeof(ReplayLogHeader) + static_cast<size_t>(outHeader.recordCount) * sizeof(Record))
+  {
+    return nullptr;
+  }
+
+  return reinterpret_cast<const Record *>(file.data() + sizeof(ReplayLogHeader));
+}
+
+// Write the header of a log created with room for recordCount records, and return its records
+template<typename Record>
+Record *initReplayLog(MappedFile &file, const char (&magic)[4], uint32_t ticksPerSecond, uint32_t recordCount)
+{
+  ReplayLogHeader header;
+  memcpy(header.magic, magic, sizeof(header.magic));
+  header.version = replayLogVersion;
+  header.recordSize = sizeof(Record);
+  header.ticksPerSecond = ticksPerSecond;
+  header.recordCount = recordCount;
+
+  memcpy(file.data(), &header, sizeof(header));
+
+  return reinterpret_cast<Record *>(file.data() + sizeof(ReplayLogHeader));
+}
+
+constexpr size_t replayLogSize(size_t recordSize, uint32_t recordCount)
+{
+  return sizeof(ReplayLogHeader) + recordSize * recordCount;
+}
+
+#endif
@@ -0,0 +1,313 @@
+// Kernel Selection Generator
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Turns test_kernelTraits benchmark output into src/kernelSelection.h, which specializes
+// LinearKernelTraits and BilinearKernelTraits so each combination of types dispatches to the
+// kernel that was fastest on the target. Sections for other targets already in the header are
+// kept, so adding a target is running the benchmark on it and then this.
+//
+// The faster kernel wins. Ties go to fixed point, which doesn't pull in the float library.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 tools/selectKernels.cpp -o selectKernels
+//
+// Usage:
+//   pio test -e <env> -f test_kernelTraits | selectKernels [--target macro] src/kernelSelection.h
+//
+// The target is the predefined macro printed by the benchmark (KERNEL_TRAITS_TARGET), unless
+// --target gives one. Sections are tested in the order they were added, so add specific targets
+// before generic ones like __AVR_ARCH__.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Section
+{
+  std::string target;
+  std::vector<std::string> lines;
+};
+
+static const char *const sectionStart = "// target ";
+static const char *const sectionsEnd = "// end targets";
+
+static const char *typeFor(const std::string &name)
+{
+  static const char *const names[][2] = {
+    {"u8", "uint8_t"}, {"u16", "uint16_t"}, {"u32", "uint32_t"},
+    {"i8", "int8_t"}, {"i16", "int16_t"}, {"i32", "int32_t"},
+  };
+
+  for (const auto &entry : names)
+  {
+    if (name == entry[0])
+    {
+      return entry[1];
+    }
+  }
+
+  return nullptr;
+}
+
+// Reads "kernel ..." lines into a section. Returns false if there were none with timings.
+static bool readBenchmark(std::istream &in, Section &section, std::string &target)
+{
+  std::string line;
+  bool timed = false;
+
+  while (std::getline(in, line))
+  {
+    size_t at = line.find("kernel ");
+    if (at == std::string::npos)
+    {
+      continue;
+    }
+
+    std::istringstream words(line.substr(at + 7));
+    std::string kind;
+    words >> kind;
+
+    if (kind == "target")
+    {
+      std::string printed;
+      words >> printed;
+      if (target.empty())
+      {
+        target = printed;
+      }
+      continue;
+    }
+
+    size_t typeCount = kind == "linear" ? 2 : kind == "bilinear" ? 3 : 0;
+    if (typeCount == 0)
+    {
+      continue;
+    }
+
+    std::vector<std::string> types(typeCount);
+    std::string fixedLabel, floatLabel;
+    unsigned long fixedTicks = 0, floatTicks = 0;
+
+    for (std::string &type : types)
+    {
+      std::string name;
+      words >> name;
+      const char *full = typeFor(name);
+      if (!full)
+      {
+        fprintf(stderr, "unknown type %s in: %s\n", name.c_str(), line.c_str());
+        return false;
+      }
+      type = full;
+    }
+
+    if (!(words >> fixedLabel >> fixedTicks >> floatLabel >> floatTicks) || fixedLabel != "fixed" || floatLabel != "float")
+    {
+      fprintf(stderr, "can't read: %s\n", line.c_str());
+      return false;
+    }
+
+    timed = timed || fixedTicks > 0 || floatTicks > 0;
+
+    std::string arguments = types[0];
+    for (size_t i = 1; i < types.size(); i++)
+    {
+      arguments += ", " + types[i];
+    }
+
+    char comment[96];
+    snprintf(comment, sizeof(comment), "  // Fixed point %lu ticks, float %lu", fixedTicks, floatTicks);
+
+    section.lines.push_back("template<>");
+    section.lines.push_back(std::string("struct ") + (typeCount == 2 ? "Linear" : "Bilinear") + "KernelTraits<" + arguments + ">");
+    section.lines.push_back("{");
+    section.lines.push_back(comment);
+    section.lines.push_back(std::string("  static constexpr InterpolationKernel kernel = InterpolationKernel::")
+      + (floatTicks < fixedTicks ? "Float" : "FixedPoint") + ";");
+    section.lines.push_back("};");
+    section.lines.push_back("");
+  }
+
+  if (!timed)
+  {
+    fprintf(stderr, "no timings: run the benchmark on a target with a cycle counter\n");
+  }
+
+  return timed;
+}
+
+// Sections already in the header, in order
+static std::vector<Section> readHeader(const char *path)
+{
+  std::vector<Section> sections;
+  std::ifstream in(path);
+  std::string line;
+  bool inSection = false;
+
+  while (std::getline(in, line))
+  {
+    if (line.compare(0, strlen(sectionStart), sectionStart) == 0)
+    {
+      Section section;
+      section.target = line.substr(strlen(sectionStart));
+      sections.push_back(section);
+      inSection = true;
+
+      // Skip the #if or #elif
+      std::getline(in, line);
+    }
+    else if (line == sectionsEnd)
+    {
+      inSection = false;
+    }
+    else if (inSection)
+    {
+      sections.back().lines.push_back(line);
+    }
+  }
+
+  return sections;
+}
+
+static bool writeHeader(const char *path, const std::vector<Section> &sections)
+{
+  FILE *out = fopen(path, "w");
+  if (!out)
+  {
+    perror(path);
+    return false;
+  }
+
+  fputs(
+    "// Kernel Selection\n"
+    "// Copyright (C) 2023  Joshua Booth\n"
+    "\n"
+    "// This program is free software: you can redistribute it and/or modify\n"
+    "// it under the terms of the GNU General Public License as published by\n"
+    "// the Free Software Foundation, either version 3 of the License, or\n"
+    "// (at your option) any later version.\n"
+    "\n"
+    "// This program is distributed in the hope that it will be useful,\n"
+    "// but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+    "// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+    "// GNU General Public License for more details.\n"
+    "\n"
+    "// You should have received a copy of the GNU General Public License\n"
+    "// along with this program.  If not, see <https://www.gnu.org/licenses/>.\n"
+    "\n"
+    "// Generated by tools/selectKernels from test_kernelTraits output. Regenerate rather than edit.\n"
+    "// Included by kernelTraits.h.\n"
+    "\n"
+    "#ifndef ENGINE_CALCULATIONS_KERNEL_SELECTION_H_\n"
+    "#define ENGINE_CALCULATIONS_KERNEL_SELECTION_H_\n"
+    "\n"
+    "#pragma once\n"
+    "\n", out);
+
+  for (size_t i = 0; i < sections.size(); i++)
+  {
+    fprintf(out, "%s%s\n", sectionStart, sections[i].target.c_str());
+    fprintf(out, "#%s defined(%s)\n", i == 0 ? "if" : "elif", sections[i].target.c_str());
+
+    for (const std::string &line : sections[i].lines)
+    {
+      fprintf(out, "%s\n", line.c_str());
+    }
+  }
+
+  if (!sections.empty())
+  {
+    fprintf(out, "%s\n#endif\n\n", sectionsEnd);
+  }
+
+  fputs("#endif\n", out);
+  return fclose(out) == 0;
+}
+
+int main(int argc, char **argv)
+{
+  std::string target;
+  const char *path = nullptr;
+
+  for (int arg = 1; arg < argc; arg++)
+  {
+    if (strcmp(argv[arg], "--target") == 0 && arg + 1 < argc)
+    {
+      target = argv[++arg];
+    }
+    else if (argv[arg][0] != '-' && !path)
+    {
+      path = argv[arg];
+    }
+    else
+    {
+      path = nullptr;
+      break;
+    }
+  }
+
+  if (!path)
+  {
+    fprintf(stderr, "usage: selectKernels [--target macro] kernelSelection.h < benchmark output\n");
+    return 2;
+  }
+
+  Section section;
+  if (!readBenchmark(std::cin, section, target))
+  {
+    return 1;
+  }
+
+  if (target.empty())
+  {
+    fprintf(stderr, "the benchmark didn't print a target: pass --target\n");
+    return 1;
+  }
+
+  section.target = target;
+
+  std::vector<Section> sections = readHeader(path);
+  bool replaced = false;
+
+  for (Section &existing : sections)
+  {
+    if (existing.target == target)
+    {
+      existing = section;
+      replaced = true;
+    }
+  }
+
+  if (!replaced)
+  {
+    sections.push_back(section);
+  }
+
+  if (!writeHeader(path, sections))
+  {
+    return 1;
+  }
+
+  fprintf(stderr, "%s %s in %s\n", replaced ? "replaced" : "added", target.c_str(), path);
+  return 0;
+}
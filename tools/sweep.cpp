@@ -0,0 +1,553 @@
+// Engine Configuration Sweep
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Evaluates LoadFractionCalculator and InjectionLengthCalculator for every combination of
+// bore, stroke, injector flow and cylinder count, over a grid of RPM and airflow, and reduces
+// each combination to the numbers a design study needs: highest injector duty cycle, shortest
+// pulse and highest load, over operating points up to a load limit.
+//
+// Combinations are split evenly between worker threads, and a worker that runs out steals half
+// of the largest remaining range of another. Ranges are claimed with a compare-and-swap on a
+// packed begin and end, so there are no locks, and every result goes to its own slot, so there
+// is nothing to merge but each worker's summary at the end.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc tools/sweep.cpp src/*.cpp -o sweep
+//
+// Usage:
+//   sweep [options] > results.csv
+//
+// Ranges are first:last:step, inclusive.
+//   --bore cm             (7:10:0.25)
+//   --stroke cm           (7:10:0.25)
+//   --injector cc/min     (200:1000:20)
+//   --cylinders n         Cylinders per airflow sensor (1:8:1)
+//   --rpm rpm             (800:8000:100)
+//   --maf g/s             (2:400:2)
+//   --lambda l            Target lambda (0.85)
+//   --max-load fraction   Skip operating points above this load (1.2)
+//   --threads n           Worker threads (all cores)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "EngineCalculations.h"
+
+// The calculators only use ticks as a unit, so any rate works
+constexpr float ticksPerSecond = 1000000;
+
+struct SweepRange
+{
+  double first;
+  double last;
+  double step;
+
+  uint32_t count() const
+  {
+    return step > 0 && last >= first ? static_cast<uint32_t>(floor((last - first) / step + 1e-9)) + 1 : 0;
+  }
+
+  double operator[](uint32_t index) const
+  {
+    return first + step * index;
+  }
+};
+
+struct SweepConfig
+{
+  SweepRange bore = {7, 10, 0.25};
+  SweepRange stroke = {7, 10, 0.25};
+  SweepRange injector = {200, 1000, 20};
+  SweepRange cylinders = {1, 8, 1};
+  SweepRange rpm = {800, 8000, 100};
+  SweepRange maf = {2, 400, 2};
+  float lambda = 0.85;
+  float maxLoad = 1.2;
+};
+
+// Reduction of one combination over the operating grid
+struct SweepResult
+{
+  float maxDutyCycle;
+  float minPulseMicroseconds;
+  float maxLoad;
+  uint32_t points;
+};
+
+// One worker's reduction over all its combinations, padded so workers don't share cache lines
+struct alignas(64) SweepSummary
+{
+  float maxDutyCycle = 0;
+  uint32_t maxDutyCycleIndex = 0;
+  float minPulseMicroseconds = INFINITY;
+  uint32_t minPulseIndex = 0;
+  uint64_t points = 0;
+  uint32_t combinations = 0;
+  uint32_t steals = 0;
+};
+
+// Range of combinations [begin, end) in one word, so owner and thieves claim with one CAS
+class alignas(64) WorkRange
+{
+public:
+  void reset(uint32_t begin, uint32_t end)
+  {
+    _range.store(pack(begin, end));
+  }
+
+  // Owner takes up to count from the front. Returns false when empty.
+  bool take(uint32_t count, uint32_t &outBegin, uint32_t &outEnd)
+  {
+    uint64_t range = _range.load();
+
+    for (;;)
+    {
+      uint32_t begin = beginOf(range);
+      uint32_t end = endOf(range);
+
+      if (begin >= end)
+      {
+        return false;
+      }
+
+      uint32_t taken = end - begin < count ? end : begin + count;
+
+      if (_range.compare_exchange_weak(range, pack(taken, end)))
+      {
+        outBegin = begin;
+        outEnd = taken;
+        return true;
+      }
+    }
+  }
+
+  // Thief takes the back half. Returns false when too little is left to split.
+  bool steal(uint32_t &outBegin, uint32_t &outEnd)
+  {
+    uint64_t range = _range.load();
+
+    for (;;)
+    {
+      uint32_t begin = beginOf(range);
+      uint32_t end = endOf(range);
+
+      if (end - begin < 2 || begin >= end)
+      {
+        return false;
+      }
+
+      uint32_t middle = begin + (end - begin) / 2;
+
+      if (_range.compare_exchange_weak(range, pack(begin, middle)))
+      {
+        outBegin = middle;
+        outEnd = end;
+        return true;
+      }
+    }
+  }
+
+  uint32_t remaining() const
+  {
+    uint64_t range = _range.load(std::memory_order_relaxed);
+    return beginOf(range) < endOf(range) ? endOf(range) - beginOf(range) : 0;
+  }
+
+private:
+  static uint64_t pack(uint32_t begin, uint32_t end)
+  {
+    return static_cast<uint64_t>(begin) << 32 | end;
+  }
+
+  static uint32_t beginOf(uint64_t range)
+  {
+    return static_cast<uint32_t>(range >> 32);
+  }
+
+  static uint32_t endOf(uint64_t range)
+  {
+    return static_cast<uint32_t>(range);
+  }
+
+  std::atomic<uint64_t> _range;
+};
+
+class Sweep
+{
+public:
+  // Combinations a worker takes from its own range at a time
+  static constexpr uint32_t batchSize = 16;
+
+  Sweep(const SweepConfig &config, unsigned workerCount)
+    : _config(config),
+      _boreCount(config.bore.count()),
+      _strokeCount(config.stroke.count()),
+      _injectorCount(config.injector.count()),
+      _cylinderCount(config.cylinders.count()),
+      _combinationCount(_boreCount * _strokeCount * _injectorCount * _cylinderCount),
+      _results(_combinationCount),
+      _summaries(workerCount),
+      _ranges(workerCount)
+  {
+    // Everything about the grid that doesn't depend on the engine, computed once
+    for (uint32_t i = 0; i < config.rpm.count(); i++)
+    {
+      float rpm = config.rpm[i];
+
+      // RPM * 360 degrees / 60 seconds = degrees/second
+      float inverseCrankSpeedTicksPerDegree = ticksPerSecond / (rpm * 6.0f);
+
+      _inverseCrankSpeeds.push_back(inverseCrankSpeedTicksPerDegree);
+      _cycleTicks.push_back(720.0f * inverseCrankSpeedTicksPerDegree);
+    }
+
+    for (uint32_t i = 0; i < config.maf.count(); i++)
+    {
+      _airflows.push_back(config.maf[i]);
+    }
+
+    // Stoichiometric fuel/air ratio of gasoline is 1/14.7
+    _targetFuelAirRatio = 1.0f / (14.7f * config.lambda);
+  }
+
+  uint32_t combinationCount() const
+  {
+    return _combinationCount;
+  }
+
+  void run()
+  {
+    unsigned workerCount = _ranges.size();
+
+    for (unsigned worker = 0; worker < workerCount; worker++)
+    {
+      _ranges[worker].reset(
+        static_cast<uint64_t>(_combinationCount) * worker / workerCount,
+        static_cast<uint64_t>(_combinationCount) * (worker + 1) / workerCount);
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned worker = 0; worker < workerCount; worker++)
+    {
+      threads.emplace_back(&Sweep::work, this, worker);
+    }
+
+    for (std::thread &thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  void combination(uint32_t index, double &outBore, double &outStroke, double &outInjector, int &outCylinders) const
+  {
+    outBore = _config.bore[index % _boreCount];
+    index /= _boreCount;
+    outStroke = _config.stroke[index % _strokeCount];
+    index /= _strokeCount;
+    outInjector = _config.injector[index % _injectorCount];
+    index /= _injectorCount;
+    outCylinders = static_cast<int>(_config.cylinders[index]);
+  }
+
+  const std::vector<SweepResult> &results() const
+  {
+    return _results;
+  }
+
+  const std::vector<SweepSummary> &summaries() const
+  {
+    return _summaries;
+  }
+
+private:
+  void work(unsigned worker)
+  {
+    SweepSummary summary;
+    uint32_t begin, end;
+
+    for (;;)
+    {
+      if (!_ranges[worker].take(batchSize, begin, end))
+      {
+        if (!steal(worker, begin, end))
+        {
+          break;
+        }
+
+        // Stolen work becomes this worker's own, so others can steal from it in turn
+        summary.steals++;
+        _ranges[worker].reset(begin, end);
+        continue;
+      }
+
+      for (uint32_t index = begin; index < end; index++)
+      {
+        evaluate(index, summary);
+      }
+    }
+
+    _summaries[worker] = summary;
+  }
+
+  bool steal(unsigned thief, uint32_t &outBegin, uint32_t &outEnd)
+  {
+    // Try the fullest victim first, so few steals balance the load
+    for (;;)
+    {
+      unsigned victim = thief;
+      uint32_t mostRemaining = 0;
+
+      for (unsigned worker = 0; worker < _ranges.size(); worker++)
+      {
+        uint32_t remaining = _ranges[worker].remaining();
+
+        if (worker != thief && remaining > mostRemaining)
+        {
+          victim = worker;
+          mostRemaining = remaining;
+        }
+      }
+
+      if (victim == thief)
+      {
+        return false;
+      }
+
+      if (_ranges[victim].steal(outBegin, outEnd))
+      {
+        return true;
+      }
+    }
+  }
+
+  void evaluate(uint32_t index, SweepSummary &summary)
+  {
+    double bore, stroke, injector;
+    int cylinders;
+    combination(index, bore, stroke, injector, cylinders);
+
+    LoadFractionCalculator loadCalculator(ticksPerSecond, cylinders, bore, stroke);
+    InjectionLengthCalculator injectionCalculator(ticksPerSecond, injector, cylinders);
+
+    SweepResult result = {0, INFINITY, 0, 0};
+
+    for (size_t rpmIndex = 0; rpmIndex < _inverseCrankSpeeds.size(); rpmIndex++)
+    {
+      float inverseCrankSpeedTicksPerDegree = _inverseCrankSpeeds[rpmIndex];
+      float inverseCycleTicks = 1.0f / _cycleTicks[rpmIndex];
+
+      // A batch of airflows at one speed. Load rises with airflow, so stop at the load limit.
+      for (float airflow : _airflows)
+      {
+        float load = loadCalculator(inverseCrankSpeedTicksPerDegree, airflow);
+
+        if (load > _config.maxLoad)
+        {
+          break;
+        }
+
+        float injectionTicks = injectionCalculator(_targetFuelAirRatio, inverseCrankSpeedTicksPerDegree, airflow);
+
+        result.maxDutyCycle = fmaxf(result.maxDutyCycle, injectionTicks * inverseCycleTicks);
+        result.minPulseMicroseconds = fminf(result.minPulseMicroseconds, injectionTicks * (1e6f / ticksPerSecond));
+        result.maxLoad = fmaxf(result.maxLoad, load);
+        result.points++;
+      }
+    }
+
+    _results[index] = result;
+
+    if (result.points > 0)
+    {
+      if (result.maxDutyCycle > summary.maxDutyCycle)
+      {
+        summary.maxDutyCycle = result.maxDutyCycle;
+        summary.maxDutyCycleIndex = index;
+      }
+
+      if (result.minPulseMicroseconds < summary.minPulseMicroseconds)
+      {
+        summary.minPulseMicroseconds = result.minPulseMicroseconds;
+        summary.minPulseIndex = index;
+      }
+    }
+
+    summary.points += result.points;
+    summary.combinations++;
+  }
+
+  const SweepConfig &_config;
+  uint32_t _boreCount;
+  uint32_t _strokeCount;
+  uint32_t _injectorCount;
+  uint32_t _cylinderCount;
+  uint32_t _combinationCount;
+  std::vector<float> _inverseCrankSpeeds;
+  std::vector<float> _cycleTicks;
+  std::vector<float> _airflows;
+  float _targetFuelAirRatio;
+  std::vector<SweepResult> _results;
+  std::vector<SweepSummary> _summaries;
+  std::vector<WorkRange> _ranges;
+};
+
+static bool parseRange(const char *text, SweepRange &out)
+{
+  return sscanf(text, "%lf:%lf:%lf", &out.first, &out.last, &out.step) == 3 && out.count() > 0;
+}
+
+static int usage()
+{
+  fprintf(stderr,
+    "usage: sweep [--bore a:b:step] [--stroke a:b:step] [--injector a:b:step] [--cylinders a:b:step]\n"
+    "             [--rpm a:b:step] [--maf a:b:step] [--lambda l] [--max-load f] [--threads n]\n");
+  return 2;
+}
+
+static double secondsNow()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  SweepConfig config;
+  unsigned threadCount = std::thread::hardware_concurrency();
+
+  for (int arg = 1; arg < argc; arg += 2)
+  {
+    const char *option = argv[arg];
+    const char *value = arg + 1 < argc ? argv[arg + 1] : nullptr;
+    bool ok = value != nullptr;
+
+    if (ok && strcmp(option, "--bore") == 0)
+    {
+      ok = parseRange(value, config.bore);
+    }
+    else if (ok && strcmp(option, "--stroke") == 0)
+    {
+      ok = parseRange(value, config.stroke);
+    }
+    else if (ok && strcmp(option, "--injector") == 0)
+    {
+      ok = parseRange(value, config.injector);
+    }
+    else if (ok && strcmp(option, "--cylinders") == 0)
+    {
+      ok = parseRange(value, config.cylinders);
+    }
+    else if (ok && strcmp(option, "--rpm") == 0)
+    {
+      ok = parseRange(value, config.rpm);
+    }
+    else if (ok && strcmp(option, "--maf") == 0)
+    {
+      ok = parseRange(value, config.maf);
+    }
+    else if (ok && strcmp(option, "--lambda") == 0)
+    {
+      config.lambda = atof(value);
+    }
+    else if (ok && strcmp(option, "--max-load") == 0)
+    {
+      config.maxLoad = atof(value);
+    }
+    else if (ok && strcmp(option, "--threads") == 0)
+    {
+      threadCount = atoi(value);
+    }
+    else
+    {
+      ok = false;
+    }
+
+    if (!ok)
+    {
+      return usage();
+    }
+  }
+
+  if (threadCount == 0)
+  {
+    threadCount = 1;
+  }
+
+  Sweep sweep(config, threadCount);
+
+  double start = secondsNow();
+  sweep.run();
+  double elapsed = secondsNow() - start;
+
+  printf("bore_cm,stroke_cm,injector_cc_min,cylinders,max_duty_cycle,min_pulse_us,max_load,points\n");
+
+  for (uint32_t index = 0; index < sweep.combinationCount(); index++)
+  {
+    const SweepResult &result = sweep.results()[index];
+    double bore, stroke, injector;
+    int cylinders;
+    sweep.combination(index, bore, stroke, injector, cylinders);
+
+    printf("%.3f,%.3f,%.1f,%d,%.4f,%.1f,%.3f,%u\n", bore, stroke, injector, cylinders,
+      result.maxDutyCycle, result.minPulseMicroseconds, result.maxLoad, result.points);
+  }
+
+  // Combine the workers' summaries
+  SweepSummary total;
+  for (const SweepSummary &summary : sweep.summaries())
+  {
+    if (summary.maxDutyCycle > total.maxDutyCycle)
+    {
+      total.maxDutyCycle = summary.maxDutyCycle;
+      total.maxDutyCycleIndex = summary.maxDutyCycleIndex;
+    }
+
+    if (summary.minPulseMicroseconds < total.minPulseMicroseconds)
+    {
+      total.minPulseMicroseconds = summary.minPulseMicroseconds;
+      total.minPulseIndex = summary.minPulseIndex;
+    }
+
+    total.points += summary.points;
+    total.combinations += summary.combinations;
+    total.steals += summary.steals;
+  }
+
+  double bore, stroke, injector;
+  int cylinders;
+
+  fprintf(stderr, "%u combinations, %llu operating points in %.3f s on %u threads (%u steals), %.1f M points/s\n",
+    total.combinations, static_cast<unsigned long long>(total.points), elapsed, threadCount, total.steals,
+    total.points / elapsed * 1e-6);
+
+  sweep.combination(total.maxDutyCycleIndex, bore, stroke, injector, cylinders);
+  fprintf(stderr, "Highest duty cycle %.3f: bore %.3f stroke %.3f injector %.1f cylinders %d\n",
+    total.maxDutyCycle, bore, stroke, injector, cylinders);
+
+  sweep.combination(total.minPulseIndex, bore, stroke, injector, cylinders);
+  fprintf(stderr, "Shortest pulse %.1f us: bore %.3f stroke %.3f injector %.1f cylinders %d\n",
+    total.minPulseMicroseconds, bore, stroke, injector, cylinders);
+
+  return 0;
+}
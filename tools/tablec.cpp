@@ -0,0 +1,634 @@
+// Table Compiler
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Compiles a float calibration table into the smallest fixed-point arrays that stay within an
+// error bound, and writes them as a C++ header.
+//
+// Every combination of unsigned 8/16-bit scales and 8/16-bit cells (signed if any cell is
+// negative) is tried, each with as many fractional bits as its range allows. Each is checked
+// against a double-precision reference over a dense grid of inputs, spread over all cores, using
+// the same interpolateLinearTable()/interpolateBilinearTable() specializations the ECU will run,
+// with inputs rounded to the scale's fixed-point format the way the ECU must. The smallest one
+// within the bound wins, then the most accurate.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc tools/tablec.cpp src/*.cpp -o tablec
+//
+// Usage:
+//   tablec [--progmem] [--grid n] [--threads n] calibration.txt > table.h
+//
+// Calibration files are whitespace-separated. Lines starting with # are comments.
+//   name veTable          C++ name prefix
+//   error 0.5             Largest allowed absolute error, in cell units
+//   x 500 1000 ...        x scale, ascending and not negative
+//   y 10 20 ...           y scale, for 2D tables only
+//   z                     Cells follow, row by row (x varies fastest)
+//   60 62 ...
+//
+// A scale or cell with s fractional bits stores round(value * 2^s). s can be negative, to fit
+// a range like 0-8000 RPM in 8 bits. The header gives s for each array, so callers convert
+// their inputs the same way and scale the output back.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EngineCalculations.h"
+
+template<typename T> struct TypeName;
+template<> struct TypeName<uint8_t> { static constexpr const char *value = "uint8_t"; };
+template<> struct TypeName<uint16_t> { static constexpr const char *value = "uint16_t"; };
+template<> struct TypeName<int8_t> { static constexpr const char *value = "int8_t"; };
+template<> struct TypeName<int16_t> { static constexpr const char *value = "int16_t"; };
+
+constexpr int minFractionBits = -16;
+constexpr int maxFractionBits = 24;
+
+struct Calibration
+{
+  std::string name;
+  double maxError = -1;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+
+  bool is2D() const
+  {
+    return !y.empty();
+  }
+};
+
+// One array's fixed-point format and values, as text for the header
+struct ArrayFormat
+{
+  const char *type;
+  int fractionBits;
+  std::string values;
+};
+
+struct Candidate
+{
+  bool valid = false;
+  double maxError = INFINITY;
+  double meanError = 0;
+  double worstX = 0;
+  double worstY = 0;
+  size_t bytes = 0;
+  ArrayFormat x;
+  ArrayFormat y;
+  ArrayFormat z;
+};
+
+struct VerifyOptions
+{
+  uint32_t gridSize;
+  unsigned threads;
+};
+
+// Most fractional bits that fit values from low to high into T, or false if none do
+template<typename T>
+bool fractionBitsFor(double low, double high, int &outBits)
+{
+  for (int bits = maxFractionBits; bits >= minFractionBits; bits--)
+  {
+    if (floor(ldexp(high, bits) + 0.5) <= IntegerLimits<T>::max && floor(ldexp(low, bits) + 0.5) >= IntegerLimits<T>::min)
+    {
+      outBits = bits;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Round a value to T with bits fractional bits, saturating like an ECU converting a sensor reading
+template<typename T>
+T toFixed(double value, int bits)
+{
+  double scaled = floor(ldexp(value, bits) + 0.5);
+  return scaled > IntegerLimits<T>::max ? IntegerLimits<T>::max
+    : scaled < IntegerLimits<T>::min ? IntegerLimits<T>::min
+    : static_cast<T>(scaled);
+}
+
+// Quantize values. Fails if they don't fit, or if a scale would lose its order.
+template<typename T>
+bool quantize(const std::vector<double> &values, bool isScale, std::vector<T> &out, ArrayFormat &outFormat)
+{
+  double low = values[0], high = values[0];
+  for (double value : values)
+  {
+    low = fmin(low, value);
+    high = fmax(high, value);
+  }
+
+  int bits;
+  if (!fractionBitsFor<T>(low, high, bits))
+  {
+    return false;
+  }
+
+  out.clear();
+  outFormat.type = TypeName<T>::value;
+  outFormat.fractionBits = bits;
+  outFormat.values.clear();
+
+  for (double value : values)
+  {
+    T fixed = toFixed<T>(value, bits);
+
+    if (isScale && !out.empty() && fixed <= out.back())
+    {
+      return false;
+    }
+
+    out.push_back(fixed);
+    outFormat.values += (outFormat.values.empty() ? "" : ", ") + std::to_string(static_cast<long>(fixed));
+  }
+
+  return true;
+}
+
+// Index of the segment of scale around value, and how far along it, clamped like findOnScale()
+static void locate(const std::vector<double> &scale, double value, size_t &outIndex, double &outWeight)
+{
+  if (value <= scale.front())
+  {
+    outIndex = 0;
+    outWeight = 0;
+    return;
+  }
+
+  if (value >= scale.back())
+  {
+    outIndex = scale.size() - 2;
+    outWeight = 1;
+    return;
+  }
+
+  size_t index = 0;
+  while (scale[index + 1] < value)
+  {
+    index++;
+  }
+
+  outIndex = index;
+  outWeight = (value - scale[index]) / (scale[index + 1] - scale[index]);
+}
+
+static double reference(const Calibration &calibration, double x, double y)
+{
+  size_t xIndex, yIndex = 0;
+  double xWeight, yWeight = 0;
+  size_t xLength = calibration.x.size();
+
+  locate(calibration.x, x, xIndex, xWeight);
+
+  if (!calibration.is2D())
+  {
+    return calibration.z[xIndex] * (1 - xWeight) + calibration.z[xIndex + 1] * xWeight;
+  }
+
+  locate(calibration.y, y, yIndex, yWeight);
+
+  const double *row0 = &calibration.z[yIndex * xLength];
+  const double *row1 = row0 + xLength;
+
+  return (row0[xIndex] * (1 - xWeight) + row0[xIndex + 1] * xWeight) * (1 - yWeight)
+    + (row1[xIndex] * (1 - xWeight) + row1[xIndex + 1] * xWeight) * yWeight;
+}
+
+// Grid inputs run a little past both ends of the scale, to check clamping too
+static double gridValue(const std::vector<double> &scale, uint32_t index, uint32_t gridSize)
+{
+  double margin = 0.05 * (scale.back() - scale.front());
+  double low = fmax(0.0, scale.front() - margin);
+  double high = scale.back() + margin;
+  return low + (high - low) * index / (gridSize - 1);
+}
+
+// Compare a compiled table to the reference over the grid. lookup(x, y) returns the compiled
+// output, scaled back to cell units.
+template<typename Lookup>
+void verify(const Calibration &calibration, const VerifyOptions &options, Lookup lookup, Candidate &candidate)
+{
+  struct alignas(64) Partial
+  {
+    double maxError = 0;
+    double sumError = 0;
+    double worstX = 0;
+    double worstY = 0;
+  };
+
+  uint32_t rows = calibration.is2D() ? options.gridSize : 1;
+  uint32_t columns = options.gridSize;
+  std::vector<Partial> partials(options.threads);
+  std::vector<std::thread> threads;
+  std::atomic<uint32_t> nextRow(0);
+
+  for (unsigned t = 0; t < options.threads; t++)
+  {
+    threads.emplace_back([&, t]() {
+      Partial &partial = partials[t];
+
+      for (uint32_t row = nextRow++; row < rows; row = nextRow++)
+      {
+        double y = calibration.is2D() ? gridValue(calibration.y, row, rows) : 0;
+
+        for (uint32_t column = 0; column < columns; column++)
+        {
+          double x = gridValue(calibration.x, column, columns);
+          double error = fabs(lookup(x, y) - reference(calibration, x, y));
+
+          partial.sumError += error;
+          if (error > partial.maxError)
+          {
+            partial.maxError = error;
+            partial.worstX = x;
+            partial.worstY = y;
+          }
+        }
+      }
+    });
+  }
+
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  candidate.maxError = 0;
+  candidate.meanError = 0;
+
+  for (const Partial &partial : partials)
+  {
+    if (partial.maxError >= candidate.maxError)
+    {
+      candidate.maxError = partial.maxError;
+      candidate.worstX = partial.worstX;
+      candidate.worstY = partial.worstY;
+    }
+
+    candidate.meanError += partial.sumError;
+  }
+
+  candidate.meanError /= static_cast<double>(rows) * columns;
+}
+
+template<typename X, typename Z>
+Candidate compileLinear(const Calibration &calibration, const VerifyOptions &options)
+{
+  Candidate candidate;
+  std::vector<X> xScale;
+  std::vector<Z> cells;
+
+  if (!quantize(calibration.x, true, xScale, candidate.x) || !quantize(calibration.z, false, cells, candidate.z))
+  {
+    return candidate;
+  }
+
+  int xBits = candidate.x.fractionBits;
+  int zBits = candidate.z.fractionBits;
+
+  verify(calibration, options, [&](double x, double) {
+    Z output = interpolateLinearTable<Z>(toFixed<X>(x, xBits), xScale.size(), xScale.data(), cells.data());
+    return ldexp(static_cast<double>(output), -zBits);
+  }, candidate);
+
+  candidate.valid = true;
+  candidate.bytes = xScale.size() * sizeof(X) + cells.size() * sizeof(Z);
+  return candidate;
+}
+
+template<typename X, typename Y, typename Z>
+Candidate compileBilinear(const Calibration &calibration, const VerifyOptions &options)
+{
+  Candidate candidate;
+  std::vector<X> xScale;
+  std::vector<Y> yScale;
+  std::vector<Z> cells;
+
+  if (!quantize(calibration.x, true, xScale, candidate.x) || !quantize(calibration.y, true, yScale, candidate.y)
+    || !quantize(calibration.z, false, cells, candidate.z))
+  {
+    return candidate;
+  }
+
+  int xBits = candidate.x.fractionBits;
+  int yBits = candidate.y.fractionBits;
+  int zBits = candidate.z.fractionBits;
+
+  verify(calibration, options, [&](double x, double y) {
+    Z output = interpolateBilinearTable<Z>(toFixed<X>(x, xBits), toFixed<Y>(y, yBits),
+      xScale.size(), yScale.size(), xScale.data(), yScale.data(), cells.data());
+    return ldexp(static_cast<double>(output), -zBits);
+  }, candidate);
+
+  candidate.valid = true;
+  candidate.bytes = xScale.size() * sizeof(X) + yScale.size() * sizeof(Y) + cells.size() * sizeof(Z);
+  return candidate;
+}
+
+template<typename Z>
+void compileAll(const Calibration &calibration, const VerifyOptions &options, std::vector<Candidate> &out)
+{
+  if (calibration.is2D())
+  {
+    out.push_back(compileBilinear<uint8_t, uint8_t, Z>(calibration, options));
+    out.push_back(compileBilinear<uint8_t, uint16_t, Z>(calibration, options));
+    out.push_back(compileBilinear<uint16_t, uint8_t, Z>(calibration, options));
+    out.push_back(compileBilinear<uint16_t, uint16_t, Z>(calibration, options));
+  }
+  else
+  {
+    out.push_back(compileLinear<uint8_t, Z>(calibration, options));
+    out.push_back(compileLinear<uint16_t, Z>(calibration, options));
+  }
+}
+
+static bool readCalibration(const char *path, Calibration &out)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    perror(path);
+    return false;
+  }
+
+  std::vector<double> *values = nullptr;
+  char word[256];
+
+  while (fscanf(file, "%255s", word) == 1)
+  {
+    if (word[0] == '#')
+    {
+      int c;
+      while ((c = fgetc(file)) != EOF && c != '\n')
+      {
+      }
+    }
+    else if (strcmp(word, "name") == 0 && fscanf(file, "%255s", word) == 1)
+    {
+      out.name = word;
+    }
+    else if (strcmp(word, "error") == 0 && fscanf(file, "%lf", &out.maxError) == 1)
+    {
+    }
+    else if (strcmp(word, "x") == 0)
+    {
+      values = &out.x;
+    }
+    else if (strcmp(word, "y") == 0)
+    {
+      values = &out.y;
+    }
+    else if (strcmp(word, "z") == 0)
+    {
+      values = &out.z;
+    }
+    else
+    {
+      char *end;
+      double value = strtod(word, &end);
+
+      if (!values || *end != '\0')
+      {
+        fprintf(stderr, "%s: unexpected '%s'\n", path, word);
+        fclose(file);
+        return false;
+      }
+
+      values->push_back(value);
+    }
+  }
+
+  fclose(file);
+
+  size_t rows = out.is2D() ? out.y.size() : 1;
+  bool ascending = true;
+  for (size_t i = 1; i < out.x.size(); i++)
+  {
+    ascending = ascending && out.x[i] > out.x[i - 1];
+  }
+  for (size_t i = 1; i < out.y.size(); i++)
+  {
+    ascending = ascending && out.y[i] > out.y[i - 1];
+  }
+
+  if (out.name.empty() || out.maxError < 0 || out.x.size() < 2 || (out.is2D() && out.y.size() < 2)
+    || out.z.size() != out.x.size() * rows || !ascending || out.x[0] < 0 || (out.is2D() && out.y[0] < 0))
+  {
+    fprintf(stderr, "%s: needs name, error, ascending non-negative x (and y) scales of 2 or more, "
+      "and a cell for each point\n", path);
+    return false;
+  }
+
+  return true;
+}
+
+static void writeArray(const char *name, const char *suffix, const ArrayFormat &format, size_t length, bool progmem)
+{
+  printf("// round(value * 2^%d)\n", format.fractionBits);
+  printf("constexpr int8_t %s%sFractionBits = %d;\n", name, suffix, format.fractionBits);
+  printf("const %s %s%s[%zu]%s = {%s};\n\n", format.type, name, suffix, length, progmem ? " PROGMEM" : "",
+    format.values.c_str());
+}
+
+static void writeHeader(const Calibration &calibration, const Candidate &candidate, const VerifyOptions &options, bool progmem)
+{
+  const char *name = calibration.name.c_str();
+  size_t xLength = calibration.x.size();
+  size_t yLength = calibration.y.size();
+  uint64_t points = static_cast<uint64_t>(options.gridSize) * (calibration.is2D() ? options.gridSize : 1);
+
+  printf("// %s, generated by tablec. Do not edit.\n", name);
+  printf("// %zu bytes. Error against the float calibration over %llu points: max %g, mean %g.\n\n",
+    candidate.bytes, static_cast<unsigned long long>(points), candidate.maxError, candidate.meanError);
+  printf("#pragma once\n\n");
+  printf("#include \"EngineCalculations.h\"\n\n");
+
+  writeArray(name, "XScale", candidate.x, xLength, progmem);
+
+  if (calibration.is2D())
+  {
+    writeArray(name, "YScale", candidate.y, yLength, progmem);
+  }
+
+  writeArray(name, "Cells", candidate.z, calibration.z.size(), progmem);
+
+  // Array accessors for the lookup
+  const char *open = progmem ? "ProgmemArray<" : "";
+  const char *close = progmem ? ">" : "";
+
+  if (calibration.is2D())
+  {
+    printf("// Inputs and output in the fixed-point formats above\n");
+    printf("inline %s %sLookup(%s x, %s y)\n{\n", candidate.z.type, name, candidate.x.type, candidate.y.type);
+    printf("  return interpolateBilinearTable<%s>(x, y, %zu, %zu,\n", candidate.z.type, xLength, yLength);
+    if (progmem)
+    {
+      printf("    %s%s%s(%sXScale), %s%s%s(%sYScale), %s%s%s(%sCells));\n",
+        open, candidate.x.type, close, name, open, candidate.y.type, close, name, open, candidate.z.type, close, name);
+    }
+    else
+    {
+      printf("    %sXScale, %sYScale, %sCells);\n", name, name, name);
+    }
+  }
+  else
+  {
+    printf("// Input and output in the fixed-point formats above\n");
+    printf("inline %s %sLookup(%s x)\n{\n", candidate.z.type, name, candidate.x.type);
+    printf("  return interpolateLinearTable<%s>(x, %zu,\n", candidate.z.type, xLength);
+    if (progmem)
+    {
+      printf("    %s%s%s(%sXScale), %s%s%s(%sCells));\n",
+        open, candidate.x.type, close, name, open, candidate.z.type, close, name);
+    }
+    else
+    {
+      printf("    %sXScale, %sCells);\n", name, name);
+    }
+  }
+
+  printf("}\n");
+}
+
+static int usage()
+{
+  fprintf(stderr, "usage: tablec [--progmem] [--grid n] [--threads n] calibration.txt > table.h\n");
+  return 2;
+}
+
+int main(int argc, char **argv)
+{
+  bool progmem = false;
+  VerifyOptions options = {0, std::thread::hardware_concurrency()};
+  int arg = 1;
+
+  for (; arg < argc - 1 && strncmp(argv[arg], "--", 2) == 0; arg++)
+  {
+    if (strcmp(argv[arg], "--progmem") == 0)
+    {
+      progmem = true;
+    }
+    else if (strcmp(argv[arg], "--grid") == 0 && arg + 2 < argc)
+    {
+      options.gridSize = atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--threads") == 0 && arg + 2 < argc)
+    {
+      options.threads = atoi(argv[++arg]);
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  if (argc - arg != 1)
+  {
+    return usage();
+  }
+
+  Calibration calibration;
+  if (!readCalibration(argv[arg], calibration))
+  {
+    return 1;
+  }
+
+  if (options.gridSize < 2)
+  {
+    options.gridSize = calibration.is2D() ? 1024 : 65536;
+  }
+
+  if (options.threads == 0)
+  {
+    options.threads = 1;
+  }
+
+  bool negative = false;
+  for (double value : calibration.z)
+  {
+    negative = negative || value < 0;
+  }
+
+  std::vector<Candidate> candidates;
+
+  if (negative)
+  {
+    compileAll<int8_t>(calibration, options, candidates);
+    compileAll<int16_t>(calibration, options, candidates);
+  }
+  else
+  {
+    compileAll<uint8_t>(calibration, options, candidates);
+    compileAll<uint16_t>(calibration, options, candidates);
+  }
+
+  const Candidate *best = nullptr;
+  const Candidate *closest = nullptr;
+
+  for (const Candidate &candidate : candidates)
+  {
+    if (!candidate.valid)
+    {
+      continue;
+    }
+
+    fprintf(stderr, "x %-8s y %-8s z %-8s %6zu bytes  max error %-10g mean %g\n", candidate.x.type,
+      calibration.is2D() ? candidate.y.type : "-", candidate.z.type, candidate.bytes,
+      candidate.maxError, candidate.meanError);
+
+    if (!closest || candidate.maxError < closest->maxError)
+    {
+      closest = &candidate;
+    }
+
+    if (candidate.maxError <= calibration.maxError
+      && (!best || candidate.bytes < best->bytes
+        || (candidate.bytes == best->bytes && candidate.maxError < best->maxError)))
+    {
+      best = &candidate;
+    }
+  }
+
+  if (!best)
+  {
+    if (closest)
+    {
+      fprintf(stderr, "No format within %g. Closest is %g, worst at x %g y %g.\n", calibration.maxError,
+        closest->maxError, closest->worstX, closest->worstY);
+    }
+    else
+    {
+      fprintf(stderr, "No format fits the calibration's ranges\n");
+    }
+
+    return 1;
+  }
+
+  writeHeader(calibration, *best, options, progmem);
+
+  return 0;
+}
@@ -0,0 +1,655 @@
+// Fixed-Point Kernel Verifier
+// Copyright (C) 2023  Joshua Booth
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Checks the fixed-point kernels against a long double reference over dense sweeps of their
+// input spaces, on all cores, and reports the largest and mean error of each, where the largest
+// happened, and how many results were out of range: outside the outputs being interpolated or
+// smoothed, by more than rounding, which is what an overflow looks like.
+//
+//   interpolateLinear     every specialization. 8-bit inputs sweep every segment and every
+//                         input in it; wider inputs sweep segments between dense sets of values.
+//                         Outputs are extremes, midpoints and random pairs.
+//   interpolateBilinear   every specialization, on random cells with extremes mixed in
+//   expSmooth             each accumulator expSmooth() picks, with the 24-bit one emulated as
+//                         on AVR, over every value and alpha for small domains
+//   calculateAlphaFixedFromTime  against 1 - exp(-deltaTime / timeConstant)
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc tools/verify.cpp src/*.cpp -o verify
+//
+// Usage:
+//   verify [--threads n] [--samples n] [filter]
+//
+// filter runs only kernels whose name contains it. --samples sets random samples per bilinear
+// kernel (16M). Exits with 1 if any result was out of range.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EngineCalculations.h"
+
+// Unsigned 24-bit arithmetic that wraps like __uint24 on AVR, so its overflows show up on a host
+struct Wrap24
+{
+  uint32_t value;
+
+  constexpr Wrap24(uint32_t v = 0) : value(v & 0xFFFFFFu) {}
+
+  template<typename T>
+  constexpr explicit operator T() const
+  {
+    return static_cast<T>(value);
+  }
+
+  friend constexpr Wrap24 operator+(Wrap24 a, Wrap24 b) { return Wrap24(a.value + b.value); }
+  friend constexpr Wrap24 operator*(Wrap24 a, Wrap24 b) { return Wrap24(a.value * b.value); }
+  friend constexpr Wrap24 operator/(Wrap24 a, Wrap24 b) { return Wrap24(a.value / b.value); }
+};
+
+template<typename T> struct TypeName;
+template<> struct TypeName<uint8_t> { static constexpr const char *value = "u8"; };
+template<> struct TypeName<uint16_t> { static constexpr const char *value = "u16"; };
+template<> struct TypeName<uint32_t> { static constexpr const char *value = "u32"; };
+template<> struct TypeName<int8_t> { static constexpr const char *value = "i8"; };
+template<> struct TypeName<int16_t> { static constexpr const char *value = "i16"; };
+template<> struct TypeName<Wrap24> { static constexpr const char *value = "u24"; };
+
+// Small fast generator, seeded per unit of work so runs repeat exactly
+struct Random
+{
+  uint64_t state;
+
+  explicit Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+  uint64_t next()
+  {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  // Uniform over T, with extremes and values near them more often than chance
+  template<typename T>
+  T value()
+  {
+    uint64_t r = next();
+
+    switch (r & 7)
+    {
+    case 0: return IntegerLimits<T>::min + static_cast<T>((r >> 8) & 3);
+    case 1: return IntegerLimits<T>::max - static_cast<T>((r >> 8) & 3);
+    default: return static_cast<T>(r >> 16);
+    }
+  }
+
+  // low <= value <= high
+  template<typename T>
+  T between(T low, T high)
+  {
+    uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(high) - static_cast<int64_t>(low)) + 1;
+    uint64_t r = next();
+
+    switch (r & 7)
+    {
+    case 0: return low;
+    case 1: return high;
+    default: return static_cast<T>(static_cast<int64_t>(low) + static_cast<int64_t>((r >> 8) % span));
+    }
+  }
+
+  // Ascending pair, wide or narrow
+  template<typename T>
+  void segment(T &low, T &high)
+  {
+    do
+    {
+      low = value<T>();
+      high = (next() & 1) ? value<T>() : static_cast<T>(low + static_cast<T>(next() & 15));
+      if (high < low)
+      {
+        T swap = low;
+        low = high;
+        high = swap;
+      }
+    } while (low == high);
+  }
+};
+
+struct ErrorStats
+{
+  long double maxError = 0;
+  long double sumError = 0;
+  uint64_t count = 0;
+  uint64_t outOfRange = 0;
+  std::string worst;
+
+  void merge(const ErrorStats &other)
+  {
+    if (other.maxError > maxError)
+    {
+      maxError = other.maxError;
+      worst = other.worst;
+    }
+
+    sumError += other.sumError;
+    count += other.count;
+    outOfRange += other.outOfRange;
+  }
+};
+
+// Units of work are claimed in order by each thread, and each thread keeps its own stats
+template<typename Kernel>
+ErrorStats runParallel(const Kernel &kernel, unsigned threadCount)
+{
+  struct alignas(64) Partial
+  {
+    ErrorStats stats;
+  };
+
+  std::vector<Partial> partials(threadCount);
+  std::vector<std::thread> threads;
+  std::atomic<uint64_t> nextUnit(0);
+  uint64_t units = kernel.units();
+
+  for (unsigned t = 0; t < threadCount; t++)
+  {
+    threads.emplace_back([&, t]() {
+      for (uint64_t unit = nextUnit++; unit < units; unit = nextUnit++)
+      {
+        kernel.run(unit, partials[t].stats);
+      }
+    });
+  }
+
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  ErrorStats total;
+  for (const Partial &partial : partials)
+  {
+    total.merge(partial.stats);
+  }
+
+  return total;
+}
+
+template<typename T>
+std::string text(T value)
+{
+  return std::to_string(static_cast<long long>(value));
+}
+
+// Worst cases are only described when they're found, which is rare after the first few
+template<typename Describe>
+void record(ErrorStats &stats, long double error, bool inRange, Describe describe)
+{
+  stats.sumError += error;
+  stats.count++;
+
+  if (!inRange)
+  {
+    stats.outOfRange++;
+  }
+
+  if (error > stats.maxError)
+  {
+    stats.maxError = error;
+    stats.worst = describe();
+  }
+}
+
+// Values of T to build segments from: all of them if T is 8 bits, or a dense spread otherwise
+template<typename T>
+std::vector<T> sweepValues()
+{
+  std::vector<T> values;
+  int64_t min = IntegerLimits<T>::min;
+  int64_t max = IntegerLimits<T>::max;
+  uint64_t range = static_cast<uint64_t>(max - min);
+
+  if (range <= 0xFF)
+  {
+    for (int64_t v = min; v <= max; v++)
+    {
+      values.push_back(static_cast<T>(v));
+    }
+
+    return values;
+  }
+
+  // Evenly spread, plus the neighborhoods of the ends and of zero and the middle
+  for (int i = 0; i < 256; i++)
+  {
+    values.push_back(static_cast<T>(min + static_cast<int64_t>(range / 255 * i)));
+  }
+
+  const int64_t anchors[] = {min, 0, min + static_cast<int64_t>(range / 2), max};
+  for (int64_t anchor : anchors)
+  {
+    for (int64_t offset = -3; offset <= 3; offset++)
+    {
+      int64_t v = anchor + offset;
+      if (v >= min && v <= max)
+      {
+        values.push_back(static_cast<T>(v));
+      }
+    }
+  }
+
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+// Outputs to pair up: extremes, zero and midpoints
+template<typename T>
+std::vector<T> outputValues()
+{
+  int64_t min = IntegerLimits<T>::min;
+  int64_t max = IntegerLimits<T>::max;
+  int64_t candidates[] = {min, min + 1, min / 2, -1, 0, 1, max / 2, max / 2 + 1, max - 1, max};
+  std::vector<T> values;
+
+  for (int64_t v : candidates)
+  {
+    if (v >= min && v <= max)
+    {
+      values.push_back(static_cast<T>(v));
+    }
+  }
+
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+template<typename I, typename O>
+class LinearKernel
+{
+public:
+  // Inputs per segment when not all of them are swept
+  static constexpr int inputsPerSegment = 33;
+  static constexpr int randomOutputPairs = 32;
+
+  LinearKernel()
+    : _values(sweepValues<I>()), _outputs(outputValues<O>())
+  {
+    for (size_t low = 0; low < _values.size(); low++)
+    {
+      for (size_t high = low + 1; high < _values.size(); high++)
+      {
+        _segments.push_back(std::make_pair(_values[low], _values[high]));
+      }
+    }
+  }
+
+  std::string name() const
+  {
+    return std::string("interpolateLinear<") + TypeName<I>::value + ", " + TypeName<O>::value + ">";
+  }
+
+  uint64_t units() const
+  {
+    return _segments.size();
+  }
+
+  void run(uint64_t unit, ErrorStats &stats) const
+  {
+    I low = _segments[unit].first;
+    I high = _segments[unit].second;
+    Random random(unit);
+    uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(high) - static_cast<int64_t>(low));
+    bool everyInput = span < inputsPerSegment;
+
+    for (uint64_t step = 0; step <= (everyInput ? span : inputsPerSegment - 1); step++)
+    {
+      I input = everyInput
+        ? static_cast<I>(static_cast<int64_t>(low) + static_cast<int64_t>(step))
+        : static_cast<I>(static_cast<int64_t>(low) + static_cast<int64_t>(span * step / (inputsPerSegment - 1)));
+
+      for (O output0 : _outputs)
+      {
+        for (O output1 : _outputs)
+        {
+          check(input, low, high, output0, output1, stats);
+        }
+      }
+
+      for (int i = 0; i < randomOutputPairs; i++)
+      {
+        check(input, low, high, random.value<O>(), random.value<O>(), stats);
+      }
+    }
+  }
+
+private:
+  static void check(I input, I low, I high, O output0, O output1, ErrorStats &stats)
+  {
+    O result = interpolateLinear<I, O>(input, low, high, output0, output1);
+
+    long double expected = output0 + (static_cast<long double>(output1) - output0)
+      * (static_cast<long double>(input) - low) / (static_cast<long double>(high) - low);
+    long double error = fabsl(result - expected);
+    bool inRange = result >= std::min(output0, output1) - 1.0L && result <= std::max(output0, output1) + 1.0L;
+
+    record(stats, error, inRange, [&]() {
+      return "input " + text(input) + " in " + text(low) + ".." + text(high)
+        + ", outputs " + text(output0) + ".." + text(output1) + " -> " + text(result);
+    });
+  }
+
+  std::vector<I> _values;
+  std::vector<O> _outputs;
+  std::vector<std::pair<I, I>> _segments;
+};
+
+template<typename X, typename Y, typename Z>
+class BilinearKernel
+{
+public:
+  static constexpr uint64_t samplesPerUnit = 4096;
+
+  explicit BilinearKernel(uint64_t samples) : _units((samples + samplesPerUnit - 1) / samplesPerUnit) {}
+
+  std::string name() const
+  {
+    return std::string("interpolateBilinear<") + TypeName<X>::value + ", " + TypeName<Y>::value + ", "
+      + TypeName<Z>::value + ">";
+  }
+
+  uint64_t units() const
+  {
+    return _units;
+  }
+
+  void run(uint64_t unit, ErrorStats &stats) const
+  {
+    Random random(unit);
+
+    for (uint64_t i = 0; i < samplesPerUnit; i++)
+    {
+      X x0, x1;
+      Y y0, y1;
+      random.segment(x0, x1);
+      random.segment(y0, y1);
+      X x = random.between(x0, x1);
+      Y y = random.between(y0, y1);
+
+      Z z00 = random.value<Z>();
+      Z z10 = random.value<Z>();
+      Z z01 = random.value<Z>();
+      Z z11 = random.value<Z>();
+
+      // Flat and extreme corners are where overflows hide
+      if ((i & 15) == 0)
+      {
+        z00 = z11 = IntegerLimits<Z>::max;
+        z10 = z01 = (i & 16) ? IntegerLimits<Z>::min : IntegerLimits<Z>::max;
+      }
+
+      Z result = interpolateBilinear(x, x0, x1, y, y0, y1, z00, z10, z01, z11);
+
+      long double xWeight = (static_cast<long double>(x) - x0) / (static_cast<long double>(x1) - x0);
+      long double yWeight = (static_cast<long double>(y) - y0) / (static_cast<long double>(y1) - y0);
+      long double expected = (z00 * (1 - xWeight) + z10 * xWeight) * (1 - yWeight)
+        + (z01 * (1 - xWeight) + z11 * xWeight) * yWeight;
+      long double error = fabsl(result - expected);
+
+      long double low = std::min(std::min(z00, z10), std::min(z01, z11));
+      long double high = std::max(std::max(z00, z10), std::max(z01, z11));
+      bool inRange = result >= low - 1 && result <= high + 1;
+
+      record(stats, error, inRange, [&]() {
+        return "x " + text(x) + " in " + text(x0) + ".." + text(x1) + ", y " + text(y) + " in " + text(y0) + ".."
+          + text(y1) + ", z " + text(z00) + " " + text(z10) + " " + text(z01) + " " + text(z11) + " -> " + text(result);
+      });
+    }
+  }
+
+private:
+  uint64_t _units;
+};
+
+// The accumulator expSmooth() would use for valueBits + alphaFracBits, with AVR's 24-bit one emulated
+template<typename TVal, uint8_t alphaFracBits, uint8_t valueBits, typename TMul>
+class ExpSmoothKernel
+{
+public:
+  static constexpr uint32_t valueCount = 1ul << valueBits;
+
+  // Every value if there are few enough, otherwise a dense spread with the ends
+  static constexpr uint32_t sweepCount = valueCount <= 1024 ? valueCount : 1024;
+
+  std::string name() const
+  {
+    return std::string("expSmooth<") + std::to_string(alphaFracBits) + ", " + TypeName<TVal>::value + ", "
+      + std::to_string(valueBits) + "> with " + TypeName<TMul>::value;
+  }
+
+  uint64_t units() const
+  {
+    return sweepCount;
+  }
+
+  void run(uint64_t unit, ErrorStats &stats) const
+  {
+    TVal cur = value(unit);
+
+    for (uint32_t i = 0; i < sweepCount; i++)
+    {
+      TVal prev = value(i);
+
+      for (uint16_t alpha = 0; alpha <= (1u << alphaFracBits); alpha++)
+      {
+        uint8_t oneMinusAlpha = static_cast<uint8_t>((1u << alphaFracBits) - alpha);
+        TVal result = expSmoothImpl<alphaFracBits, TMul>(cur, prev, static_cast<uint8_t>(alpha), oneMinusAlpha);
+
+        long double expected = (static_cast<long double>(cur) * alpha + static_cast<long double>(prev) * oneMinusAlpha)
+          / (1u << alphaFracBits);
+        long double error = fabsl(result - expected);
+        bool inRange = result >= std::min(cur, prev) && result <= std::max(cur, prev);
+
+        record(stats, error, inRange, [&]() {
+          return "cur " + text(cur) + " prev " + text(prev) + " alpha " + text(alpha) + " -> " + text(result);
+        });
+      }
+    }
+  }
+
+private:
+  static TVal value(uint64_t index)
+  {
+    return static_cast<TVal>(static_cast<uint64_t>(valueCount - 1) * index / (sweepCount - 1));
+  }
+};
+
+class AlphaFromTimeKernel
+{
+public:
+  std::string name() const
+  {
+    return "calculateAlphaFixedFromTime";
+  }
+
+  // Time constants spread log-uniformly over 32 bits
+  uint64_t units() const
+  {
+    return 4096;
+  }
+
+  void run(uint64_t unit, ErrorStats &stats) const
+  {
+    uint32_t timeConstant = static_cast<uint32_t>(ldexp(1.0, static_cast<int>(unit * 32 / units())) * (1.0 + (unit % 128) / 128.0));
+    if (timeConstant == 0)
+    {
+      timeConstant = 1;
+    }
+
+    for (uint32_t i = 0; i <= 1024; i++)
+    {
+      // Up to 10 time constants, past the end of the table
+      uint32_t deltaTime = static_cast<uint32_t>(static_cast<uint64_t>(timeConstant) * 10 * i / 1024);
+
+      for (uint8_t fractionBits = 0; fractionBits <= 7; fractionBits++)
+      {
+        uint8_t alpha = calculateAlphaFixedFromTime(deltaTime, timeConstant, fractionBits);
+        long double expected = (1 - expl(-static_cast<long double>(deltaTime) / timeConstant)) * (1u << fractionBits);
+        long double error = fabsl(alpha - expected);
+        bool inRange = alpha <= (1u << fractionBits);
+
+        record(stats, error, inRange, [&]() {
+          return "deltaTime " + text(deltaTime) + " timeConstant " + text(timeConstant) + " bits "
+            + text(fractionBits) + " -> " + text(alpha);
+        });
+      }
+    }
+  }
+};
+
+struct Options
+{
+  unsigned threads;
+  uint64_t samples;
+  const char *filter;
+};
+
+static double secondsNow()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+template<typename Kernel>
+void verify(const Kernel &kernel, const Options &options, uint64_t &outOfRange)
+{
+  std::string name = kernel.name();
+
+  if (options.filter && name.find(options.filter) == std::string::npos)
+  {
+    return;
+  }
+
+  double start = secondsNow();
+  ErrorStats stats = runParallel(kernel, options.threads);
+  double elapsed = secondsNow() - start;
+
+  printf("%-52s %12llu  max %-9.4Lg mean %-9.4Lg out of range %-8llu %6.1f s\n", name.c_str(),
+    static_cast<unsigned long long>(stats.count), stats.maxError, stats.count ? stats.sumError / stats.count : 0.0L,
+    static_cast<unsigned long long>(stats.outOfRange), elapsed);
+  printf("  worst: %s\n", stats.worst.c_str());
+  fflush(stdout);
+
+  outOfRange += stats.outOfRange;
+}
+
+int main(int argc, char **argv)
+{
+  Options options = {std::thread::hardware_concurrency(), 1ull << 24, nullptr};
+
+  for (int arg = 1; arg < argc; arg++)
+  {
+    if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+    {
+      options.threads = atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--samples") == 0 && arg + 1 < argc)
+    {
+      options.samples = strtoull(argv[++arg], nullptr, 10);
+    }
+    else if (argv[arg][0] != '-' && !options.filter)
+    {
+      options.filter = argv[arg];
+    }
+    else
+    {
+      fprintf(stderr, "usage: verify [--threads n] [--samples n] [filter]\n");
+      return 2;
+    }
+  }
+
+  if (options.threads == 0)
+  {
+    options.threads = 1;
+  }
+
+  uint64_t outOfRange = 0;
+
+  verify(LinearKernel<uint8_t, uint8_t>(), options, outOfRange);
+  verify(LinearKernel<uint8_t, uint16_t>(), options, outOfRange);
+  verify(LinearKernel<uint8_t, uint32_t>(), options, outOfRange);
+  verify(LinearKernel<uint16_t, uint8_t>(), options, outOfRange);
+  verify(LinearKernel<uint16_t, uint16_t>(), options, outOfRange);
+  verify(LinearKernel<uint16_t, uint32_t>(), options, outOfRange);
+  verify(LinearKernel<uint32_t, uint8_t>(), options, outOfRange);
+  verify(LinearKernel<uint32_t, uint16_t>(), options, outOfRange);
+  verify(LinearKernel<uint32_t, uint32_t>(), options, outOfRange);
+  verify(LinearKernel<uint8_t, int8_t>(), options, outOfRange);
+  verify(LinearKernel<uint8_t, int16_t>(), options, outOfRange);
+  verify(LinearKernel<uint16_t, int8_t>(), options, outOfRange);
+  verify(LinearKernel<uint16_t, int16_t>(), options, outOfRange);
+  verify(LinearKernel<int8_t, int8_t>(), options, outOfRange);
+  verify(LinearKernel<int8_t, int16_t>(), options, outOfRange);
+  verify(LinearKernel<int16_t, int8_t>(), options, outOfRange);
+  verify(LinearKernel<int16_t, int16_t>(), options, outOfRange);
+
+  verify(BilinearKernel<uint8_t, uint8_t, uint8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint8_t, uint16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint16_t, uint8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint16_t, uint16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint8_t, uint8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint8_t, uint16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint16_t, uint8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint16_t, uint16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint8_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint8_t, int16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint16_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint8_t, uint16_t, int16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint8_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint8_t, int16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint16_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<uint16_t, uint16_t, int16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<int8_t, int8_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<int8_t, int8_t, int16_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<int16_t, int16_t, int8_t>(options.samples), options, outOfRange);
+  verify(BilinearKernel<int16_t, int16_t, int16_t>(options.samples), options, outOfRange);
+
+  // What expSmooth() picks: 16 bits up to 16, __uint24 on AVR up to 24, then 32
+  verify(ExpSmoothKernel<uint8_t, 6, 2, uint16_t>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint16_t, 6, 10, uint16_t>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint16_t, 6, 16, Wrap24>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint16_t, 7, 16, Wrap24>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint16_t, 6, 16, uint32_t>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint32_t, 6, 26, uint32_t>(), options, outOfRange);
+  verify(ExpSmoothKernel<uint32_t, 7, 25, uint32_t>(), options, outOfRange);
+
+  verify(AlphaFromTimeKernel(), options, outOfRange);
+
+  return outOfRange > 0 ? 1 : 0;
+}